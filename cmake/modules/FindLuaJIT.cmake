@@ -0,0 +1,44 @@
+# - Try to find LuaJIT
+# Once done this will define
+#
+#  LUAJIT_FOUND - system has LuaJIT
+#  LUA_INCLUDE_DIR - the LuaJIT include directory
+#  LUA_LIBRARIES - Link these to use LuaJIT
+#
+# The variables are named like the ones of FindLua51, LuaJIT implements
+# the Lua 5.1 API and replaces it.
+#
+# Redistribution and use is allowed according to the terms of the BSD license.
+# For details see the accompanying COPYING-CMAKE-SCRIPTS file.
+
+if ( LUA_INCLUDE_DIR AND LUA_LIBRARIES )
+   # in cache already
+   SET(LuaJIT_FIND_QUIETLY TRUE)
+endif ( LUA_INCLUDE_DIR AND LUA_LIBRARIES )
+
+# use pkg-config to get the directories and then use these values
+# in the FIND_PATH() and FIND_LIBRARY() calls
+if( NOT WIN32 )
+  find_package(PkgConfig)
+
+  pkg_check_modules(PC_LUAJIT luajit)
+endif( NOT WIN32 )
+
+FIND_PATH(LUA_INCLUDE_DIR NAMES luajit.h
+  PATHS
+  ${PC_LUAJIT_INCLUDEDIR}
+  ${PC_LUAJIT_INCLUDE_DIRS}
+  PATH_SUFFIXES luajit-2.1 luajit-2.0
+)
+
+FIND_LIBRARY(LUA_LIBRARIES NAMES luajit-5.1 luajit lua51
+  PATHS
+  ${PC_LUAJIT_LIBDIR}
+  ${PC_LUAJIT_LIBRARY_DIRS}
+)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LuaJIT DEFAULT_MSG LUA_INCLUDE_DIR LUA_LIBRARIES )
+
+# show the LUA_INCLUDE_DIR and LUA_LIBRARIES variables only in the advanced view
+MARK_AS_ADVANCED(LUA_INCLUDE_DIR LUA_LIBRARIES )
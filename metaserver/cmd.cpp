@@ -534,20 +534,20 @@ static void ParseBuffer(Session *session)
 }
 
 /**
-**  Parse all session buffers
+**  Parse the buffers of the sessions which received data
 */
 int UpdateParser(void)
 {
-	Session *session;
 	int len;
 	char *next;
 
-	if (!Pool || !Pool->First) {
-		// No connections
+	if (!Pool) {
 		return 0;
 	}
 
-	for (session = Pool->First; session; session = session->Next) {
+	for (size_t i = 0; i != Pool->Ready.size(); ++i) {
+		Session *session = Pool->Ready[i];
+
 		// Confirm full message.
 		while ((next = strpbrk(session->Buffer, "\r\n"))) {
 			*next++ = '\0';
@@ -562,8 +562,8 @@ int UpdateParser(void)
 			memmove(session->Buffer, next, sizeof(session->Buffer) - len);
 			session->Buffer[sizeof(session->Buffer) - len] = '\0';
 		}
-
 	}
+	Pool->Ready.clear();
 
 	if (strlen(UDPBuffer)) {
 		// If this is a server, we'll note its external data. When clients join,
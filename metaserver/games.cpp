@@ -37,6 +37,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <map>
+
 #include "stratagus.h"
 #include "games.h"
 #include "netdriver.h"
@@ -46,6 +48,7 @@
 ----------------------------------------------------------------------------*/
 
 static GameData *Games;
+static std::map<int, GameData *> GamesByID;  /// Games indexed by their ID
 int GameID;
 
 /*----------------------------------------------------------------------------
@@ -78,6 +81,8 @@ void CreateGame(Session *session, char *description, char *map,
 	game->Sessions[0] = session;
 	game->ID = GameID++;
 	game->Started = 0;
+	game->UDPHost = 0;
+	game->UDPPort = 0;
 
 	game->GameName = session->UserData.GameName;
 	game->Version = session->UserData.Version;
@@ -88,6 +93,7 @@ void CreateGame(Session *session, char *description, char *map,
 	game->Next = Games;
 	game->Prev = NULL;
 	Games = game;
+	GamesByID[game->ID] = game;
 
 	session->Game = game;
 }
@@ -115,6 +121,7 @@ int CancelGame(Session *session)
 	if (Games == game) {
 		Games = game->Next;
 	}
+	GamesByID.erase(game->ID);
 
 	for (i = 0; i < game->NumSessions; ++i) {
 		game->Sessions[i]->Game = NULL;
@@ -148,16 +155,11 @@ int JoinGame(Session *session, int id, char *password, unsigned long *host, int
 		return -1; // Already in a game
 	}
 
-	game = Games;
-	while (game) {
-		if (game->ID == id) {
-			break;
-		}
-		game = game->Next;
-	}
-	if (!game) {
+	std::map<int, GameData *>::iterator it = GamesByID.find(id);
+	if (it == GamesByID.end()) {
 		return -2; // ID not found
 	}
+	game = it->second;
 
 	if (game->Password[0]) {
 		if (!password || strcmp(game->Password, password)) {
@@ -246,7 +248,7 @@ void ListGames(Session *session)
 
 int FillinUDPInfo(unsigned long udphost, int udpport, char* ip, char* port) {
 	GameData *game;
-	for (game = Games; game; game = Games->Next) {
+	for (game = Games; game; game = game->Next) {
 		if (!strcmp(game->IP, ip) && !strcmp(game->Port, port)) {
 			if (!game->UDPHost && !game->UDPPort) {
 				game->UDPHost = udphost;
@@ -36,6 +36,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <signal.h>
+
+#include <algorithm>
 
 #include "SDL.h"
 
@@ -159,11 +162,13 @@ int getopt(int argc, char *const *argv, const char *opts)
 
 /**
 **  Main loop
+**
+**  Requests are handled as soon as they arrive, the polling delay is only
+**  the longest time to wait for them.
 */
 static void MainLoop(void)
 {
-	Uint32 ticks[2];
-	int delay;
+	const int timeout = std::min(Server.PollingDelay, 1000);
 	int done;
 
 	//
@@ -171,30 +176,11 @@ static void MainLoop(void)
 	//
 	done = 0;
 	while (!done) {
-		ticks[0] = SDL_GetTicks();
-
 		//
 		// Update sessions and buffers.
 		//
-		UpdateSessions();
+		UpdateSessions(timeout);
 		UpdateParser();
-
-		ticks[1] = SDL_GetTicks();
-
-		//
-		// Idle out the remainder of this loop.
-		//
-		if ((int)(ticks[1] - ticks[0]) > Server.PollingDelay) {
-			delay = 0;
-		} else {
-			delay = Server.PollingDelay - (ticks[1] - ticks[0]);
-		}
-
-		if (delay > 2000) {
-			delay = 2000;
-		}
-
-		SDL_Delay(delay);
 	}
 
 }
@@ -257,7 +243,7 @@ int main(int argc, char **argv)
 					   "-p\tEnable debug print\n"
 					   "-m\tMax connections\n"
 					   "-i\tIdle timeout\n"
-					   "-d\tPolling delay\n");
+					   "-d\tLongest wait for requests in ms\n");
 				exit(0);
 				break;
 			case '?':
@@ -287,6 +273,10 @@ int main(int argc, char **argv)
 		exit(status);
 	}
 	atexit(ServerQuit);
+#ifdef SIGPIPE
+	// Closed connections show up as send errors.
+	signal(SIGPIPE, SIG_IGN);
+#endif
 
 	printf("Stratagus Metaserver Initialized on port %d.\n", Server.Port);
 
@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <algorithm>
 #ifndef _MSC_VER
 #include <errno.h>
 #endif
@@ -45,6 +46,11 @@
 #include "netdriver.h"
 #include "net_lowlevel.h"
 
+#ifdef USE_LINUX
+#include <sys/epoll.h>
+#define USE_EPOLL
+#endif
+
 /*----------------------------------------------------------------------------
 --  Defines
 ----------------------------------------------------------------------------*/
@@ -93,6 +99,10 @@
 
 static Socket MasterSocket;
 static Socket HolePunchSocket;
+#ifdef USE_EPOLL
+static int EpollFd = -1;                 /// Waits for all sockets
+#endif
+static time_t LastKickIdlers;            /// Time idle sessions were last checked
 
 SessionPool *Pool;
 ServerStruct Server;
@@ -104,6 +114,62 @@ int UDPPort = 0;
 --  Functions
 ----------------------------------------------------------------------------*/
 
+/**
+**  Check if the last socket call failed only because the socket is full
+**  or empty.
+*/
+static bool WouldBlock()
+{
+#ifdef USE_WINSOCK
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EWOULDBLOCK || errno == EAGAIN;
+#endif
+}
+
+#ifdef USE_EPOLL
+/**
+**  Register a socket for events, data is passed back with the events.
+*/
+static int WatchSocket(int op, Socket socket, void *data, bool output)
+{
+	struct epoll_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | (output ? (uint32_t)EPOLLOUT : 0u);
+	event.data.ptr = data;
+	return epoll_ctl(EpollFd, op, socket, &event);
+}
+#endif
+
+/**
+**  Send the pending output of a session, as much as the socket takes.
+**
+**  @return  false if the connection failed.
+*/
+static bool FlushSession(Session *session)
+{
+	while (!session->Output.empty()) {
+		const int n = NetSendTCP(session->Sock, session->Output.data(), session->Output.size());
+		if (n < 0 && WouldBlock()) {
+			break;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		session->Output.erase(0, n);
+	}
+#ifdef USE_EPOLL
+	// Wait until the socket takes more only while there is output.
+	const bool watchOutput = !session->Output.empty();
+	if (watchOutput != session->OutputWatched) {
+		session->OutputWatched = watchOutput;
+		WatchSocket(EPOLL_CTL_MOD, session->Sock, session, watchOutput);
+	}
+#endif
+	return true;
+}
+
 /**
 **  Send a message to a session
 **
@@ -112,7 +178,11 @@ int UDPPort = 0;
 */
 void Send(Session *session, const char *msg)
 {
-	NetSendTCP(session->Sock, msg, strlen(msg));
+	session->Output += msg;
+	if (session->Output.size() == strlen(msg)) {
+		// Send errors show up as read errors.
+		FlushSession(session);
+	}
 }
 
 /**
@@ -170,6 +240,19 @@ int ServerInit(int port)
 		goto error;
 	}
 
+#ifdef USE_EPOLL
+	if ((EpollFd = epoll_create(1)) == -1
+		|| WatchSocket(EPOLL_CTL_ADD, MasterSocket, &MasterSocket, false) == -1
+		|| WatchSocket(EPOLL_CTL_ADD, HolePunchSocket, &HolePunchSocket, false) == -1) {
+		fprintf(stderr, "epoll failed\n");
+		code = -7;
+		goto error;
+	}
+#else
+	Pool->Sockets->AddSocket(MasterSocket);
+	Pool->Sockets->AddSocket(HolePunchSocket);
+#endif
+
 	Pool->First = NULL;
 	Pool->Last = NULL;
 	Pool->Count = 0;
@@ -203,6 +286,9 @@ void ServerQuit(void)
 		delete Pool->Sockets;
 		delete Pool;
 	}
+#ifdef USE_EPOLL
+	close(EpollFd);
+#endif
 
 	NetExit();
 }
@@ -225,8 +311,12 @@ static int IdleSeconds(Session *session)
 static int KillSession(Session *session)
 {
 	DebugPrint("Closing connection from '%s'\n" _C_ session->AddrData.IPStr);
-	NetCloseTCP(session->Sock);
+#ifdef USE_EPOLL
+	epoll_ctl(EpollFd, EPOLL_CTL_DEL, session->Sock, NULL);
+#else
 	Pool->Sockets->DelSocket(session->Sock);
+#endif
+	NetCloseTCP(session->Sock);
 	UNLINK(Pool->First, session, Pool->Last, Pool->Count);
 	delete session;
 	return 0;
@@ -263,9 +353,21 @@ static void AcceptConnections()
 		new_session->AddrData.Port = port;
 		DebugPrint("New connection from '%s'\n" _C_ new_session->AddrData.IPStr);
 
+		NetSetNonBlocking(new_socket);
 		LINK(Pool->First, new_session, Pool->Last, Pool->Count);
+#ifdef USE_EPOLL
+		WatchSocket(EPOLL_CTL_ADD, new_socket, new_session, false);
+#else
 		Pool->Sockets->AddSocket(new_socket);
+#endif
 	}
+}
+
+/**
+**  Receive the hole punching message of a game server.
+*/
+static void ReadHolePunch()
+{
 	if (NetSocketReady(HolePunchSocket, 0)) {
 		NetRecvUDP(HolePunchSocket, UDPBuffer, sizeof(UDPBuffer), &UDPHost, &UDPPort);
 		DebugPrint("New UDP %s (%d %d)\n" _C_ UDPBuffer);
@@ -274,74 +376,134 @@ static void AcceptConnections()
 
 /**
 **  Kick idlers
+**
+**  The longest idle sessions are first in the pool.
 */
 static void KickIdlers(void)
 {
-	Session *session;
-	Session *next;
+	const time_t now = time(0);
 
-	for (session = Pool->First; session; ) {
-		next = session->Next;
-		if (IdleSeconds(session) > Server.IdleTimeout) {
-			DebugPrint("Kicking idler '%s'\n" _C_ session->AddrData.IPStr);
-			KillSession(session);
-		}
-		session = next;
+	if (now == LastKickIdlers) {
+		return;
+	}
+	LastKickIdlers = now;
+	while (Pool->First && IdleSeconds(Pool->First) > Server.IdleTimeout) {
+		DebugPrint("Kicking idler '%s'\n" _C_ Pool->First->AddrData.IPStr);
+		KillSession(Pool->First);
 	}
 }
 
 /**
-**  Read data
+**  Read the data of a session and queue it for the parser.
 */
-static int ReadData()
+static void ReadSession(Session *session)
 {
-	int result = Pool->Sockets->Select(0);
+	const int clen = strlen(session->Buffer);
+	const int result = NetRecvTCP(session->Sock, session->Buffer + clen,
+								  sizeof(session->Buffer) - clen);
 
-	if (result == 0) {
-		// No sockets ready
-		return 0;
+	if (result < 0) {
+		KillSession(session);
+		return;
 	}
+	if (result == 0) { // nothing there after all
+		return;
+	}
+	session->Buffer[clen + result] = '\0';
+
+	// Move the session behind the others, it is the least idle now.
+	session->Idle = time(0);
+	UNLINK(Pool->First, session, Pool->Last, Pool->Count);
+	session->Next = session->Prev = NULL;
+	LINK(Pool->First, session, Pool->Last, Pool->Count);
+
+	Pool->Ready.push_back(session);
+}
+
+#ifdef USE_EPOLL
+
+/**
+**  Wait for events and handle them
+*/
+static int HandleEvents(int timeout)
+{
+	struct epoll_event events[256];
+	const int n = epoll_wait(EpollFd, events, 256, timeout);
+
+	if (n < 0) {
+		return errno == EINTR ? 0 : -1;
+	}
+	for (int i = 0; i < n; ++i) {
+		void *data = events[i].data.ptr;
+
+		if (data == &MasterSocket) {
+			AcceptConnections();
+		} else if (data == &HolePunchSocket) {
+			ReadHolePunch();
+		} else {
+			Session *session = static_cast<Session *>(data);
+
+			if ((events[i].events & EPOLLOUT) && !FlushSession(session)) {
+				KillSession(session);
+			} else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+				ReadSession(session);
+			}
+		}
+	}
+	return 0;
+}
+
+#else
+
+/**
+**  Wait for events and handle them
+*/
+static int HandleEvents(int timeout)
+{
+	// Without write events, retry the pending output soon.
+	for (Session *session = Pool->First; session; session = session->Next) {
+		if (!session->Output.empty()) {
+			timeout = std::min(timeout, 10);
+			break;
+		}
+	}
+	const int result = Pool->Sockets->Select(timeout);
+
 	if (result == -1) {
 		// FIXME: print error message
 		return -1;
 	}
-
-	// ready sockets
 	for (Session *session = Pool->First; session; ) {
 		Session *next = session->Next;
-		if (Pool->Sockets->HasDataToRead(session->Sock)) {
-			// socket ready
-			session->Idle = time(0);
-			int clen = strlen(session->Buffer);
-			result = NetRecvTCP(session->Sock, session->Buffer + clen,
-				sizeof(session->Buffer) - clen);
-			if (result < 0) {
-				KillSession(session);
-			} else {
-				session->Buffer[clen + result] = '\0';
-			}
+		if (!FlushSession(session)) {
+			KillSession(session);
+		} else if (result > 0 && Pool->Sockets->HasDataToRead(session->Sock)) {
+			ReadSession(session);
 		}
 		session = next;
 	}
-
+	if (result > 0 && Pool->Sockets->HasDataToRead(MasterSocket)) {
+		AcceptConnections();
+	}
+	if (result > 0 && Pool->Sockets->HasDataToRead(HolePunchSocket)) {
+		ReadHolePunch();
+	}
 	return 0;
 }
 
+#endif
+
 /**
 **  Accepts new connections, receives data, manages buffers,
+**
+**  @param timeout  Time in ms to wait for network events.
 */
-int UpdateSessions(void)
+int UpdateSessions(int timeout)
 {
-	AcceptConnections();
-
-	if (!Pool->First) {
-		// No connections
-		return 0;
-	}
+	const int result = HandleEvents(timeout);
 
 	KickIdlers();
-
-	return ReadData();
+	return result;
 }
 
 //@}
@@ -37,6 +37,8 @@
 ----------------------------------------------------------------------------*/
 
 #include <time.h>
+#include <string>
+#include <vector>
 #include "net_lowlevel.h"
 
 /*----------------------------------------------------------------------------
@@ -83,7 +85,7 @@ extern ServerStruct Server;
 */
 class Session {
 public:
-	Session() : Next(NULL), Prev(NULL), Idle(0), Sock(0), Game(NULL)
+	Session() : Next(NULL), Prev(NULL), OutputWatched(false), Idle(0), Sock(0), Game(NULL)
 	{
 		Buffer[0] = '\0';
 		AddrData.Host = 0;
@@ -99,6 +101,8 @@ public:
 	Session *Prev;
 
 	char Buffer[1024];
+	std::string Output;       /// Data not yet sent, the socket was full
+	bool OutputWatched;       /// Waiting until the socket takes more output
 	time_t Idle;
 
 	Socket Sock;
@@ -121,6 +125,8 @@ public:
 
 /**
 **  Global session tracking.
+**
+**  The sessions are ordered by their last activity, the longest idle first.
 */
 class SessionPool {
 public:
@@ -131,6 +137,7 @@ public:
 	int Count;
 
 	SocketSet *Sockets;
+	std::vector<Session *> Ready;  /// Sessions which received data since the last parse
 };
 
 /// external reference to session tracking.
@@ -147,7 +154,7 @@ extern void Send(Session *session, const char *msg);
 
 extern int ServerInit(int port);
 extern void ServerQuit(void);
-extern int UpdateSessions(void);
+extern int UpdateSessions(int timeout);
 
 //@}
 
@@ -356,6 +356,7 @@ bool COrder_Build::StartBuilding(CUnit &unit, CUnit &ontop)
 
 	// HACK: the building is not ready yet
 	build->Player->UnitTypesCount[type.Slot]--;
+	++PlayerUnitsChangeCount;
 	if (build->Active) {
 		build->Player->UnitTypesAiActiveCount[type.Slot]--;
 	}
@@ -155,6 +155,7 @@ static void Finish(COrder_Built &order, CUnit &unit)
 
 	// HACK: the building is ready now
 	player.UnitTypesCount[type.Slot]++;
+	++PlayerUnitsChangeCount;
 	if (unit.Active) {
 		player.UnitTypesAiActiveCount[type.Slot]++;
 	}
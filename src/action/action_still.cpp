@@ -197,10 +197,12 @@ static bool MoveRandomly(CUnit &unit)
 bool AutoCast(CUnit &unit)
 {
 	if (unit.AutoCastSpell && !unit.Removed) { // Removed units can't cast any spells, from bunker)
+		AutoCastArea area(unit);
+
 		for (unsigned int i = 0; i < SpellTypeTable.size(); ++i) {
 			if (unit.AutoCastSpell[i]
 				&& (SpellTypeTable[i]->AutoCast || SpellTypeTable[i]->AICast)
-				&& AutoCastSpell(unit, *SpellTypeTable[i])) {
+				&& AutoCastSpell(unit, *SpellTypeTable[i], &area)) {
 				return true;
 			}
 		}
@@ -300,10 +302,12 @@ bool COrder_Still::AutoAttackStand(CUnit &unit)
 bool COrder_Still::AutoCastStand(CUnit &unit)
 {
 	if (!unit.Removed) { // Removed units can't cast any spells, from bunker)
+		AutoCastArea area(unit);
+
 		for (unsigned int i = 0; i < SpellTypeTable.size(); ++i) {
 			if (unit.AutoCastSpell[i]
 				&& (SpellTypeTable[i]->AutoCast || SpellTypeTable[i]->AICast)
-				&& AutoCastSpell(unit, *SpellTypeTable[i])) {
+				&& AutoCastSpell(unit, *SpellTypeTable[i], &area)) {
 				return true;
 			}
 		}
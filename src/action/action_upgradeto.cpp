@@ -106,6 +106,7 @@ static int TransformUnitIntoType(CUnit &unit, const CUnitType &newtype)
 	CPlayer &player = *unit.Player;
 	player.UnitTypesCount[oldtype.Slot]--;
 	player.UnitTypesCount[newtype.Slot]++;
+	++PlayerUnitsChangeCount;
 	if (unit.Active) {
 		player.UnitTypesAiActiveCount[oldtype.Slot]--;
 		player.UnitTypesAiActiveCount[newtype.Slot]++;
@@ -66,6 +66,7 @@
 #include "missile.h"
 #include "pathfinder.h"
 #include "player.h"
+#include "profile.h"
 #include "script.h"
 #include "spells.h"
 #include "unit.h"
@@ -79,6 +80,8 @@
 
 unsigned SyncHash; /// Hash calculated to find sync failures
 
+static const int ProfileUnitCallbacks = ProfileSection("unit-callbacks"); /// Profiled Lua callbacks of the units
+
 
 /*----------------------------------------------------------------------------
 --  Functions
@@ -413,6 +416,8 @@ static void UnitActionsEachSecond(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 
 		// OnEachSecond callback
 		if (unit.Type->OnEachSecond  && unit.IsUnusable(false) == false) {
+			CProfileScope scope(ProfileUnitCallbacks, unit.Player->Index);
+
 			unit.Type->OnEachSecond->pushPreamble();
 			unit.Type->OnEachSecond->pushInteger(UnitNumber(unit));
 			unit.Type->OnEachSecond->run();
@@ -476,6 +481,8 @@ static void UnitActionsEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 
 		// OnEachCycle callback
 		if (unit.Type->OnEachCycle && unit.IsUnusable(false) == false) {
+			CProfileScope scope(ProfileUnitCallbacks, unit.Player->Index);
+
 			unit.Type->OnEachCycle->pushPreamble();
 			unit.Type->OnEachCycle->pushInteger(UnitNumber(unit));
 			unit.Type->OnEachCycle->run();
@@ -504,6 +511,44 @@ static void UnitActionsEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 	}
 }
 
+/**
+**  Call the OnEachCycleBatch callbacks, once for each unit type with
+**  the slots of all its usable units in unit table order.
+*/
+template <typename UNITP_ITERATOR>
+static void UnitTypesBatchEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+{
+	static std::vector<std::vector<int> > slots; // slots of the units by type, kept to reuse the memory
+	bool found = false;
+
+	for (UNITP_ITERATOR it = begin; it != end; ++it) {
+		const CUnit &unit = **it;
+
+		if (unit.Destroyed || !unit.Type->OnEachCycleBatch || unit.IsUnusable(false)) {
+			continue;
+		}
+		if (slots.size() <= (size_t)unit.Type->Slot) {
+			slots.resize(UnitTypes.size());
+		}
+		slots[unit.Type->Slot].push_back(UnitNumber(unit));
+		found = true;
+	}
+	if (!found) {
+		return;
+	}
+	CProfileScope scope(ProfileUnitCallbacks, -1);
+	for (size_t i = 0; i != slots.size(); ++i) {
+		if (slots[i].empty()) {
+			continue;
+		}
+		LuaCallback &callback = *UnitTypes[i]->OnEachCycleBatch;
+
+		callback.pushPreamble();
+		callback.pushIntegers(slots[i]);
+		callback.run();
+		slots[i].clear();
+	}
+}
 
 /**
 **  Update the actions of all units each game cycle/second.
@@ -518,6 +563,8 @@ void UnitActions()
 	if (isASecondCycle) {
 		UnitActionsEachSecond(table.begin(), table.end());
 	}
+	// Batched callbacks see the units before any of them acts
+	UnitTypesBatchEachCycle(table.begin(), table.end());
 	// Do all actions
 	UnitActionsEachCycle(table.begin(), table.end());
 }
@@ -149,6 +149,7 @@
 #include "map.h"
 #include "pathfinder.h"
 #include "player.h"
+#include "profile.h"
 #include "script.h"
 #include "unit.h"
 #include "unit_manager.h"
@@ -355,6 +356,7 @@ static void SaveAiPlayer(CFile &file, int plynr, const PlayerAi &ai)
 	}
 	file.printf("  \"last-exploration-cycle\", %lu,\n", ai.LastExplorationGameCycle);
 	file.printf("  \"last-can-not-move-cycle\", %lu,\n", ai.LastCanNotMoveGameCycle);
+	file.printf("  \"second-phase\", %d,\n", ai.SecondPhase);
 	file.printf("  \"unit-type\", {");
 	const size_t unitTypeRequestsCount = ai.UnitTypeRequests.size();
 	for (size_t i = 0; i != unitTypeRequestsCount; ++i) {
@@ -996,19 +998,86 @@ void AiResearchComplete(CUnit &unit, const CUpgrade *what)
 	// FIXME: upgrading knights -> paladins, must rebuild lists!
 }
 
+/// Profiled sections of the AI
+static const int ProfileAiScript = ProfileSection("ai-script");
+static const int ProfileAiCheckUnits = ProfileSection("ai-check-units");
+static const int ProfileAiResources = ProfileSection("ai-resources");
+static const int ProfileAiForces = ProfileSection("ai-forces");
+static const int ProfileAiMagic = ProfileSection("ai-magic");
+static const int ProfileAiExplorers = ProfileSection("ai-explorers");
+
+/**
+**  Run one phase of the work the AI does each second.
+**
+**  @param phase  Phase to run.
+*/
+static void AiRunPhase(int phase)
+{
+	const int player = AiPlayer->Player->Index;
+
+	switch (phase) {
+		case AiPhaseScript: {
+			//  Advance script
+			{
+				CProfileScope scope(ProfileAiScript, player);
+				AiExecuteScript();
+			}
+
+			//  Look if everything is fine.
+			CProfileScope scope(ProfileAiCheckUnits, player);
+			AiCheckUnits();
+			break;
+		}
+		case AiPhaseResources: {
+			//  Handle the resource manager.
+			CProfileScope scope(ProfileAiResources, player);
+			AiResourceManager();
+			break;
+		}
+		case AiPhaseForces: {
+			//  Handle the force manager.
+			CProfileScope scope(ProfileAiForces, player);
+			AiForceManager();
+			break;
+		}
+		case AiPhaseMagic: {
+			//  Check for magic actions.
+			{
+				CProfileScope scope(ProfileAiMagic, player);
+				AiCheckMagic();
+			}
+
+			// At most 1 explorer each 5 seconds
+			if (GameCycle > AiPlayer->LastExplorationGameCycle + 5 * CYCLES_PER_SECOND) {
+				CProfileScope scope(ProfileAiExplorers, player);
+				AiSendExplorers();
+			}
+			break;
+		}
+	}
+}
+
 /**
 **  This is called for each player, each game cycle.
 **
+**  Runs the next pending phase of the last AI second.
+**
 **  @param player  The player structure pointer.
 */
 void AiEachCycle(CPlayer &player)
 {
 	AiPlayer = player.Ai;
+	if (!AiPlayer || AiPlayer->SecondPhase >= AiPhaseCount) {
+		return;
+	}
+	AiRunPhase(AiPlayer->SecondPhase++);
 }
 
 /**
 **  This is called for each player each second.
 **
+**  Runs the first phase, the others follow in the next game cycles.
+**
 **  @param player  The player structure pointer.
 */
 void AiEachSecond(CPlayer &player)
@@ -1020,25 +1089,12 @@ void AiEachSecond(CPlayer &player)
 	}
 #endif
 
-	//  Advance script
-	AiExecuteScript();
-
-	//  Look if everything is fine.
-	AiCheckUnits();
-
-	//  Handle the resource manager.
-	AiResourceManager();
-
-	//  Handle the force manager.
-	AiForceManager();
-
-	//  Check for magic actions.
-	AiCheckMagic();
-
-	// At most 1 explorer each 5 seconds
-	if (GameCycle > AiPlayer->LastExplorationGameCycle + 5 * CYCLES_PER_SECOND) {
-		AiSendExplorers();
+	// Finish the phases of the last second, if they are still pending.
+	while (AiPlayer->SecondPhase < AiPhaseCount) {
+		AiRunPhase(AiPlayer->SecondPhase++);
 	}
+	AiRunPhase(AiPhaseScript);
+	AiPlayer->SecondPhase = AiPhaseScript + 1;
 }
 
 //@}
@@ -141,6 +141,83 @@ static bool AiCheckSurrounding(const CUnit &worker, const CUnitType &type, const
 	return obstacleCount == 0;
 }
 
+/**
+**  Results of the building place checks of the tiles.
+**
+**  The checks of a tile don't depend on the worker, unless the worker
+**  stands near the tile. So all searches of a player for the same
+**  building type share them, as long as the game cycle and the map
+**  don't change.
+*/
+class BuildingPlaceCache
+{
+public:
+	enum PlaceState {
+		PlaceUnknown,   /// Not checked yet
+		PlaceNo,        /// The building can't be built here
+		PlaceBlocking,  /// The building would block the way
+		PlaceBackup,    /// Usable if no free place is found
+		PlaceFree       /// The surrounding is free
+	};
+
+	BuildingPlaceCache() : Cycle(0), ChangeCount(0), Player(NULL), Type(NULL), Range(0) {}
+
+	void Prepare(const CPlayer &player, const CUnitType &type);
+	bool IsSharedWith(const CUnit &worker, const Vec2i &pos) const;
+	PlaceState Get(const Vec2i &pos) const { return PlaceState(States[Map.getIndex(pos)]); }
+	void Set(const Vec2i &pos, PlaceState state) { States[Map.getIndex(pos)] = state; }
+
+private:
+	unsigned long Cycle;              /// Game cycle of the results
+	unsigned long ChangeCount;        /// Map::ChangeCount of the results
+	const CPlayer *Player;            /// Player of the searches
+	const CUnitType *Type;            /// Building to place
+	int Range;                        /// Tiles around the building the checks look at
+	std::vector<unsigned char> States;/// PlaceState of each tile
+};
+
+static BuildingPlaceCache PlaceCache;
+
+/**
+**  Forget the results, if they are for another search or the map changed.
+*/
+void BuildingPlaceCache::Prepare(const CPlayer &player, const CUnitType &type)
+{
+	const size_t size = Map.Info.MapWidth * Map.Info.MapHeight;
+
+	if (Cycle == GameCycle && ChangeCount == Map.ChangeCount && Player == &player
+		&& Type == &type && States.size() == size) {
+		return;
+	}
+	Cycle = GameCycle;
+	ChangeCount = Map.ChangeCount;
+	Player = &player;
+	Type = &type;
+	Range = type.AiAdjacentRange != -1 ? type.AiAdjacentRange : 1;
+	for (size_t i = 0; i != type.BuildingRules.size(); ++i) {
+		Range = std::max(Range, type.BuildingRules[i]->Range());
+	}
+	for (size_t i = 0; i != type.AiBuildingRules.size(); ++i) {
+		Range = std::max(Range, type.AiBuildingRules[i]->Range());
+	}
+	++Range;
+	States.assign(size, PlaceUnknown);
+}
+
+/**
+**  Check if the result of a tile is the same for all workers.
+**
+**  The worker is taken off the map for the checks and some building
+**  rules ignore it, so the result of a tile near it is its own.
+*/
+bool BuildingPlaceCache::IsSharedWith(const CUnit &worker, const Vec2i &pos) const
+{
+	return worker.tilePos.x + worker.Type->TileWidth - 1 < pos.x - Range
+		   || worker.tilePos.x > pos.x + Type->TileWidth - 1 + Range
+		   || worker.tilePos.y + worker.Type->TileHeight - 1 < pos.y - Range
+		   || worker.tilePos.y > pos.y + Type->TileHeight - 1 + Range;
+}
+
 class BuildingPlaceFinder
 {
 public:
@@ -154,8 +231,11 @@ public:
 	{
 		resultPos->x = -1;
 		resultPos->y = -1;
+		PlaceCache.Prepare(*worker.Player, type);
 	}
 	VisitResult Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from);
+private:
+	BuildingPlaceCache::PlaceState CheckPlace(const Vec2i &pos) const;
 private:
 	const CUnit &worker;
 	const CUnitType &type;
@@ -164,6 +244,19 @@ private:
 	Vec2i *resultPos;
 };
 
+BuildingPlaceCache::PlaceState BuildingPlaceFinder::CheckPlace(const Vec2i &pos) const
+{
+	if (!CanBuildUnitType(&worker, type, pos, 1)
+		|| AiEnemyUnitsInDistance(*worker.Player, NULL, pos, 8)) {
+		return BuildingPlaceCache::PlaceNo;
+	}
+	bool backupok;
+	if (AiCheckSurrounding(worker, type, pos, backupok)) {
+		return BuildingPlaceCache::PlaceFree;
+	}
+	return backupok ? BuildingPlaceCache::PlaceBackup : BuildingPlaceCache::PlaceBlocking;
+}
+
 VisitResult BuildingPlaceFinder::Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from)
 {
 #if 0
@@ -171,16 +264,21 @@ VisitResult BuildingPlaceFinder::Visit(TerrainTraversal &terrainTraversal, const
 		return VisitResult_DeadEnd;
 	}
 #endif
-	if (CanBuildUnitType(&worker, type, pos, 1)
-		&& !AiEnemyUnitsInDistance(*worker.Player, NULL, pos, 8)) {
-		bool backupok;
-		if (AiCheckSurrounding(worker, type, pos, backupok) && checkSurround) {
-			*resultPos = pos;
-			return VisitResult_Finished;
-		} else if (backupok && resultPos->x == -1) {
-			*resultPos = pos;
+	const bool shared = PlaceCache.IsSharedWith(worker, pos);
+	BuildingPlaceCache::PlaceState state = shared ? PlaceCache.Get(pos) : BuildingPlaceCache::PlaceUnknown;
+
+	if (state == BuildingPlaceCache::PlaceUnknown) {
+		state = CheckPlace(pos);
+		if (shared) {
+			PlaceCache.Set(pos, state);
 		}
 	}
+	if (state == BuildingPlaceCache::PlaceFree && checkSurround) {
+		*resultPos = pos;
+		return VisitResult_Finished;
+	} else if (state >= BuildingPlaceCache::PlaceBackup && resultPos->x == -1) {
+		*resultPos = pos;
+	}
 	if (CanMoveToMask(pos, movemask)
 		|| (worker.Type->RepairRange == InfiniteRepairRange && type.BoolFlag[BUILDEROUTSIDE_INDEX].value)) { // reachable, or unit can build from outside and anywhere
 		return VisitResult_Ok;
@@ -272,6 +272,22 @@ public:
 	int Mask;           /// mask ( ex: MapFieldLandUnit )
 };
 
+/**
+**  Phases of the work the AI of a player does each second.
+**
+**  Only the first phase runs in the cycle of the player's second, each
+**  following phase runs one game cycle later. So the cost of a heavy AI
+**  second is spread over several cycles and over the cycles of the other
+**  players.
+*/
+enum AiPhase {
+	AiPhaseScript,     /// Advance the script and check the units
+	AiPhaseResources,  /// Resource manager
+	AiPhaseForces,     /// Force manager
+	AiPhaseMagic,      /// Magic and explorers
+	AiPhaseCount
+};
+
 /**
 **  AI variables.
 */
@@ -281,7 +297,7 @@ public:
 	PlayerAi() : Player(NULL), AiType(NULL),
 		SleepCycles(0), NeededMask(0), NeedSupply(false),
 		ScriptDebug(false), BuildDepots(true), LastExplorationGameCycle(0),
-		LastCanNotMoveGameCycle(0), LastRepairBuilding(0)
+		LastCanNotMoveGameCycle(0), LastRepairBuilding(0), SecondPhase(AiPhaseCount)
 	{
 		memset(Reserve, 0, sizeof(Reserve));
 		memset(Used, 0, sizeof(Used));
@@ -316,6 +332,7 @@ public:
 	std::vector<CUpgrade *> ResearchRequests;     /// Upgrades requested and priority list
 	std::vector<AiBuildQueue> UnitTypeBuilt;      /// What the resource manager should build
 	int LastRepairBuilding;                       /// Last building checked for repair in this turn
+	int SecondPhase;                              /// Next phase of the AI second, AiPhaseCount if done
 };
 
 /**
@@ -63,11 +63,13 @@ void AiCheckMagic()
 					return;
 				}
 			}
+			AutoCastArea area(unit);
+
 			for (unsigned int j = 0; j < SpellTypeTable.size(); ++j) {
 				// Check if we can cast this spell. SpellIsAvailable checks for upgrades.
 				if (unit.Type->CanCastSpell[j] && SpellIsAvailable(player, j)
 					&& SpellTypeTable[j]->AICast) {
-					if (AutoCastSpell(unit, *SpellTypeTable[j])) {
+					if (AutoCastSpell(unit, *SpellTypeTable[j], &area)) {
 						break;
 					}
 				}
@@ -34,6 +34,8 @@
 --  Includes
 ----------------------------------------------------------------------------*/
 
+#include <deque>
+
 #include "stratagus.h"
 
 #include "ai_local.h"
@@ -212,13 +214,21 @@ int AiEnemyUnitsInDistance(const CPlayer &player,
 	const Vec2i offset(range, range);
 	std::vector<CUnit *> units;
 
+	// Look at the units only if the influence map has enemies near.
 	if (type == NULL) {
+		if (Map.Influence.GetEnemies(player, pos - offset, pos + offset).Units == 0) {
+			return 0;
+		}
 		Select(pos - offset, pos + offset, units, IsAEnemyUnitOf(player));
 		return static_cast<int>(units.size());
 	} else {
 		const Vec2i typeSize(type->TileWidth - 1, type->TileHeight - 1);
 		const IsAEnemyUnitWhichCanCounterAttackOf pred(player, *type);
+		const CInfluence enemies = Map.Influence.GetEnemies(player, pos - offset, pos + typeSize + offset);
 
+		if ((type->UnitType == UnitTypeFly ? enemies.AntiAir : enemies.AntiGround) == 0) {
+			return 0;
+		}
 		Select(pos - offset, pos + typeSize + offset, units, pred);
 		return static_cast<int>(units.size());
 	}
@@ -909,6 +919,65 @@ static void AiCheckingWork()
 --  WORKERS/RESOURCES
 ----------------------------------------------------------------------------*/
 
+/**
+**  Searches for resources which found nothing while the workers are
+**  assigned.
+**
+**  Assigning workers only gives orders, the map stays the same. So a
+**  worker can't find anything where another worker failed before:
+**  a terrain search fails from each tile the failed search reached, and
+**  a unit search fails from the same start for the same worker type.
+*/
+class HarvestFailures
+{
+public:
+	void Clear()
+	{
+		Terrain.clear();
+		Units.clear();
+	}
+
+	bool TerrainFailed(const CUnit &unit, int resource) const
+	{
+		for (size_t i = 0; i != Terrain.size(); ++i) {
+			if (Terrain[i].Resource == resource
+				&& Terrain[i].MovementMask == unit.Type->MovementMask
+				&& Terrain[i].Searched.IsReached(unit.tilePos)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	bool UnitFailed(const CUnit &start, const CUnitType &type, int resource) const
+	{
+		for (size_t i = 0; i != Units.size(); ++i) {
+			if (Units[i].Start == &start && Units[i].Type == &type && Units[i].Resource == resource) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+public:
+	/// Failed search for terrain
+	struct TerrainFailure {
+		int Resource;                /// Resource searched
+		unsigned int MovementMask;   /// Movement mask of the worker
+		TerrainTraversal Searched;   /// Tiles reached by the search
+	};
+	/// Failed search for a resource unit
+	struct UnitFailure {
+		const CUnit *Start;          /// Unit the search started from
+		const CUnitType *Type;       /// Type of the worker
+		int Resource;                /// Resource searched
+	};
+
+	std::deque<TerrainFailure> Terrain;  /// Searches are done in place, the tiles are never copied
+	std::vector<UnitFailure> Units;
+};
+
+static HarvestFailures AiHarvestFailures;
+
 /**
 **  Assign worker to gather a certain resource from terrain.
 **
@@ -923,9 +992,17 @@ static int AiAssignHarvesterFromTerrain(CUnit &unit, int resource)
 	Vec2i forestPos;
 
 	// Code for terrain harvesters. Search for piece of terrain to mine.
-	if (FindTerrainType(unit.Type->MovementMask, MapFieldForest, 1000, *unit.Player, unit.tilePos, &forestPos)) {
-		CommandResourceLoc(unit, forestPos, FlushCommands);
-		return 1;
+	if (!AiHarvestFailures.TerrainFailed(unit, resource)) {
+		AiHarvestFailures.Terrain.push_back(HarvestFailures::TerrainFailure());
+		HarvestFailures::TerrainFailure &failure = AiHarvestFailures.Terrain.back();
+
+		if (FindTerrainType(unit.Type->MovementMask, MapFieldForest, 1000, *unit.Player, unit.tilePos, &forestPos, failure.Searched)) {
+			AiHarvestFailures.Terrain.pop_back();
+			CommandResourceLoc(unit, forestPos, FlushCommands);
+			return 1;
+		}
+		failure.Resource = resource;
+		failure.MovementMask = unit.Type->MovementMask;
 	}
 	// Ask the AI to explore...
 	AiExplore(unit.tilePos, MapFieldLandUnit);
@@ -946,12 +1023,18 @@ static int AiAssignHarvesterFromUnit(CUnit &unit, int resource)
 {
 	// Try to find the nearest depot first.
 	CUnit *depot = FindDeposit(unit, 1000, resource);
-	// Find a resource to harvest from.
-	CUnit *mine = UnitFindResource(unit, depot ? *depot : unit, 1000, resource, true);
+	const CUnit &start = depot ? *depot : unit;
 
-	if (mine) {
-		CommandResource(unit, *mine, FlushCommands);
-		return 1;
+	if (!AiHarvestFailures.UnitFailed(start, *unit.Type, resource)) {
+		// Find a resource to harvest from.
+		CUnit *mine = UnitFindResource(unit, start, 1000, resource, true);
+
+		if (mine) {
+			CommandResource(unit, *mine, FlushCommands);
+			return 1;
+		}
+		const HarvestFailures::UnitFailure failure = { &start, unit.Type, resource };
+		AiHarvestFailures.Units.push_back(failure);
 	}
 
 	int exploremask = 0;
@@ -1032,6 +1115,7 @@ static void AiCollectResources()
 	memset(num_units_with_resource, 0, sizeof(num_units_with_resource));
 	memset(num_units_unassigned, 0, sizeof(num_units_unassigned));
 	memset(num_units_assigned, 0, sizeof(num_units_assigned));
+	AiHarvestFailures.Clear();
 
 	// Collect statistics about the current assignment
 	const int n = AiPlayer->Player->GetUnitCount();
@@ -40,6 +40,7 @@
 #include "ai_local.h"
 
 #include "interface.h"
+#include "map.h"
 #include "pathfinder.h"
 #include "player.h"
 #include "script.h"
@@ -515,6 +516,28 @@ static int CclAiGetSleepCycles(lua_State *l)
 	return 1;
 }
 
+/**
+**  Get the influence of the enemies of the AI player around a position.
+**
+**  @param l  Lua state
+**
+**  @return   Number of return values
+*/
+static int CclAiGetThreat(lua_State *l)
+{
+	LuaCheckArgs(l, 3);
+	const Vec2i pos(LuaToNumber(l, 1), LuaToNumber(l, 2));
+	const int range = LuaToNumber(l, 3);
+	const Vec2i offset(range, range);
+	const CInfluence enemies = Map.Influence.GetEnemies(*AiPlayer->Player, pos - offset, pos + offset);
+
+	lua_pushnumber(l, enemies.Units);
+	lua_pushnumber(l, enemies.Strength);
+	lua_pushnumber(l, enemies.AntiAir);
+	lua_pushnumber(l, enemies.AntiGround);
+	return 4;
+}
+
 //----------------------------------------------------------------------------
 
 /**
@@ -1369,6 +1392,8 @@ static int CclDefineAiPlayer(lua_State *l)
 			ai->LastExplorationGameCycle = LuaToNumber(l, j + 1);
 		} else if (!strcmp(value, "last-can-not-move-cycle")) {
 			ai->LastCanNotMoveGameCycle = LuaToNumber(l, j + 1);
+		} else if (!strcmp(value, "second-phase")) {
+			ai->SecondPhase = LuaToNumber(l, j + 1);
 		} else if (!strcmp(value, "unit-type")) {
 			if (!lua_istable(l, j + 1)) {
 				LuaError(l, "incorrect argument");
@@ -1428,6 +1453,7 @@ void AiCclRegister()
 
 	lua_register(Lua, "AiGetRace", CclAiGetRace);
 	lua_register(Lua, "AiGetSleepCycles", CclAiGetSleepCycles);
+	lua_register(Lua, "AiGetThreat", CclAiGetThreat);
 
 	lua_register(Lua, "AiDebug", CclAiDebug);
 	lua_register(Lua, "AiDebugPlayer", CclAiDebugPlayer);
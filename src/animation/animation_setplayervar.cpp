@@ -164,8 +164,10 @@ static void SetPlayerData(const int player, const char *prop, const char *arg, i
 		Players[player].Score = value;
 	} else if (!strcmp(prop, "TotalUnits")) {
 		Players[player].TotalUnits = value;
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(prop, "TotalBuildings")) {
 		Players[player].TotalBuildings = value;
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(prop, "TotalResources")) {
 		const int resId = GetResourceIdByName(arg);
 		if (resId == -1) {
@@ -175,8 +177,10 @@ static void SetPlayerData(const int player, const char *prop, const char *arg, i
 		Players[player].TotalResources[resId] = value;
 	} else if (!strcmp(prop, "TotalRazings")) {
 		Players[player].TotalRazings = value;
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(prop, "TotalKills")) {
 		Players[player].TotalKills = value;
+		++PlayerUnitsChangeCount;
 	} else {
 		fprintf(stderr, "Invalid field: %s" _C_ prop);
 		Exit(1);
@@ -59,6 +59,7 @@
 #include "parameters.h"
 #include "pathfinder.h"
 #include "player.h"
+#include "profile.h"
 #include "replay.h"
 #include "results.h"
 #include "settings.h"
@@ -1129,6 +1130,7 @@ static void CleanGame_Lua()
 void CleanGame()
 {
 	EndReplayLog();
+	ProfileEndGame();
 	CleanMessages();
 
 	RestoreColorCyclingSurface();
@@ -1586,6 +1588,7 @@ void LuaRegisterModules()
 	NetworkCclRegister();
 	PathfinderCclRegister();
 	PlayerCclRegister();
+	ProfileCclRegister();
 	ReplayCclRegister();
 	ScriptRegister();
 	SelectionCclRegister();
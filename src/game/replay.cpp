@@ -47,6 +47,7 @@
 #include "network.h"
 #include "parameters.h"
 #include "player.h"
+#include "results.h"
 #include "script.h"
 #include "settings.h"
 #include "sound.h"
@@ -59,6 +60,8 @@
 #include <sstream>
 #include <time.h>
 
+#include "SDL.h"
+
 extern void ExpandPath(std::string &newpath, const std::string &path);
 extern void StartMap(const std::string &filename, bool clean);
 
@@ -66,14 +69,66 @@ extern void StartMap(const std::string &filename, bool clean);
 // Structures
 //----------------------------------------------------------------------------
 
+/**
+**  Logged commands.
+**
+**  The values are stored in compact replay logs, so new actions must be
+**  added at the end.
+*/
+enum ReplayAction {
+	ReplayActionNone,
+	ReplayActionStop,
+	ReplayActionStandGround,
+	ReplayActionDefend,
+	ReplayActionFollow,
+	ReplayActionMove,
+	ReplayActionRepair,
+	ReplayActionAutoRepair,
+	ReplayActionAttack,
+	ReplayActionAttackGround,
+	ReplayActionPatrol,
+	ReplayActionBoard,
+	ReplayActionUnload,
+	ReplayActionBuild,
+	ReplayActionDismiss,
+	ReplayActionResourceLoc,
+	ReplayActionResource,
+	ReplayActionReturn,
+	ReplayActionTrain,
+	ReplayActionCancelTrain,
+	ReplayActionUpgradeTo,
+	ReplayActionCancelUpgradeTo,
+	ReplayActionResearch,
+	ReplayActionCancelResearch,
+	ReplayActionSpellCast,
+	ReplayActionAutoSpellCast,
+	ReplayActionDiplomacy,
+	ReplayActionSharedVision,
+	ReplayActionInput,
+	ReplayActionChat,
+	ReplayActionQuit,
+	ReplayActionEnd,
+	NumReplayActions
+};
+
+/// Names of the logged commands, as used by CommandLog and Log()
+static const char *const ReplayActionNames[NumReplayActions] = {
+	"", "stop", "stand-ground", "defend", "follow", "move", "repair",
+	"auto-repair", "attack", "attack-ground", "patrol", "board", "unload",
+	"build", "dismiss", "resource-loc", "resource", "return", "train",
+	"cancel-train", "upgrade-to", "cancel-upgrade-to", "research",
+	"cancel-research", "spell-cast", "auto-spell-cast", "diplomacy",
+	"shared-vision", "input", "chat", "quit", "end"
+};
+
 /**
 **  LogEntry structure.
 */
 class LogEntry
 {
 public:
-	LogEntry() : GameCycle(0), Flush(0), PosX(0), PosY(0), DestUnitNumber(0),
-		Num(0), SyncRandSeed(0), Next(NULL)
+	LogEntry() : GameCycle(0), Action(ReplayActionNone), Flush(0), PosX(0), PosY(0),
+		DestUnitNumber(0), Num(0), SyncRandSeed(0), Next(NULL)
 	{
 		UnitNumber = 0;
 	}
@@ -81,7 +136,7 @@ public:
 	unsigned long GameCycle;
 	int UnitNumber;
 	std::string UnitIdent;
-	std::string Action;
+	ReplayAction Action;
 	int Flush;
 	int PosX;
 	int PosY;
@@ -117,7 +172,7 @@ public:
 	FullReplay() :
 		MapId(0), Type(0), Race(0), LocalPlayer(0),
 		Resource(0), NumUnits(0), Difficulty(0), NoFow(false), Inside(false), RevealMap(0),
-		MapRichness(0), GameType(0), Opponents(0), Commands(NULL)
+		MapRichness(0), GameType(0), Opponents(0), Commands(NULL), LastCommand(NULL)
 	{
 		memset(Engine, 0, sizeof(Engine));
 		memset(Network, 0, sizeof(Network));
@@ -147,12 +202,16 @@ public:
 	int Engine[3];
 	int Network[3];
 	LogEntry *Commands;
+	LogEntry *LastCommand; /// End of Commands, for appending
 };
 
 //----------------------------------------------------------------------------
 // Constants
 //----------------------------------------------------------------------------
 
+static const int ReplayCommandsVersion = 1; /// Version of ReplayCommands() blocks
+static const int ReplayCommandsPerBlock = 1024; /// Commands in a ReplayCommands() block
+
 
 //----------------------------------------------------------------------------
 // Variables
@@ -160,8 +219,12 @@ public:
 
 bool CommandLogDisabled;           /// True if command log is off
 ReplayType ReplayGameType;         /// Replay game type
+int ReplayTraceCycles;             /// SyncHash trace interval of VerifyReplay, 0 if not verifying
+static unsigned int VerifyReplayTicks; /// Time VerifyReplay started
+static bool VerifyReplayEnded;     /// End of the verified replay printed
 static bool DisabledLog;           /// Disabled log for replay
 static CFile *LogFile;             /// Replay log file
+static std::string LogFileName;    /// Name of the replay log file
 static unsigned long NextLogCycle; /// Next log cycle number
 static int InitReplay;             /// Initialize replay
 static FullReplay *CurrentReplay;
@@ -293,6 +356,133 @@ static void DeleteReplay(FullReplay *replay)
 	delete replay;
 }
 
+/**
+**  Get a logged command by name.
+**
+**  @param name  Command name (move,attack,...).
+**
+**  @return      The command, ReplayActionNone if unknown.
+*/
+static ReplayAction ReplayActionByName(const char *name)
+{
+	for (int i = 1; i != NumReplayActions; ++i) {
+		if (!strcmp(name, ReplayActionNames[i])) {
+			return static_cast<ReplayAction>(i);
+		}
+	}
+	DebugPrint("Invalid action: %s" _C_ name);
+	return ReplayActionNone;
+}
+
+/**
+**  Append a log entry to the commands of the current replay.
+**
+**  @param log  Log entry to append.
+*/
+static void AppendLogEntry(LogEntry *log)
+{
+	log->Next = NULL;
+	if (CurrentReplay->LastCommand) {
+		CurrentReplay->LastCommand->Next = log;
+	} else {
+		CurrentReplay->Commands = log;
+	}
+	CurrentReplay->LastCommand = log;
+}
+
+static void PutVarint(std::string &data, unsigned long value)
+{
+	while (value >= 0x80) {
+		data += (char)(value | 0x80);
+		value >>= 7;
+	}
+	data += (char)value;
+}
+
+static void PutSignedVarint(std::string &data, long value)
+{
+	PutVarint(data, value < 0 ? ~((unsigned long)value << 1) : (unsigned long)value << 1);
+}
+
+static void PutLogString(std::string &data, const std::string &value)
+{
+	PutVarint(data, value.size());
+	data += value;
+}
+
+static bool GetVarint(const std::string &data, size_t &pos, unsigned long &value)
+{
+	value = 0;
+	for (int shift = 0; pos < data.size() && shift < 64; shift += 7) {
+		const unsigned char c = data[pos++];
+		value |= (unsigned long)(c & 0x7F) << shift;
+		if (!(c & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool GetSignedVarint(const std::string &data, size_t &pos, int &value)
+{
+	unsigned long v;
+	if (!GetVarint(data, pos, v)) {
+		return false;
+	}
+	value = (v & 1) ? (int)~(v >> 1) : (int)(v >> 1);
+	return true;
+}
+
+static bool GetLogString(const std::string &data, size_t &pos, std::string &value)
+{
+	unsigned long size;
+	if (!GetVarint(data, pos, size) || size > data.size() - pos) {
+		return false;
+	}
+	value.assign(data, pos, size);
+	pos += size;
+	return true;
+}
+
+/**
+**  Output log entries as compact ReplayCommands() blocks.
+**
+**  Each block holds the commands of ReplayCommandsPerBlock log entries,
+**  with the game cycle stored as difference to the previous entry.
+**
+**  @param log   First log entry to output.
+**  @param file  The file to output to.
+*/
+static void SaveLogCommands(const LogEntry *log, CFile &file)
+{
+	while (log) {
+		std::string data;
+		unsigned long cycle = 0;
+
+		PutVarint(data, ReplayCommandsVersion);
+		for (int i = 0; log && i != ReplayCommandsPerBlock; ++i, log = log->Next) {
+			PutVarint(data, log->GameCycle - cycle);
+			cycle = log->GameCycle;
+			PutVarint(data, log->Action);
+			PutSignedVarint(data, log->UnitNumber);
+			PutLogString(data, log->UnitIdent);
+			PutSignedVarint(data, log->Flush);
+			PutSignedVarint(data, log->PosX);
+			PutSignedVarint(data, log->PosY);
+			PutSignedVarint(data, log->DestUnitNumber);
+			PutLogString(data, log->Value);
+			PutSignedVarint(data, log->Num);
+			PutVarint(data, log->SyncRandSeed);
+		}
+		const std::string text = EncodeBase64(data);
+		file.printf("ReplayCommands([[\n");
+		for (size_t i = 0; i < text.size(); i += 76) {
+			file.printf("%s\n", text.substr(i, 76).c_str());
+		}
+		file.printf("]])\n");
+	}
+}
+
 static void PrintLogCommand(const LogEntry &log, CFile &file)
 {
 	file.printf("Log( { ");
@@ -303,7 +493,7 @@ static void PrintLogCommand(const LogEntry &log, CFile &file)
 	if (!log.UnitIdent.empty()) {
 		file.printf("UnitIdent = \"%s\", ", log.UnitIdent.c_str());
 	}
-	file.printf("Action = \"%s\", ", log.Action.c_str());
+	file.printf("Action = \"%s\", ", ReplayActionNames[log.Action]);
 	file.printf("Flush = %d, ", log.Flush);
 	if (log.PosX != -1 || log.PosY != -1) {
 		file.printf("PosX = %d, PosY = %d, ", log.PosX, log.PosY);
@@ -370,11 +560,7 @@ static void SaveFullLog(CFile &file)
 	file.printf("  Network = { %d, %d, %d }\n",
 				CurrentReplay->Network[0], CurrentReplay->Network[1], CurrentReplay->Network[2]);
 	file.printf("} )\n");
-	const LogEntry *log = CurrentReplay->Commands;
-	while (log) {
-		PrintLogCommand(*log, file);
-		log = log->Next;
-	}
+	SaveLogCommands(CurrentReplay->Commands, file);
 }
 
 /**
@@ -385,16 +571,7 @@ static void SaveFullLog(CFile &file)
 */
 static void AppendLog(LogEntry *log, CFile &file)
 {
-	LogEntry **last;
-
-	// Append to linked list
-	last = &CurrentReplay->Commands;
-	while (*last) {
-		last = &(*last)->Next;
-	}
-
-	*last = log;
-	log->Next = 0;
+	AppendLogEntry(log);
 
 	PrintLogCommand(*log, file);
 	file.flush();
@@ -444,6 +621,7 @@ void CommandLog(const char *action, const CUnit *unit, int flush,
 		path += buf;
 		path += ".log";
 
+		LogFileName = path;
 		LogFile = new CFile;
 		if (LogFile->open(path.c_str(), CL_OPEN_WRITE) == -1) {
 			// don't retry for each command
@@ -478,7 +656,7 @@ void CommandLog(const char *action, const CUnit *unit, int flush,
 	log->UnitNumber = (unit ? UnitNumber(*unit) : -1);
 	log->UnitIdent = (unit ? unit->Type->Ident.c_str() : "");
 
-	log->Action = action;
+	log->Action = ReplayActionByName(action);
 	log->Flush = flush;
 
 	//
@@ -514,7 +692,6 @@ void CommandLog(const char *action, const CUnit *unit, int flush,
 static int CclLog(lua_State *l)
 {
 	LogEntry *log;
-	LogEntry **last;
 	const char *value;
 
 	LuaCheckArgs(l, 1);
@@ -541,7 +718,7 @@ static int CclLog(lua_State *l)
 		} else if (!strcmp(value, "UnitIdent")) {
 			log->UnitIdent = LuaToString(l, -1);
 		} else if (!strcmp(value, "Action")) {
-			log->Action = LuaToString(l, -1);
+			log->Action = ReplayActionByName(LuaToString(l, -1));
 		} else if (!strcmp(value, "Flush")) {
 			log->Flush = LuaToNumber(l, -1);
 		} else if (!strcmp(value, "PosX")) {
@@ -561,15 +738,54 @@ static int CclLog(lua_State *l)
 		}
 		lua_pop(l, 1);
 	}
+	AppendLogEntry(log);
+	return 0;
+}
 
-	// Append to linked list
-	last = &CurrentReplay->Commands;
-	while (*last) {
-		last = &(*last)->Next;
-	}
-
-	*last = log;
+/**
+** Parse a block of compact log entries, see SaveLogCommands
+*/
+static int CclReplayCommands(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	Assert(CurrentReplay);
 
+	std::string data;
+	if (!DecodeBase64(LuaToString(l, 1), data)) {
+		LuaError(l, "incorrect argument");
+	}
+	size_t pos = 0;
+	unsigned long version;
+	if (!GetVarint(data, pos, version) || version != ReplayCommandsVersion) {
+		LuaError(l, "Unsupported replay commands version");
+	}
+	unsigned long cycle = 0;
+	while (pos != data.size()) {
+		LogEntry *log = new LogEntry;
+		unsigned long delta;
+		unsigned long action;
+		unsigned long seed;
+
+		if (!GetVarint(data, pos, delta)
+			|| !GetVarint(data, pos, action) || action >= NumReplayActions
+			|| !GetSignedVarint(data, pos, log->UnitNumber)
+			|| !GetLogString(data, pos, log->UnitIdent)
+			|| !GetSignedVarint(data, pos, log->Flush)
+			|| !GetSignedVarint(data, pos, log->PosX)
+			|| !GetSignedVarint(data, pos, log->PosY)
+			|| !GetSignedVarint(data, pos, log->DestUnitNumber)
+			|| !GetLogString(data, pos, log->Value)
+			|| !GetSignedVarint(data, pos, log->Num)
+			|| !GetVarint(data, pos, seed)) {
+			delete log;
+			LuaError(l, "incorrect replay commands");
+		}
+		cycle += delta;
+		log->GameCycle = cycle;
+		log->Action = static_cast<ReplayAction>(action);
+		log->SyncRandSeed = seed;
+		AppendLogEntry(log);
+	}
 	return 0;
 }
 
@@ -744,8 +960,18 @@ int LoadReplay(const std::string &name)
 */
 void EndReplayLog()
 {
+	if (LogFile && CurrentReplay) {
+		// Record where and how the game ended, the replay plays until there.
+		CommandLog("end", NoUnitP, FlushCommands, -1, -1, NoUnitP, NULL, GameResult);
+	}
 	if (LogFile) {
 		LogFile->close();
+		// The log was written command by command, so it's complete
+		// after a crash. Now rewrite it in the compact format.
+		if (CurrentReplay && LogFile->open(LogFileName.c_str(), CL_OPEN_WRITE) != -1) {
+			SaveFullLog(*LogFile);
+			LogFile->close();
+		}
 		delete LogFile;
 		LogFile = NULL;
 	}
@@ -776,6 +1002,26 @@ void CleanReplayLog()
 	ReplayGameType = ReplayNone;
 }
 
+/**
+**  End of the replayed game reached, print the result of the verification
+**  and stop the game.
+**
+**  Called at the recorded end of the replay, and when the game loop ends
+**  for replays without a recorded end. Does nothing if not verifying.
+*/
+void EndVerifyReplay()
+{
+	if (!ReplayTraceCycles || VerifyReplayEnded) {
+		return;
+	}
+	const unsigned int ticks = SDL_GetTicks() - VerifyReplayTicks;
+
+	VerifyReplayEnded = true;
+	printf("replay-end %lu %08x %u\n", GameCycle, SyncHash, ticks);
+	fflush(stdout);
+	StopGame(GameExit);
+}
+
 /**
 **  Do next replay
 */
@@ -790,7 +1036,7 @@ static void DoNextReplay()
 	}
 
 	const int unitSlot = ReplayStep->UnitNumber;
-	const char *action = ReplayStep->Action.c_str();
+	const ReplayAction action = ReplayStep->Action;
 	const int flags = ReplayStep->Flush;
 	const Vec2i pos(ReplayStep->PosX, ReplayStep->PosY);
 	const int arg1 = ReplayStep->PosX;
@@ -824,88 +1070,125 @@ static void DoNextReplay()
 #endif
 	}
 
-	if (!strcmp(action, "stop")) {
-		SendCommandStopUnit(*unit);
-	} else if (!strcmp(action, "stand-ground")) {
-		SendCommandStandGround(*unit, flags);
-	} else if (!strcmp(action, "defend")) {
-		SendCommandDefend(*unit, *dunit, flags);
-	} else if (!strcmp(action, "follow")) {
-		SendCommandFollow(*unit, *dunit, flags);
-	} else if (!strcmp(action, "move")) {
-		SendCommandMove(*unit, pos, flags);
-	} else if (!strcmp(action, "repair")) {
-		SendCommandRepair(*unit, pos, dunit, flags);
-	} else if (!strcmp(action, "auto-repair")) {
-		SendCommandAutoRepair(*unit, arg1);
-	} else if (!strcmp(action, "attack")) {
-		SendCommandAttack(*unit, pos, dunit, flags);
-	} else if (!strcmp(action, "attack-ground")) {
-		SendCommandAttackGround(*unit, pos, flags);
-	} else if (!strcmp(action, "patrol")) {
-		SendCommandPatrol(*unit, pos, flags);
-	} else if (!strcmp(action, "board")) {
-		SendCommandBoard(*unit, *dunit, flags);
-	} else if (!strcmp(action, "unload")) {
-		SendCommandUnload(*unit, pos, dunit, flags);
-	} else if (!strcmp(action, "build")) {
-		SendCommandBuildBuilding(*unit, pos, *UnitTypeByIdent(val), flags);
-	} else if (!strcmp(action, "dismiss")) {
-		SendCommandDismiss(*unit);
-	} else if (!strcmp(action, "resource-loc")) {
-		SendCommandResourceLoc(*unit, pos, flags);
-	} else if (!strcmp(action, "resource")) {
-		SendCommandResource(*unit, *dunit, flags);
-	} else if (!strcmp(action, "return")) {
-		SendCommandReturnGoods(*unit, dunit, flags);
-	} else if (!strcmp(action, "train")) {
-		SendCommandTrainUnit(*unit, *UnitTypeByIdent(val), flags);
-	} else if (!strcmp(action, "cancel-train")) {
-		SendCommandCancelTraining(*unit, num, (val && *val) ? UnitTypeByIdent(val) : NULL);
-	} else if (!strcmp(action, "upgrade-to")) {
-		SendCommandUpgradeTo(*unit, *UnitTypeByIdent(val), flags);
-	} else if (!strcmp(action, "cancel-upgrade-to")) {
-		SendCommandCancelUpgradeTo(*unit);
-	} else if (!strcmp(action, "research")) {
-		SendCommandResearch(*unit, *CUpgrade::Get(val), flags);
-	} else if (!strcmp(action, "cancel-research")) {
-		SendCommandCancelResearch(*unit);
-	} else if (!strcmp(action, "spell-cast")) {
-		SendCommandSpellCast(*unit, pos, dunit, num, flags);
-	} else if (!strcmp(action, "auto-spell-cast")) {
-		SendCommandAutoSpellCast(*unit, num, arg1);
-	} else if (!strcmp(action, "diplomacy")) {
-		int state;
-		if (!strcmp(val, "neutral")) {
-			state = DiplomacyNeutral;
-		} else if (!strcmp(val, "allied")) {
-			state = DiplomacyAllied;
-		} else if (!strcmp(val, "enemy")) {
-			state = DiplomacyEnemy;
-		} else if (!strcmp(val, "crazy")) {
-			state = DiplomacyCrazy;
-		} else {
-			DebugPrint("Invalid diplomacy command: %s" _C_ val);
-			state = -1;
+	switch (action) {
+		case ReplayActionStop:
+			SendCommandStopUnit(*unit);
+			break;
+		case ReplayActionStandGround:
+			SendCommandStandGround(*unit, flags);
+			break;
+		case ReplayActionDefend:
+			SendCommandDefend(*unit, *dunit, flags);
+			break;
+		case ReplayActionFollow:
+			SendCommandFollow(*unit, *dunit, flags);
+			break;
+		case ReplayActionMove:
+			SendCommandMove(*unit, pos, flags);
+			break;
+		case ReplayActionRepair:
+			SendCommandRepair(*unit, pos, dunit, flags);
+			break;
+		case ReplayActionAutoRepair:
+			SendCommandAutoRepair(*unit, arg1);
+			break;
+		case ReplayActionAttack:
+			SendCommandAttack(*unit, pos, dunit, flags);
+			break;
+		case ReplayActionAttackGround:
+			SendCommandAttackGround(*unit, pos, flags);
+			break;
+		case ReplayActionPatrol:
+			SendCommandPatrol(*unit, pos, flags);
+			break;
+		case ReplayActionBoard:
+			SendCommandBoard(*unit, *dunit, flags);
+			break;
+		case ReplayActionUnload:
+			SendCommandUnload(*unit, pos, dunit, flags);
+			break;
+		case ReplayActionBuild:
+			SendCommandBuildBuilding(*unit, pos, *UnitTypeByIdent(val), flags);
+			break;
+		case ReplayActionDismiss:
+			SendCommandDismiss(*unit);
+			break;
+		case ReplayActionResourceLoc:
+			SendCommandResourceLoc(*unit, pos, flags);
+			break;
+		case ReplayActionResource:
+			SendCommandResource(*unit, *dunit, flags);
+			break;
+		case ReplayActionReturn:
+			SendCommandReturnGoods(*unit, dunit, flags);
+			break;
+		case ReplayActionTrain:
+			SendCommandTrainUnit(*unit, *UnitTypeByIdent(val), flags);
+			break;
+		case ReplayActionCancelTrain:
+			SendCommandCancelTraining(*unit, num, (val && *val) ? UnitTypeByIdent(val) : NULL);
+			break;
+		case ReplayActionUpgradeTo:
+			SendCommandUpgradeTo(*unit, *UnitTypeByIdent(val), flags);
+			break;
+		case ReplayActionCancelUpgradeTo:
+			SendCommandCancelUpgradeTo(*unit);
+			break;
+		case ReplayActionResearch:
+			SendCommandResearch(*unit, *CUpgrade::Get(val), flags);
+			break;
+		case ReplayActionCancelResearch:
+			SendCommandCancelResearch(*unit);
+			break;
+		case ReplayActionSpellCast:
+			SendCommandSpellCast(*unit, pos, dunit, num, flags);
+			break;
+		case ReplayActionAutoSpellCast:
+			SendCommandAutoSpellCast(*unit, num, arg1);
+			break;
+		case ReplayActionDiplomacy: {
+			int state;
+			if (!strcmp(val, "neutral")) {
+				state = DiplomacyNeutral;
+			} else if (!strcmp(val, "allied")) {
+				state = DiplomacyAllied;
+			} else if (!strcmp(val, "enemy")) {
+				state = DiplomacyEnemy;
+			} else if (!strcmp(val, "crazy")) {
+				state = DiplomacyCrazy;
+			} else {
+				DebugPrint("Invalid diplomacy command: %s" _C_ val);
+				state = -1;
+			}
+			SendCommandDiplomacy(arg1, state, arg2);
+			break;
 		}
-		SendCommandDiplomacy(arg1, state, arg2);
-	} else if (!strcmp(action, "shared-vision")) {
-		bool state;
-		state = atoi(val) ? true : false;
-		SendCommandSharedVision(arg1, state, arg2);
-	} else if (!strcmp(action, "input")) {
-		if (val[0] == '-') {
-			CclCommand(val + 1, false);
-		} else {
-			HandleCheats(val);
+		case ReplayActionSharedVision: {
+			bool state;
+			state = atoi(val) ? true : false;
+			SendCommandSharedVision(arg1, state, arg2);
+			break;
 		}
-	} else if (!strcmp(action, "chat")) {
-		SetMessage("%s", val);
-		PlayGameSound(GameSounds.ChatMessage.Sound, MaxSampleVolume);
-	} else if (!strcmp(action, "quit")) {
-		CommandQuit(arg1);
-	} else {
-		DebugPrint("Invalid action: %s" _C_ action);
+		case ReplayActionInput:
+			if (val[0] == '-') {
+				CclCommand(val + 1, false);
+			} else {
+				HandleCheats(val);
+			}
+			break;
+		case ReplayActionChat:
+			SetMessage("%s", val);
+			PlayGameSound(GameSounds.ChatMessage.Sound, MaxSampleVolume);
+			break;
+		case ReplayActionQuit:
+			CommandQuit(arg1);
+			break;
+		case ReplayActionEnd:
+			EndVerifyReplay();
+			break;
+		default:
+			DebugPrint("Invalid action: %d" _C_ action);
+			break;
 	}
 
 	ReplayStep = ReplayStep->Next;
@@ -920,6 +1203,9 @@ static void ReplayEachCycle()
 	if (!CurrentReplay) {
 		return;
 	}
+	if (ReplayTraceCycles && GameCycle % ReplayTraceCycles == 0) {
+		printf("replay-trace %lu %08x\n", GameCycle, SyncHash);
+	}
 	if (InitReplay) {
 		for (int i = 0; i < PlayerMax; ++i) {
 			if (!CurrentReplay->Players[i].Name.empty()) {
@@ -948,6 +1234,9 @@ static void ReplayEachCycle()
 	if (!ReplayStep) {
 		SetMessage("%s", _("End of replay"));
 		GameObserve = false;
+		if (ReplayTraceCycles && !VerifyReplayEnded) {
+			fprintf(stderr, "The replay has no recorded end, running until the game result\n");
+		}
 	}
 }
 
@@ -1041,6 +1330,25 @@ void StartReplay(const std::string &filename, bool reveal)
 	StartMap(CurrentMapPath, false);
 }
 
+/**
+**  Run a replay headless, as fast as possible.
+**
+**  The SyncHash is printed every ReplayTraceCycles cycles, and the game
+**  is stopped at the end of the replay.
+**
+**  @param filename  Replay file name.
+*/
+void VerifyReplay(const std::string &filename)
+{
+	Assert(ReplayTraceCycles > 0);
+
+	CleanPlayers();
+	LoadReplay(filename);
+	VerifyReplayTicks = SDL_GetTicks();
+	VerifyReplayEnded = false;
+	StartMap(CurrentMapPath, false);
+}
+
 /**
 **  Register Ccl functions with lua
 */
@@ -1048,6 +1356,7 @@ void ReplayCclRegister()
 {
 	lua_register(Lua, "Log", CclLog);
 	lua_register(Lua, "ReplayLog", CclReplayLog);
+	lua_register(Lua, "ReplayCommands", CclReplayCommands);
 }
 
 //@}
@@ -57,6 +57,12 @@
 
 #include <time.h>
 
+#ifdef USE_WIN32
+#include <windows.h>
+#endif
+
+#include "SDL.h"
+
 extern void StartMap(const std::string &filename, bool clean);
 
 
@@ -64,6 +70,10 @@ extern void StartMap(const std::string &filename, bool clean);
 --  Variables
 ----------------------------------------------------------------------------*/
 
+static SDL_Thread *AutosaveThread;  /// Thread writing the autosave
+static std::string AutosaveData;    /// Autosave to be written by AutosaveThread
+static std::string AutosavePath;    /// Where AutosaveThread writes to
+
 /*----------------------------------------------------------------------------
 --  Functions
 ----------------------------------------------------------------------------*/
@@ -101,25 +111,13 @@ static std::string GetSaveDir()
 }
 
 /**
-**  Save a game to file.
+**  Save the game state to an opened file.
 **
-**  @param filename  File name to be stored.
-**  @return  -1 if saving failed, 0 if all OK
-**
-**  @note  Later we want to store in a more compact binary format.
+**  @param file      File to write to.
+**  @param filename  Save game file name, used for the preview name.
 */
-int SaveGame(const std::string &filename)
+static void SaveGameState(CFile &file, const std::string &filename)
 {
-	CFile file;
-	std::string fullpath(GetSaveDir());
-
-	fullpath += "/";
-	fullpath += filename;
-	if (file.open(fullpath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
-		fprintf(stderr, "Can't save to '%s'\n", filename.c_str());
-		return -1;
-	}
-
 	time_t now;
 	char dateStr[64];
 
@@ -179,10 +177,127 @@ int SaveGame(const std::string &filename)
 		file.printf("-- Lua state\n\n %s\n", s.c_str());
 	}
 	SaveTriggers(file); //Triggers are saved in SaveGlobal, so load it after Global
+}
+
+/**
+**  Save a game to file.
+**
+**  @param filename  File name to be stored.
+**  @return  -1 if saving failed, 0 if all OK
+**
+**  @note  Later we want to store in a more compact binary format.
+*/
+int SaveGame(const std::string &filename)
+{
+	CFile file;
+	std::string fullpath(GetSaveDir());
+
+	fullpath += "/";
+	fullpath += filename;
+	if (file.open(fullpath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
+		fprintf(stderr, "Can't save to '%s'\n", filename.c_str());
+		return -1;
+	}
+	SaveGameState(file, filename);
 	file.close();
 	return 0;
 }
 
+/**
+**  Replace a file by another one.
+**
+**  The target is replaced in one step, so it is never missing.
+**
+**  @return  true on success.
+*/
+static bool ReplaceSaveFile(const std::string &from, const std::string &to)
+{
+#ifdef USE_WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+/**
+**  Compress and write an autosave, runs in its own thread.
+**
+**  The save is written to a temporary file first, so the previous
+**  autosave stays intact until the new one is complete.
+*/
+static int AutosaveThreadFunction(void *)
+{
+#ifdef USE_ZLIB
+	const std::string ext(".gz"); // Added by CFile for CL_WRITE_GZ
+#else
+	const std::string ext;
+#endif
+	const std::string tmppath = AutosavePath + ".tmp";
+	CFile file;
+	int ret = 0;
+
+	if (file.open(tmppath.c_str(), CL_WRITE_GZ | CL_OPEN_WRITE) == -1) {
+		ret = -1;
+	} else {
+		if (file.write(AutosaveData.data(), AutosaveData.size()) < 0) {
+			ret = -1;
+		}
+		if (file.close() != 0) {
+			ret = -1;
+		}
+	}
+	if (ret == 0) {
+		if (!ReplaceSaveFile(tmppath + ext, AutosavePath + ext)) {
+			ret = -1;
+		}
+	}
+	if (ret != 0) {
+		fprintf(stderr, "Can't save to '%s'\n", AutosavePath.c_str());
+	}
+	std::string().swap(AutosaveData);
+	return ret;
+}
+
+/**
+**  Wait until the running autosave is written.
+*/
+void WaitForAutosave()
+{
+	if (AutosaveThread) {
+		SDL_WaitThread(AutosaveThread, NULL);
+		AutosaveThread = NULL;
+	}
+}
+
+/**
+**  Autosave the game without stalling the game loop.
+**
+**  The game state is saved to memory, which is a consistent snapshot of
+**  the current cycle. Compressing and writing it, which takes most of the
+**  time, is done by a thread while the game goes on.
+**
+**  @param filename  File name to be stored.
+*/
+void AutosaveGame(const std::string &filename)
+{
+	WaitForAutosave();
+
+	const unsigned int ticks = SDL_GetTicks();
+	CFile file;
+
+	file.openBuffer();
+	SaveGameState(file, filename);
+	file.close();
+	file.takeBuffer(AutosaveData);
+	AutosavePath = GetSaveDir() + "/" + filename;
+
+	AutosaveThread = SDL_CreateThread(AutosaveThreadFunction, NULL);
+	if (AutosaveThread == NULL) {
+		AutosaveThreadFunction(NULL);
+	}
+	DebugPrint("Autosave stalled the game for %u ms\n" _C_ SDL_GetTicks() - ticks);
+}
+
 /**
 **  Delete save game
 **
@@ -0,0 +1,455 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name synchash.cpp - Sync state hashes to find desyncs. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/**
+** @page SyncHashModule Module - Sync hashes
+**
+** In a network game the state of each part of the game is hashed at the
+** end of every game cycle and kept for the last SyncHashesHistory cycles.
+** The map is hashed one stripe of rows per cycle to stay cheap; the map
+** hash of a cycle combines the last hashes of all stripes, so a different
+** field stays visible once its stripe was hashed again. A map desync is
+** therefore found up to MapStripes cycles late, at the cycle which hashed
+** the stripe of the different field.
+**
+** When the network finds a different ::SyncHash, the player asks the
+** others for their hashes of single cycles and bisects the range between
+** the last matching and the different cycle. The first different cycle
+** and the different parts are reported, and all players involved dump
+** the current state of these parts to "desync_of_stratagus_<player>.log".
+** Diffing these files shows the different objects.
+*/
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "synchash.h"
+
+#include "actions.h"
+#include "map.h"
+#include "missile.h"
+#include "network.h"
+#include "player.h"
+#include "unit.h"
+#include "unit_manager.h"
+#include "unittype.h"
+#include "version.h"
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+/**
+**  Bisection of the first cycle with a different state of a player.
+*/
+class CSyncBisection
+{
+public:
+	CSyncBisection() : Active(false), Low(0), High(0), Probe(0), Differences(0) {}
+
+public:
+	bool Active;               /// Bisection is running
+	unsigned long Low;         /// Last cycle known to be the same
+	unsigned long High;        /// First cycle known to be different
+	unsigned long Probe;       /// Cycle asked for
+	unsigned int Differences;  /// Different hashes at High
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+static const int SyncHashesHistory = 1024;  /// Number of cycles kept
+static const int MapStripes = 32;           /// Cycles to hash the whole map
+
+static CSyncHashes SyncHashesRing[SyncHashesHistory];  /// Hashes of the last cycles
+static unsigned int MapStripeHashes[MapStripes];       /// Last hash of each map stripe
+static unsigned long LastMatchedCycle;      /// Last cycle with the same SyncHash
+static unsigned long RequestLow;            /// Range asked for, last same cycle
+static unsigned long RequestHigh;           /// Range asked for, different cycle
+static bool DesyncDumped;                   /// State dumped, only the first desync counts
+static CSyncBisection SyncBisections[PlayerMax]; /// Bisection against each player
+
+unsigned long LastSyncHashesCycle;          /// Last game cycle hashed
+
+static const char *const SyncHashNames[SyncHashCount] = {
+	"units", "missiles", "players", "map", "random"
+};
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Rows of the map hashed at a game cycle.
+*/
+static void MapStripeRows(unsigned long cycle, int &first, int &last)
+{
+	const int rows = (Map.Info.MapHeight + MapStripes - 1) / MapStripes;
+
+	first = std::min<int>(Map.Info.MapHeight, (cycle % MapStripes) * rows);
+	last = std::min(Map.Info.MapHeight, first + rows);
+}
+
+static unsigned int HashUnits()
+{
+	CSyncHasher hasher;
+
+	for (unsigned int i = 0; i != UnitManager.GetUsedSlotCount(); ++i) {
+		const CUnit &unit = UnitManager.GetSlotUnit(i);
+
+		if (!unit.Type || unit.Destroyed) {
+			continue;
+		}
+		hasher.Add(i);
+		hasher.Add(unit.Type->Slot);
+		hasher.Add(unit.Player->Index);
+		hasher.Add(unit.tilePos.x);
+		hasher.Add(unit.tilePos.y);
+		hasher.Add(unit.IX);
+		hasher.Add(unit.IY);
+		hasher.Add(unit.Variable[HP_INDEX].Value);
+		hasher.Add(unit.Orders.empty() ? -1 : unit.CurrentAction());
+		hasher.Add(unit.Refs);
+		hasher.Add(unit.ResourcesHeld);
+	}
+	return hasher.Hash;
+}
+
+static unsigned int HashPlayers()
+{
+	CSyncHasher hasher;
+
+	for (int i = 0; i != NumPlayers; ++i) {
+		const CPlayer &player = Players[i];
+
+		for (int j = 0; j != MaxCosts; ++j) {
+			hasher.Add(player.Resources[j]);
+			hasher.Add(player.StoredResources[j]);
+		}
+		hasher.Add(player.GetUnitCount());
+		hasher.Add(player.NumBuildings);
+		hasher.Add(player.Supply);
+		hasher.Add(player.Demand);
+		hasher.Add(player.Score);
+	}
+	return hasher.Hash;
+}
+
+static unsigned int HashMapStripe(unsigned long cycle)
+{
+	CSyncHasher hasher;
+	int first;
+	int last;
+
+	MapStripeRows(cycle, first, last);
+	for (int y = first; y != last; ++y) {
+		for (int x = 0; x != Map.Info.MapWidth; ++x) {
+			const CMapField &mf = *Map.Field(x, y);
+
+			hasher.Add(mf.getFlag());
+			hasher.Add(mf.getGraphicTile());
+			hasher.Add(mf.Value);
+		}
+	}
+	return hasher.Hash;
+}
+
+/**
+**  Hash the stripe of the map of a game cycle and combine it with the
+**  last hashes of the other stripes.
+*/
+static unsigned int HashMap(unsigned long cycle)
+{
+	CSyncHasher hasher;
+
+	MapStripeHashes[cycle % MapStripes] = HashMapStripe(cycle);
+	for (int i = 0; i != MapStripes; ++i) {
+		hasher.Add(MapStripeHashes[i]);
+	}
+	return hasher.Hash;
+}
+
+/**
+**  Forget the hashes of the last game.
+*/
+void InitSyncHashes()
+{
+	for (int i = 0; i != SyncHashesHistory; ++i) {
+		SyncHashesRing[i] = CSyncHashes();
+	}
+	memset(MapStripeHashes, 0, sizeof(MapStripeHashes));
+	for (int i = 0; i != PlayerMax; ++i) {
+		SyncBisections[i] = CSyncBisection();
+	}
+	LastSyncHashesCycle = 0;
+	LastMatchedCycle = 0;
+	RequestLow = RequestHigh = 0;
+	DesyncDumped = false;
+}
+
+/**
+**  Hash the game state at the end of a game cycle, after the work done
+**  each second: this is the state the next network sync sends.
+*/
+void SyncHashesEachCycle()
+{
+	CSyncHashes &hashes = SyncHashesRing[GameCycle % SyncHashesHistory];
+
+	hashes.Cycle = GameCycle;
+	hashes.Hash[SyncHashUnits] = HashUnits();
+	CSyncHasher missiles;
+	HashGlobalMissiles(missiles);
+	hashes.Hash[SyncHashMissiles] = missiles.Hash;
+	hashes.Hash[SyncHashPlayers] = HashPlayers();
+	hashes.Hash[SyncHashMap] = HashMap(GameCycle);
+	hashes.Hash[SyncHashRandom] = SyncRandSeed;
+	LastSyncHashesCycle = GameCycle;
+}
+
+/**
+**  Get the hashes of a recent game cycle.
+**
+**  @return  The hashes, NULL if the cycle is too old or not hashed.
+*/
+const CSyncHashes *GetSyncHashes(unsigned long cycle)
+{
+	const CSyncHashes &hashes = SyncHashesRing[cycle % SyncHashesHistory];
+
+	return hashes.Cycle == cycle && cycle <= GameCycle ? &hashes : NULL;
+}
+
+/**
+**  Dump the current state of the different parts.
+**
+**  @param cycle        First cycle with a different state.
+**  @param differences  Bit mask of the different parts.
+*/
+static void DumpSyncState(unsigned long cycle, unsigned int differences)
+{
+	char filename[64];
+
+	snprintf(filename, sizeof(filename), "desync_of_stratagus_%d.log", ThisPlayer->Index);
+	FILE *file = fopen(filename, "wb");
+	if (!file) {
+		return;
+	}
+	fprintf(file, "; Desync dump generated by Stratagus Version " VERSION "\n");
+	fprintf(file, "; First different cycle %lu, dumped at cycle %lu\n", cycle, GameCycle);
+	if (!differences) {
+		// Only the SyncHash was different, dump all
+		differences = ~0u;
+	}
+	if (differences & (1 << SyncHashUnits)) {
+		for (unsigned int i = 0; i != UnitManager.GetUsedSlotCount(); ++i) {
+			const CUnit &unit = UnitManager.GetSlotUnit(i);
+
+			if (!unit.Type || unit.Destroyed) {
+				continue;
+			}
+			fprintf(file, "unit %u %s P%d %d,%d %d,%d hp %d action %d refs %u resources %d\n",
+					i, unit.Type->Ident.c_str(), unit.Player->Index,
+					unit.tilePos.x, unit.tilePos.y, unit.IX, unit.IY,
+					unit.Variable[HP_INDEX].Value, unit.Orders.empty() ? -1 : unit.CurrentAction(),
+					unit.Refs, unit.ResourcesHeld);
+		}
+	}
+	if (differences & (1 << SyncHashMissiles)) {
+		DumpGlobalMissiles(file);
+	}
+	if (differences & (1 << SyncHashPlayers)) {
+		for (int i = 0; i != NumPlayers; ++i) {
+			const CPlayer &player = Players[i];
+
+			fprintf(file, "player %d resources", i);
+			for (int j = 0; j != MaxCosts; ++j) {
+				fprintf(file, " %d/%d", player.Resources[j], player.StoredResources[j]);
+			}
+			fprintf(file, " units %d buildings %d supply %d demand %d score %d\n",
+					player.GetUnitCount(), player.NumBuildings, player.Supply,
+					player.Demand, player.Score);
+		}
+	}
+	if (differences & (1 << SyncHashMap)) {
+		int first;
+		int last;
+
+		MapStripeRows(cycle, first, last);
+		for (int y = first; y != last; ++y) {
+			for (int x = 0; x != Map.Info.MapWidth; ++x) {
+				const CMapField &mf = *Map.Field(x, y);
+
+				fprintf(file, "field %d,%d flags %04x tile %u value %d\n",
+						x, y, mf.getFlag(), mf.getGraphicTile(), mf.Value);
+			}
+		}
+	}
+	if (differences & (1 << SyncHashRandom)) {
+		fprintf(file, "random %u\n", SyncRandSeed);
+	}
+	fclose(file);
+	fprintf(stderr, "Desync state dumped to %s\n", filename);
+}
+
+/**
+**  Report the first different cycle found against a player.
+*/
+static void ReportDesync(int player, unsigned long cycle, unsigned int differences)
+{
+	std::string parts;
+
+	for (int i = 0; i != SyncHashCount; ++i) {
+		if (differences & (1 << i)) {
+			parts += parts.empty() ? "" : ", ";
+			parts += SyncHashNames[i];
+		}
+	}
+	fprintf(stderr, "Desync with player %d at cycle %lu: %s\n",
+			player, cycle, parts.empty() ? "SyncHash only" : parts.c_str());
+	if (!DesyncDumped) {
+		DesyncDumped = true;
+		DumpSyncState(cycle, differences);
+	}
+}
+
+/**
+**  Ask the other players for their hashes of a cycle.
+*/
+static void RequestSyncHashes(unsigned long cycle)
+{
+	const CSyncHashes *hashes = GetSyncHashes(cycle);
+
+	if (hashes) {
+		NetworkSendSyncHashes(SyncHashesRequest, *hashes);
+	}
+}
+
+/**
+**  The state of all players was the same at a cycle.
+*/
+void SyncHashesMatched(unsigned long cycle)
+{
+	LastMatchedCycle = std::max(LastMatchedCycle, cycle);
+}
+
+/**
+**  The state of another player was different at a cycle.
+**
+**  Starts the bisection of the first different cycle, unless one runs.
+*/
+void SyncHashesMismatch(unsigned long cycle)
+{
+	if (DesyncDumped || RequestHigh) {
+		return;
+	}
+	// Keep some history for the requests during the bisection.
+	const unsigned long oldest = GameCycle > SyncHashesHistory * 3 / 4 ? GameCycle - SyncHashesHistory * 3 / 4 : 0;
+
+	RequestLow = std::max(LastMatchedCycle, oldest);
+	RequestHigh = cycle;
+	DebugPrint("Bisecting desync between cycle %lu and %lu\n" _C_ RequestLow _C_ RequestHigh);
+	RequestSyncHashes(cycle);
+}
+
+/**
+**  Compare the hashes of a player with ours and continue the bisection.
+*/
+static void ContinueBisection(int player, const CSyncHashes &theirs)
+{
+	CSyncBisection &bisection = SyncBisections[player];
+
+	if (!bisection.Active) {
+		if (theirs.Cycle != RequestHigh) {
+			return;
+		}
+		bisection.Active = true;
+		bisection.Low = RequestLow;
+		bisection.High = RequestHigh;
+		bisection.Probe = RequestHigh;
+	}
+	const CSyncHashes *ours = GetSyncHashes(theirs.Cycle);
+	if (theirs.Cycle != bisection.Probe || !ours) {
+		return;
+	}
+	const unsigned int differences = ours->Differences(theirs);
+	if (differences || bisection.Probe == bisection.High) {
+		bisection.High = bisection.Probe;
+		bisection.Differences = differences;
+	} else {
+		bisection.Low = bisection.Probe;
+	}
+	if (bisection.High - bisection.Low <= 1) {
+		bisection.Active = false;
+		ReportDesync(player, bisection.High, bisection.Differences);
+		if (const CSyncHashes *hashes = GetSyncHashes(bisection.High)) {
+			NetworkSendSyncHashes(SyncHashesDump, *hashes);
+		}
+		return;
+	}
+	bisection.Probe = bisection.Low + (bisection.High - bisection.Low) / 2;
+	RequestSyncHashes(bisection.Probe);
+}
+
+/**
+**  Handle sync hashes received from another player.
+**
+**  @param player  Player who sent the hashes.
+**  @param flags   What the player wants, see ::SyncHashesFlags.
+**  @param hashes  Hashes of the player.
+*/
+void SyncHashesReceived(int player, int flags, const CSyncHashes &hashes)
+{
+	if (player == ThisPlayer->Index) {
+		return;
+	}
+	const CSyncHashes *ours = GetSyncHashes(hashes.Cycle);
+
+	switch (flags) {
+		case SyncHashesRequest:
+			if (ours) {
+				NetworkSendSyncHashes(SyncHashesAnswer, *ours);
+			}
+			break;
+		case SyncHashesAnswer:
+			if (RequestHigh) {
+				ContinueBisection(player, hashes);
+			}
+			break;
+		case SyncHashesDump:
+			if (ours) {
+				ReportDesync(player, hashes.Cycle, ours->Differences(hashes));
+			}
+			break;
+	}
+}
+
+//@}
@@ -33,6 +33,9 @@
 --  Includes
 ----------------------------------------------------------------------------*/
 
+#include <limits.h>
+#include <algorithm>
+
 #include "stratagus.h"
 
 #include "trigger.h"
@@ -43,6 +46,7 @@
 #include "player.h"
 #include "results.h"
 #include "script.h"
+#include "synchash.h"
 #include "unit.h"
 #include "unit_find.h"
 #include "unittype.h"
@@ -55,6 +59,43 @@ CTimer GameTimer;               /// The game timer
 static int Trigger;
 static bool *ActiveTriggers;
 
+/**
+**  Parts of the game state a trigger condition can depend on.
+*/
+enum TriggerDependency {
+	TriggerDependencyUnits,      /// Unit counts of the players
+	TriggerDependencyResources,  /// Resources of the players
+	TriggerDependencyTimer,      /// The game timer
+	TriggerDependencyMap,        /// Units moved or the terrain changed
+	TriggerDependencyCount
+};
+
+static const char *TriggerDependencyNames[TriggerDependencyCount] = {
+	"units", "resources", "timer", "map"
+};
+
+/**
+**  A trigger whose condition is only checked when needed, instead of
+**  in turn with the other triggers.
+*/
+class CTriggerSchedule
+{
+public:
+	CTriggerSchedule() : Trigger(0), Dependencies(0), Cycle(0), Interval(0), Pending(false) {}
+
+	int Trigger;           /// Index of the condition in _triggers_
+	int Dependencies;      /// Bit mask of the TriggerDependency of the condition
+	unsigned long Cycle;   /// Check the condition at this game cycle, 0 if none
+	int Interval;          /// Check the condition every Interval game cycles, 0 if none
+	bool Pending;          /// Check the condition at the next game cycle
+};
+
+static std::vector<CTriggerSchedule> ScheduledTriggers;  /// Triggers not checked in turn
+static std::vector<bool> IsScheduledTrigger;             /// Scheduled state by trigger number
+static unsigned int DependencyHashes[TriggerDependencyCount]; /// State at the last check
+static unsigned long TriggerUnitsChangeCount;            /// PlayerUnitsChangeCount at the last check
+static unsigned long TriggerMapChangeCount;              /// Map.ChangeCount at the last check
+
 /// Some data accessible for script during the game.
 TriggerDataType TriggerData;
 
@@ -154,22 +195,17 @@ static CompareFunction GetCompareFunction(const char *op)
 }
 
 /**
-**  Return the number of units of a given unit-type and player at a location.
+**  Get the number of units of a given unit-type and player at a location.
+**
+**  @param plynr     Player number, -1 matches any.
+**  @param unittype  Unit-type, or ANY_UNIT, ALL_FOODUNITS, ALL_BUILDINGS.
+**  @param minPos    Top left tile of the location.
+**  @param maxPos    Bottom right tile of the location.
+**
+**  @return          The number of alive units.
 */
-static int CclGetNumUnitsAt(lua_State *l)
+static int GetNumUnitsAt(int plynr, const CUnitType *unittype, const Vec2i &minPos, const Vec2i &maxPos)
 {
-	LuaCheckArgs(l, 4);
-
-	int plynr = LuaToNumber(l, 1);
-	lua_pushvalue(l, 2);
-	const CUnitType *unittype = TriggerGetUnitType(l);
-	lua_pop(l, 1);
-
-	Vec2i minPos;
-	Vec2i maxPos;
-	CclGetPos(l, &minPos.x, &minPos.y, 3);
-	CclGetPos(l, &maxPos.x, &maxPos.y, 4);
-
 	std::vector<CUnit *> units;
 
 	Select(minPos, maxPos, units);
@@ -192,40 +228,50 @@ static int CclGetNumUnitsAt(lua_State *l)
 			}
 		}
 	}
-	lua_pushnumber(l, s);
-	return 1;
+	return s;
 }
 
 /**
-**  Player has the quantity of unit-type near to unit-type.
+**  Return the number of units of a given unit-type and player at a location.
 */
-static int CclIfNearUnit(lua_State *l)
+static int CclGetNumUnitsAt(lua_State *l)
 {
-	LuaCheckArgs(l, 5);
-	lua_pushvalue(l, 1);
-	const int plynr = TriggerGetPlayer(l);
-	lua_pop(l, 1);
-	const char *op = LuaToString(l, 2);
-	const int q = LuaToNumber(l, 3);
-	lua_pushvalue(l, 4);
+	LuaCheckArgs(l, 4);
+
+	int plynr = LuaToNumber(l, 1);
+	lua_pushvalue(l, 2);
 	const CUnitType *unittype = TriggerGetUnitType(l);
 	lua_pop(l, 1);
-	const CUnitType *ut2 = CclGetUnitType(l);
-	if (!unittype || !ut2) {
-		LuaError(l, "CclIfNearUnit: not a unit-type valid");
-	}
-	CompareFunction compare = GetCompareFunction(op);
-	if (!compare) {
-		LuaError(l, "Illegal comparison operation in if-near-unit: %s" _C_ op);
-	}
 
+	Vec2i minPos;
+	Vec2i maxPos;
+	CclGetPos(l, &minPos.x, &minPos.y, 3);
+	CclGetPos(l, &maxPos.x, &maxPos.y, 4);
+
+	lua_pushnumber(l, GetNumUnitsAt(plynr, unittype, minPos, maxPos));
+	return 1;
+}
+
+/**
+**  Check if the player has the quantity of unit-type near to unit-type.
+**
+**  @param plynr     Player number, -1 matches any.
+**  @param compare   Comparison of the number of units with the quantity.
+**  @param q         Quantity.
+**  @param unittype  Unit-type, or ANY_UNIT, ALL_FOODUNITS, ALL_BUILDINGS.
+**  @param ut2       Unit-type of the units to be near to.
+**
+**  @return          true if the comparison is true near one unit of ut2.
+*/
+static bool IfNearUnit(int plynr, CompareFunction compare, int q, const CUnitType *unittype, const CUnitType &ut2)
+{
 	//
 	// Get all unit types 'near'.
 	//
 
 	std::vector<CUnit *> unitsOfType;
 
-	FindUnitsByType(*ut2, unitsOfType);
+	FindUnitsByType(ut2, unitsOfType);
 	for (size_t i = 0; i != unitsOfType.size(); ++i) {
 		const CUnit &centerUnit = *unitsOfType[i];
 
@@ -250,11 +296,35 @@ static int CclIfNearUnit(lua_State *l)
 			}
 		}
 		if (compare(s, q)) {
-			lua_pushboolean(l, 1);
-			return 1;
+			return true;
 		}
 	}
-	lua_pushboolean(l, 0);
+	return false;
+}
+
+/**
+**  Player has the quantity of unit-type near to unit-type.
+*/
+static int CclIfNearUnit(lua_State *l)
+{
+	LuaCheckArgs(l, 5);
+	lua_pushvalue(l, 1);
+	const int plynr = TriggerGetPlayer(l);
+	lua_pop(l, 1);
+	const char *op = LuaToString(l, 2);
+	const int q = LuaToNumber(l, 3);
+	lua_pushvalue(l, 4);
+	const CUnitType *unittype = TriggerGetUnitType(l);
+	lua_pop(l, 1);
+	const CUnitType *ut2 = CclGetUnitType(l);
+	if (!unittype || !ut2) {
+		LuaError(l, "CclIfNearUnit: not a unit-type valid");
+	}
+	CompareFunction compare = GetCompareFunction(op);
+	if (!compare) {
+		LuaError(l, "Illegal comparison operation in if-near-unit: %s" _C_ op);
+	}
+	lua_pushboolean(l, IfNearUnit(plynr, compare, q, unittype, *ut2));
 	return 1;
 }
 
@@ -356,6 +426,387 @@ int GetTimer()
 	return GameTimer.Cycles;
 }
 
+/*---------------------------------------------------------------------------
+-- Native conditions
+---------------------------------------------------------------------------*/
+
+/**
+**  Trigger condition declared in a table and checked without calling Lua.
+*/
+class CTriggerCondition
+{
+public:
+	virtual ~CTriggerCondition() {}
+	/// Check if the condition is true
+	virtual bool Check() const = 0;
+	/// Bit mask of the TriggerDependency of the condition
+	virtual int Dependencies() const = 0;
+};
+
+/// Player of a native condition given as "this", resolved when checked
+static const int TriggerPlayerThis = -2;
+
+/**
+**  Get the player number of a native condition.
+**
+**  @param player  Player number, -1 matches any, or TriggerPlayerThis.
+*/
+static int TriggerConditionPlayer(int player)
+{
+	return player == TriggerPlayerThis ? ThisPlayer->Index : player;
+}
+
+/// Watch the units of the type on the whole map
+CTriggerArea::CTriggerArea(const CUnitType *type) :
+	Type(type), MinPos(0, 0), MaxPos(SHRT_MAX, SHRT_MAX), ChangeCount(1)
+{
+	Areas.push_back(this);
+}
+
+/// Watch the units of the type between minPos and maxPos
+CTriggerArea::CTriggerArea(const CUnitType *type, const Vec2i &minPos, const Vec2i &maxPos) :
+	Type(type), MinPos(minPos), MaxPos(maxPos), ChangeCount(1)
+{
+	Areas.push_back(this);
+}
+
+CTriggerArea::~CTriggerArea()
+{
+	Areas.erase(std::find(Areas.begin(), Areas.end(), this));
+}
+
+/**
+**  Check if the unit is one of the watched units.
+**
+**  @param unit  Unit to check.
+*/
+bool CTriggerArea::Matches(const CUnit &unit) const
+{
+	const CUnitType &type = *unit.Type;
+
+	if (!(Type == ANY_UNIT
+		  || (Type == ALL_FOODUNITS && !type.Building)
+		  || (Type == ALL_BUILDINGS && type.Building)
+		  || Type == &type)) {
+		return false;
+	}
+	return unit.tilePos.x <= MaxPos.x && unit.tilePos.x + type.TileWidth > MinPos.x
+		   && unit.tilePos.y <= MaxPos.y && unit.tilePos.y + type.TileHeight > MinPos.y;
+}
+
+std::vector<CTriggerArea *> CTriggerArea::Areas;
+
+/**
+**  Note that a unit was inserted into or removed from the map.
+**
+**  Called by CMap::Insert and CMap::Remove.
+**
+**  @param unit  Unit inserted or removed.
+*/
+void TriggerAreasUnitChanged(const CUnit &unit)
+{
+	for (size_t i = 0; i != CTriggerArea::Areas.size(); ++i) {
+		CTriggerArea &area = *CTriggerArea::Areas[i];
+
+		if (area.Matches(unit)) {
+			++area.ChangeCount;
+		}
+	}
+}
+
+/**
+**  {"units-at", player, unit, {x1, y1}, {x2, y2}, op, quantity}
+**
+**  The units are only counted again when the area or the unit counts of
+**  the players changed since the last check.
+*/
+class CTriggerConditionUnitsAt : public CTriggerCondition
+{
+public:
+	CTriggerConditionUnitsAt(int player, const CUnitType *type, const Vec2i &minPos, const Vec2i &maxPos) :
+		Player(player), Type(type), MinPos(minPos), MaxPos(maxPos), Compare(NULL), Quantity(0),
+		Area(type, minPos, maxPos), AreaChangeCount(0), UnitsChangeCount(0), Count(0) {}
+
+	virtual bool Check() const
+	{
+		if (AreaChangeCount != Area.ChangeCount || UnitsChangeCount != PlayerUnitsChangeCount) {
+			AreaChangeCount = Area.ChangeCount;
+			UnitsChangeCount = PlayerUnitsChangeCount;
+			Count = GetNumUnitsAt(TriggerConditionPlayer(Player), Type, MinPos, MaxPos);
+		}
+		return Compare(Count, Quantity);
+	}
+	virtual int Dependencies() const { return (1 << TriggerDependencyUnits) | (1 << TriggerDependencyMap); }
+
+	int Player;               /// Player number, -1 matches any
+	const CUnitType *Type;    /// Unit-type, or ANY_UNIT, ALL_FOODUNITS, ALL_BUILDINGS
+	Vec2i MinPos;             /// Top left tile of the location
+	Vec2i MaxPos;             /// Bottom right tile of the location
+	CompareFunction Compare;  /// Comparison of the number of units with Quantity
+	int Quantity;             /// Quantity to compare with
+private:
+	CTriggerArea Area;                       /// The location
+	mutable unsigned long AreaChangeCount;   /// Area.ChangeCount when Count was computed
+	mutable unsigned long UnitsChangeCount;  /// PlayerUnitsChangeCount when Count was computed
+	mutable int Count;                       /// Number of units at the location
+};
+
+/**
+**  {"unit-types-count", player, unit, op, quantity}
+*/
+class CTriggerConditionUnitTypesCount : public CTriggerCondition
+{
+public:
+	virtual bool Check() const
+	{
+		const int player = TriggerConditionPlayer(Player);
+
+		if (player != -1) {
+			return Compare(Players[player].UnitTypesCount[Type->Slot], Quantity);
+		}
+		int count = 0;
+		for (int i = 0; i != PlayerMax; ++i) {
+			count += Players[i].UnitTypesCount[Type->Slot];
+		}
+		return Compare(count, Quantity);
+	}
+	virtual int Dependencies() const { return 1 << TriggerDependencyUnits; }
+
+	int Player;               /// Player number, -1 matches any
+	const CUnitType *Type;    /// Unit-type to count
+	CompareFunction Compare;  /// Comparison of the number of units with Quantity
+	int Quantity;             /// Quantity to compare with
+};
+
+/**
+**  {"near-unit", player, op, quantity, unit1, unit2}
+**
+**  The units are only looked at again when a unit of one of the two
+**  unit-types moved or the unit counts of the players changed since the
+**  last check.
+*/
+class CTriggerConditionNearUnit : public CTriggerCondition
+{
+public:
+	CTriggerConditionNearUnit(const CUnitType *type, const CUnitType &nearType) :
+		Player(-1), Compare(NULL), Quantity(0), Type(type), NearType(&nearType),
+		TypeArea(type), NearTypeArea(&nearType),
+		TypeChangeCount(0), NearTypeChangeCount(0), UnitsChangeCount(0), Result(false) {}
+
+	virtual bool Check() const
+	{
+		if (TypeChangeCount != TypeArea.ChangeCount || NearTypeChangeCount != NearTypeArea.ChangeCount
+			|| UnitsChangeCount != PlayerUnitsChangeCount) {
+			TypeChangeCount = TypeArea.ChangeCount;
+			NearTypeChangeCount = NearTypeArea.ChangeCount;
+			UnitsChangeCount = PlayerUnitsChangeCount;
+			Result = IfNearUnit(TriggerConditionPlayer(Player), Compare, Quantity, Type, *NearType);
+		}
+		return Result;
+	}
+	virtual int Dependencies() const { return (1 << TriggerDependencyUnits) | (1 << TriggerDependencyMap); }
+
+	int Player;                 /// Player number, -1 matches any
+	CompareFunction Compare;    /// Comparison of the number of units with Quantity
+	int Quantity;               /// Quantity to compare with
+	const CUnitType *Type;      /// Unit-type, or ANY_UNIT, ALL_FOODUNITS, ALL_BUILDINGS
+	const CUnitType *NearType;  /// Unit-type of the units to be near to
+private:
+	CTriggerArea TypeArea;                      /// Units of Type on the whole map
+	CTriggerArea NearTypeArea;                  /// Units of NearType on the whole map
+	mutable unsigned long TypeChangeCount;      /// TypeArea.ChangeCount when Result was computed
+	mutable unsigned long NearTypeChangeCount;  /// NearTypeArea.ChangeCount when Result was computed
+	mutable unsigned long UnitsChangeCount;     /// PlayerUnitsChangeCount when Result was computed
+	mutable bool Result;                        /// Result of the last check
+};
+
+/**
+**  {"timer", op, cycles}
+*/
+class CTriggerConditionTimer : public CTriggerCondition
+{
+public:
+	virtual bool Check() const { return Compare(GetTimer(), Cycles); }
+	virtual int Dependencies() const { return 1 << TriggerDependencyTimer; }
+
+	CompareFunction Compare;  /// Comparison of the timer with Cycles
+	int Cycles;               /// Cycles to compare with
+};
+
+/**
+**  {{condition}, {condition}, ...}, true if all conditions are true.
+*/
+class CTriggerConditionAnd : public CTriggerCondition
+{
+public:
+	virtual ~CTriggerConditionAnd()
+	{
+		for (size_t i = 0; i != Conditions.size(); ++i) {
+			delete Conditions[i];
+		}
+	}
+	virtual bool Check() const
+	{
+		for (size_t i = 0; i != Conditions.size(); ++i) {
+			if (!Conditions[i]->Check()) {
+				return false;
+			}
+		}
+		return true;
+	}
+	virtual int Dependencies() const
+	{
+		int dependencies = 0;
+		for (size_t i = 0; i != Conditions.size(); ++i) {
+			dependencies |= Conditions[i]->Dependencies();
+		}
+		return dependencies;
+	}
+
+	std::vector<CTriggerCondition *> Conditions;  /// Conditions which must be true
+};
+
+static std::vector<CTriggerCondition *> NativeConditions;  /// Native condition by trigger number
+
+/**
+**  Get the comparison function of a trigger condition.
+**
+**  @param l      Lua state.
+**  @param index  Index of the operation in the condition table on top of the stack.
+*/
+static CompareFunction CclGetTriggerCompare(lua_State *l, int index)
+{
+	const char *op = LuaToString(l, -1, index);
+	CompareFunction compare = GetCompareFunction(op);
+
+	if (!compare) {
+		LuaError(l, "Illegal comparison operation in trigger condition: %s" _C_ op);
+	}
+	return compare;
+}
+
+/**
+**  Get the player of a trigger condition.
+**
+**  "this" is kept as TriggerPlayerThis and resolved each time the
+**  condition is checked, ThisPlayer is not known yet for the triggers of
+**  a map or a saved game.
+**
+**  @param l      Lua state.
+**  @param index  Index of the player in the condition table on top of the stack.
+*/
+static int CclGetTriggerPlayer(lua_State *l, int index)
+{
+	lua_rawgeti(l, -1, index);
+	if (lua_isstring(l, -1) && !lua_isnumber(l, -1) && !strcmp(lua_tostring(l, -1), "this")) {
+		lua_pop(l, 1);
+		return TriggerPlayerThis;
+	}
+	const int player = TriggerGetPlayer(l);
+	lua_pop(l, 1);
+	if (player >= PlayerMax) {
+		LuaError(l, "bad player: %d" _C_ player);
+	}
+	return player;
+}
+
+/**
+**  Get a unit-type of a trigger condition.
+**
+**  @param l        Lua state.
+**  @param index    Index of the unit-type in the condition table on top of the stack.
+**  @param special  Accept ANY_UNIT, ALL_FOODUNITS and ALL_BUILDINGS.
+*/
+static const CUnitType *CclGetTriggerUnitType(lua_State *l, int index, bool special)
+{
+	lua_rawgeti(l, -1, index);
+	const CUnitType *type = special ? TriggerGetUnitType(l) : CclGetUnitType(l);
+	lua_pop(l, 1);
+	if (!type && !special) {
+		LuaError(l, "not a valid unit-type in trigger condition");
+	}
+	return type;
+}
+
+/**
+**  Parse a native trigger condition.
+**
+**  @param l  Lua state, the condition table is on top of the stack.
+**
+**  @return   The new condition.
+*/
+static CTriggerCondition *CclParseTriggerCondition(lua_State *l)
+{
+	if (!lua_istable(l, -1)) {
+		LuaError(l, "incorrect argument");
+	}
+	const int args = lua_rawlen(l, -1);
+
+	lua_rawgeti(l, -1, 1);
+	const bool isList = lua_istable(l, -1);
+	lua_pop(l, 1);
+	if (isList) {
+		CTriggerConditionAnd *condition = new CTriggerConditionAnd;
+		for (int j = 0; j < args; ++j) {
+			lua_rawgeti(l, -1, j + 1);
+			condition->Conditions.push_back(CclParseTriggerCondition(l));
+			lua_pop(l, 1);
+		}
+		return condition;
+	}
+	const char *value = LuaToString(l, -1, 1);
+	if (!strcmp(value, "units-at")) {
+		if (args != 7) {
+			LuaError(l, "incorrect argument");
+		}
+		const int player = CclGetTriggerPlayer(l, 2);
+		const CUnitType *type = CclGetTriggerUnitType(l, 3, true);
+		Vec2i minPos;
+		Vec2i maxPos;
+		lua_rawgeti(l, -1, 4);
+		CclGetPos(l, &minPos.x, &minPos.y);
+		lua_pop(l, 1);
+		lua_rawgeti(l, -1, 5);
+		CclGetPos(l, &maxPos.x, &maxPos.y);
+		lua_pop(l, 1);
+		CTriggerConditionUnitsAt *condition = new CTriggerConditionUnitsAt(player, type, minPos, maxPos);
+		condition->Compare = CclGetTriggerCompare(l, 6);
+		condition->Quantity = LuaToNumber(l, -1, 7);
+		return condition;
+	} else if (!strcmp(value, "unit-types-count")) {
+		if (args != 5) {
+			LuaError(l, "incorrect argument");
+		}
+		CTriggerConditionUnitTypesCount *condition = new CTriggerConditionUnitTypesCount;
+		condition->Player = CclGetTriggerPlayer(l, 2);
+		condition->Type = CclGetTriggerUnitType(l, 3, false);
+		condition->Compare = CclGetTriggerCompare(l, 4);
+		condition->Quantity = LuaToNumber(l, -1, 5);
+		return condition;
+	} else if (!strcmp(value, "near-unit")) {
+		if (args != 6) {
+			LuaError(l, "incorrect argument");
+		}
+		const CUnitType *type = CclGetTriggerUnitType(l, 5, true);
+		const CUnitType *nearType = CclGetTriggerUnitType(l, 6, false);
+		CTriggerConditionNearUnit *condition = new CTriggerConditionNearUnit(type, *nearType);
+		condition->Player = CclGetTriggerPlayer(l, 2);
+		condition->Compare = CclGetTriggerCompare(l, 3);
+		condition->Quantity = LuaToNumber(l, -1, 4);
+		return condition;
+	} else if (!strcmp(value, "timer")) {
+		if (args != 3) {
+			LuaError(l, "incorrect argument");
+		}
+		CTriggerConditionTimer *condition = new CTriggerConditionTimer;
+		condition->Compare = CclGetTriggerCompare(l, 2);
+		condition->Cycles = LuaToNumber(l, -1, 3);
+		return condition;
+	}
+	LuaError(l, "Unsupported trigger condition: %s" _C_ value);
+	return NULL;
+}
+
 /*---------------------------------------------------------------------------
 -- Actions
 ---------------------------------------------------------------------------*/
@@ -422,16 +873,81 @@ void ActionStopTimer()
 	GameTimer.Running = false;
 }
 
+/**
+**  Parse the dependencies of a trigger condition.
+**
+**  @param l         Lua state.
+**  @param schedule  Schedule to fill.
+*/
+static void CclTriggerDependencies(lua_State *l, CTriggerSchedule &schedule)
+{
+	if (!lua_istable(l, -1)) {
+		LuaError(l, "incorrect argument");
+	}
+	const int args = lua_rawlen(l, -1);
+	for (int j = 0; j < args; ++j) {
+		const char *value = LuaToString(l, -1, j + 1);
+
+		if (!strcmp(value, "cycle")) {
+			++j;
+			schedule.Cycle = LuaToNumber(l, -1, j + 1);
+			continue;
+		} else if (!strcmp(value, "interval")) {
+			++j;
+			schedule.Interval = LuaToNumber(l, -1, j + 1);
+			if (schedule.Interval < 1) {
+				LuaError(l, "interval must be positive");
+			}
+			continue;
+		}
+		int dependency = 0;
+		while (dependency != TriggerDependencyCount && strcmp(value, TriggerDependencyNames[dependency])) {
+			++dependency;
+		}
+		if (dependency == TriggerDependencyCount) {
+			LuaError(l, "Unsupported trigger dependency: %s" _C_ value);
+		}
+		schedule.Dependencies |= 1 << dependency;
+	}
+	if (!schedule.Dependencies && !schedule.Cycle && !schedule.Interval) {
+		LuaError(l, "The trigger would never be checked");
+	}
+	// Check the condition once with the current state.
+	schedule.Pending = schedule.Dependencies != 0;
+	if (schedule.Cycle && schedule.Cycle <= GameCycle) {
+		schedule.Cycle = 0;
+		schedule.Pending = true;
+	}
+}
+
 /**
 **  Add a trigger.
 */
 static int CclAddTrigger(lua_State *l)
 {
-	LuaCheckArgs(l, 2);
-	if (!lua_isfunction(l, 1)
+	const int nargs = lua_gettop(l);
+	if (nargs != 2 && nargs != 3) {
+		LuaError(l, "incorrect argument");
+	}
+	if ((!lua_isfunction(l, 1) && !lua_istable(l, 1))
 		|| (!lua_isfunction(l, 2) && !lua_istable(l, 2))) {
 		LuaError(l, "incorrect argument");
 	}
+	CTriggerSchedule schedule;
+	if (nargs == 3) {
+		lua_pushvalue(l, 3);
+		CclTriggerDependencies(l, schedule);
+		lua_pop(l, 1);
+	}
+	CTriggerCondition *condition = NULL;
+	if (lua_istable(l, 1)) {
+		lua_pushvalue(l, 1);
+		condition = CclParseTriggerCondition(l);
+		lua_pop(l, 1);
+		// A native condition knows what it depends on.
+		schedule.Dependencies |= condition->Dependencies();
+		schedule.Pending = true;
+	}
 
 	// Make a list of all triggers.
 	// A trigger is a pair of condition and action
@@ -451,6 +967,7 @@ static int CclAddTrigger(lua_State *l)
 		lua_rawseti(l, -2, i + 1);
 		lua_pushnil(l);
 		lua_rawseti(l, -2, i + 2);
+		delete condition;
 	} else {
 		lua_pushvalue(l, 1);
 		lua_rawseti(l, -2, i + 1);
@@ -458,6 +975,21 @@ static int CclAddTrigger(lua_State *l)
 		lua_pushvalue(l, 2);
 		lua_rawseti(l, -2, 1);
 		lua_rawseti(l, -2, i + 2);
+
+		if (condition) {
+			if (NativeConditions.size() <= size_t(i / 2)) {
+				NativeConditions.resize(i / 2 + 1, NULL);
+			}
+			NativeConditions[i / 2] = condition;
+		}
+		if (nargs == 3 || condition) {
+			schedule.Trigger = i;
+			ScheduledTriggers.push_back(schedule);
+			if (IsScheduledTrigger.size() <= size_t(i / 2)) {
+				IsScheduledTrigger.resize(i / 2 + 1, false);
+			}
+			IsScheduledTrigger[i / 2] = true;
+		}
 	}
 	lua_pop(l, 1);
 
@@ -472,6 +1004,42 @@ void SetTrigger(int trigger)
 	Trigger = trigger;
 }
 
+/**
+**  Set the state of the trigger scheduling of a saved game
+*/
+static int CclSetTriggerSchedule(lua_State *l)
+{
+	LuaCheckArgs(l, 5);
+	TriggerUnitsChangeCount = PlayerUnitsChangeCount - (LuaToBoolean(l, 1) ? 1 : 0);
+	for (int i = TriggerDependencyResources; i != TriggerDependencyMap; ++i) {
+		DependencyHashes[i] = LuaToUnsignedNumber(l, i + 1);
+	}
+	TriggerMapChangeCount = Map.ChangeCount - (LuaToBoolean(l, 4) ? 1 : 0);
+
+	for (size_t i = 0; i != ScheduledTriggers.size(); ++i) {
+		CTriggerSchedule &schedule = ScheduledTriggers[i];
+
+		schedule.Pending = false;
+		if (schedule.Cycle <= GameCycle) {
+			schedule.Cycle = 0;
+		}
+	}
+	if (!lua_istable(l, 5)) {
+		LuaError(l, "incorrect argument");
+	}
+	const int args = lua_rawlen(l, 5);
+	for (int j = 0; j < args; ++j) {
+		const int trigger = LuaToNumber(l, 5, j + 1);
+
+		for (size_t i = 0; i != ScheduledTriggers.size(); ++i) {
+			if (ScheduledTriggers[i].Trigger == trigger) {
+				ScheduledTriggers[i].Pending = true;
+			}
+		}
+	}
+	return 0;
+}
+
 /**
 **  Set the active triggers
 */
@@ -530,12 +1098,157 @@ static void TriggerRemoveTrigger(int trig)
 }
 
 /**
-**  Check trigger each game cycle.
+**  Check the condition of a trigger and execute its action if true.
+**
+**  @param trig  Trigger to check, _triggers_ must be on top of the stack
+**
+**  @return      true if the trigger was removed
 */
-void TriggersEachCycle()
+static bool TriggerCheckCondition(int trig)
 {
 	const int base = lua_gettop(Lua);
+	CTriggerCondition *condition = size_t(trig / 2) < NativeConditions.size() ? NativeConditions[trig / 2] : NULL;
+	bool passed;
+
+	if (condition) {
+		passed = condition->Check();
+	} else {
+		lua_rawgeti(Lua, -1, trig + 1);
+		LuaCall(0, 0);
+		passed = lua_gettop(Lua) > base && lua_toboolean(Lua, -1);
+		lua_settop(Lua, base);
+	}
+	// If condition is true execute action
+	bool removed = false;
+	if (passed && TriggerExecuteAction(trig + 1)) {
+		TriggerRemoveTrigger(trig);
+		if (condition) {
+			delete condition;
+			NativeConditions[trig / 2] = NULL;
+		}
+		removed = true;
+	}
+	lua_settop(Lua, base);
+	return removed;
+}
+
+/**
+**  Hash the part of the game state a trigger condition depends on.
+**
+**  The units and the map have change counters instead.
+**
+**  @param dependency  TriggerDependencyResources or TriggerDependencyTimer.
+*/
+static unsigned int HashTriggerDependency(int dependency)
+{
+	CSyncHasher hasher;
+
+	switch (dependency) {
+		case TriggerDependencyResources:
+			for (int i = 0; i != NumPlayers; ++i) {
+				const CPlayer &player = Players[i];
+
+				for (int j = 0; j != MaxCosts; ++j) {
+					hasher.Add(player.Resources[j]);
+					hasher.Add(player.StoredResources[j]);
+					hasher.Add(player.MaxResources[j]);
+				}
+			}
+			break;
+		case TriggerDependencyTimer:
+			hasher.Add(GameTimer.Init);
+			hasher.Add(GameTimer.Running);
+			hasher.Add(GameTimer.Cycles);
+			break;
+		default:
+			Assert(0);
+	}
+	return hasher.Hash;
+}
+
+/**
+**  Find the dependencies which changed since the last check.
+**
+**  Only the dependencies of scheduled triggers are followed.
+**
+**  @return  Bit mask of the changed TriggerDependency.
+*/
+static int ChangedTriggerDependencies()
+{
+	int used = 0;
 
+	for (size_t i = 0; i != ScheduledTriggers.size(); ++i) {
+		used |= ScheduledTriggers[i].Dependencies;
+	}
+	int changed = 0;
+	if ((used & (1 << TriggerDependencyUnits)) && PlayerUnitsChangeCount != TriggerUnitsChangeCount) {
+		TriggerUnitsChangeCount = PlayerUnitsChangeCount;
+		changed |= 1 << TriggerDependencyUnits;
+	}
+	for (int i = TriggerDependencyResources; i != TriggerDependencyMap; ++i) {
+		if (used & (1 << i)) {
+			const unsigned int hash = HashTriggerDependency(i);
+
+			if (hash != DependencyHashes[i]) {
+				DependencyHashes[i] = hash;
+				changed |= 1 << i;
+			}
+		}
+	}
+	if ((used & (1 << TriggerDependencyMap)) && Map.ChangeCount != TriggerMapChangeCount) {
+		TriggerMapChangeCount = Map.ChangeCount;
+		changed |= 1 << TriggerDependencyMap;
+	}
+	return changed;
+}
+
+/**
+**  Check the scheduled triggers which are due this game cycle.
+**
+**  _triggers_ must be on top of the stack.
+*/
+static void ScheduledTriggersEachCycle()
+{
+	if (ScheduledTriggers.empty()) {
+		return;
+	}
+	const int changed = ChangedTriggerDependencies();
+
+	// Actions can add triggers, they are checked at the next cycle.
+	const size_t count = ScheduledTriggers.size();
+	for (size_t i = 0; i != count && i != ScheduledTriggers.size(); ++i) {
+		CTriggerSchedule &schedule = ScheduledTriggers[i];
+
+		if (schedule.Cycle == GameCycle) {
+			schedule.Cycle = 0;
+		} else if (!schedule.Pending && !(schedule.Dependencies & changed)
+				   && !(schedule.Interval && GameCycle % schedule.Interval == 0)) {
+			continue;
+		}
+		schedule.Pending = false;
+		if (TriggerCheckCondition(schedule.Trigger)) {
+			ScheduledTriggers[i].Dependencies = 0;
+			ScheduledTriggers[i].Cycle = 0;
+			ScheduledTriggers[i].Interval = 0;
+		}
+	}
+	// Forget the removed triggers.
+	for (size_t i = 0; i != ScheduledTriggers.size();) {
+		const CTriggerSchedule &schedule = ScheduledTriggers[i];
+
+		if (!schedule.Dependencies && !schedule.Cycle && !schedule.Interval && !schedule.Pending) {
+			ScheduledTriggers.erase(ScheduledTriggers.begin() + i);
+		} else {
+			++i;
+		}
+	}
+}
+
+/**
+**  Check trigger each game cycle.
+*/
+void TriggersEachCycle()
+{
 	lua_getglobal(Lua, "_triggers_");
 	int triggers = lua_rawlen(Lua, -1);
 
@@ -550,26 +1263,24 @@ void TriggersEachCycle()
 
 	// Skip to the next trigger
 	while (Trigger < triggers) {
+		if (size_t(Trigger / 2) < IsScheduledTrigger.size() && IsScheduledTrigger[Trigger / 2]) {
+			Trigger += 2;
+			continue;
+		}
 		lua_rawgeti(Lua, -1, Trigger + 1);
-		if (!lua_isnumber(Lua, -1)) {
+		const bool removed = lua_isnumber(Lua, -1);
+		lua_pop(Lua, 1);
+		if (!removed) {
 			break;
 		}
-		lua_pop(Lua, 1);
 		Trigger += 2;
 	}
 	if (Trigger < triggers) {
 		int currentTrigger = Trigger;
 		Trigger += 2;
-		LuaCall(0, 0);
-		// If condition is true execute action
-		if (lua_gettop(Lua) > base + 1 && lua_toboolean(Lua, -1)) {
-			lua_settop(Lua, base + 1);
-			if (TriggerExecuteAction(currentTrigger + 1)) {
-				TriggerRemoveTrigger(currentTrigger);
-			}
-		}
-		lua_settop(Lua, base + 1);
+		TriggerCheckCondition(currentTrigger);
 	}
+	ScheduledTriggersEachCycle();
 	lua_pop(Lua, 1);
 }
 
@@ -580,6 +1291,7 @@ void TriggerCclRegister()
 {
 	lua_register(Lua, "AddTrigger", CclAddTrigger);
 	lua_register(Lua, "SetActiveTriggers", CclSetActiveTriggers);
+	lua_register(Lua, "SetTriggerSchedule", CclSetTriggerSchedule);
 	// Conditions
 	lua_register(Lua, "GetNumUnitsAt", CclGetNumUnitsAt);
 	lua_register(Lua, "IfNearUnit", CclIfNearUnit);
@@ -627,6 +1339,20 @@ void SaveTriggers(CFile &file)
 
 	file.printf("\n");
 	file.printf("if (Triggers ~= nil) then assert(loadstring(Triggers))() end\n");
+	if (!ScheduledTriggers.empty()) {
+		file.printf("SetTriggerSchedule(%s, %u, %u, %s, {",
+					PlayerUnitsChangeCount != TriggerUnitsChangeCount ? "true" : "false",
+					DependencyHashes[TriggerDependencyResources], DependencyHashes[TriggerDependencyTimer],
+					Map.ChangeCount != TriggerMapChangeCount ? "true" : "false");
+		bool first = true;
+		for (size_t i = 0; i != ScheduledTriggers.size(); ++i) {
+			if (ScheduledTriggers[i].Pending) {
+				file.printf("%s%d", first ? "" : ", ", ScheduledTriggers[i].Trigger);
+				first = false;
+			}
+		}
+		file.printf("})\n");
+	}
 	file.printf("\n");
 }
 
@@ -663,6 +1389,16 @@ void CleanTriggers()
 	delete[] ActiveTriggers;
 	ActiveTriggers = NULL;
 
+	for (size_t i = 0; i != NativeConditions.size(); ++i) {
+		delete NativeConditions[i];
+	}
+	NativeConditions.clear();
+	ScheduledTriggers.clear();
+	IsScheduledTrigger.clear();
+	memset(DependencyHashes, 0, sizeof(DependencyHashes));
+	TriggerUnitsChangeCount = 0;
+	TriggerMapChangeCount = 0;
+
 	GameTimer.Reset();
 }
 
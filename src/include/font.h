@@ -59,6 +59,7 @@
 --  Includes
 ----------------------------------------------------------------------------*/
 
+#include <map>
 #include <string>
 #include "color.h"
 #include "guichan/font.h"
@@ -103,6 +104,8 @@ public:
 
 	CGraphic *GetFontColorGraphic(const CFontColor &fontColor) const;
 
+	int GetGlyph(int utf8, int &gx, int &gy) const;
+
 	template<bool CLIP>
 	unsigned int DrawChar(CGraphic &g, int utf8, int x, int y, const CFontColor &fc) const;
 
@@ -118,6 +121,7 @@ private:
 	std::string Ident;    /// Ident of the font.
 	char *CharWidth;      /// Real font width (starting with ' ')
 	CGraphic *G;          /// Graphic object used to draw
+	mutable std::map<std::string, int> WidthCache; /// Measured widths of texts
 };
 
 #define MaxFontColors 9
@@ -35,6 +35,8 @@ class CFile;
 
 extern void LoadGame(const std::string &filename); /// Load saved game
 extern int SaveGame(const std::string &filename); /// Save game
+extern void AutosaveGame(const std::string &filename); /// Save game in the background
+extern void WaitForAutosave(); /// Wait until the background save is written
 extern void DeleteSaveGame(const std::string &filename); /// Delete save game
 extern bool SaveGameLoading;                 /// Save game is in progress of loading
 
@@ -105,11 +105,14 @@ public:
 	~CFile();
 
 	int open(const char *name, long flags);
+	int openBuffer();
 	int close();
 	void flush();
 	int read(void *buf, size_t len);
 	int seek(long offset, int whence);
 	long tell();
+	int write(const void *buf, size_t len);
+	void takeBuffer(std::string &buffer);
 
 	int printf(const char *format, ...) PRINTF_VAARG_ATTRIBUTE(2, 3); // Don't forget to count this
 private:
@@ -124,7 +127,8 @@ enum {
 	CLF_TYPE_INVALID,  /// invalid file handle
 	CLF_TYPE_PLAIN,    /// plain text file handle
 	CLF_TYPE_GZIP,     /// gzip file handle
-	CLF_TYPE_BZIP2     /// bzip2 file handle
+	CLF_TYPE_BZIP2,    /// bzip2 file handle
+	CLF_TYPE_BUFFER    /// memory buffer handle
 };
 
 #define CL_OPEN_READ 0x1
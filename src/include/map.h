@@ -76,6 +76,16 @@
 **  CMap::Info
 **
 **    Descriptive information of the map. See ::CMapInfo.
+**
+**  CMap::Influence
+**
+**    Coarse influence of the units of each player. See ::CMapInfluence.
+**
+**  CMap::ChangeCount
+**
+**    Incremented each time a unit is inserted or removed or the terrain
+**    changes. Caches of things computed from the map compare it to know
+**    if they are still valid.
 */
 
 /*----------------------------------------------------------------------------
@@ -83,6 +93,7 @@
 ----------------------------------------------------------------------------*/
 
 #include <string>
+#include <vector>
 
 #ifndef __MAP_TILE_H__
 #include "tile.h"
@@ -141,6 +152,83 @@ public:
 	unsigned int MapUID;        /// Unique Map ID (hash)
 };
 
+/*----------------------------------------------------------------------------
+--  Influence of the players
+----------------------------------------------------------------------------*/
+
+/**
+**  Influence of the units of a player in an area.
+*/
+class CInfluence
+{
+public:
+	CInfluence() : Units(0), Strength(0), AntiAir(0), AntiGround(0) {}
+
+	void Add(const CInfluence &rhs)
+	{
+		Units += rhs.Units;
+		Strength += rhs.Strength;
+		AntiAir += rhs.AntiAir;
+		AntiGround += rhs.AntiGround;
+	}
+	void Sub(const CInfluence &rhs)
+	{
+		Units -= rhs.Units;
+		Strength -= rhs.Strength;
+		AntiAir -= rhs.AntiAir;
+		AntiGround -= rhs.AntiGround;
+	}
+
+public:
+	int Units;       /// Number of units
+	int Strength;    /// Sum of the damage of the units
+	int AntiAir;     /// Number of units which can target air units
+	int AntiGround;  /// Number of units which can target land or sea units
+};
+
+/**
+**  Influence of the units of each player, on a grid of cells of
+**  CellSize x CellSize tiles.
+**
+**  Kept up to date by CMap::Insert and CMap::Remove, so the AI can
+**  ask what is near a position without looking at the units. A unit
+**  counts in the cell of its top left tile.
+*/
+class CMapInfluence
+{
+public:
+	static const int CellShift = 3;
+	static const int CellSize = 1 << CellShift;
+
+	CMapInfluence() : Width(0), Height(0), LargestUnit(1) {}
+
+	/// Forget all units
+	void Clean();
+	/// Add the influence of a unit placed on the map
+	void Insert(const CUnit &unit);
+	/// Remove the influence of a unit, the same as added
+	void Remove(const CUnit &unit);
+	/// Influence of a player in the tile rectangle
+	CInfluence Get(int player, const Vec2i &minPos, const Vec2i &maxPos) const;
+	/// Influence of the enemies of a player in the tile rectangle
+	CInfluence GetEnemies(const CPlayer &player, const Vec2i &minPos, const Vec2i &maxPos) const;
+
+private:
+	/// Influence and cell added for a unit
+	struct UnitEntry {
+		UnitEntry() : Cell(-1) {}
+
+		int Cell;            /// Index in Cells, -1 if not added
+		CInfluence Value;    /// Influence added
+	};
+
+	int Width;                           /// Width in cells
+	int Height;                          /// Height in cells
+	int LargestUnit;                     /// Largest unit size in tiles seen
+	std::vector<CInfluence> Cells;       /// PlayerMax entries for each cell
+	std::vector<UnitEntry> Units;        /// By unit slot
+};
+
 /*----------------------------------------------------------------------------
 --  Map itself
 ----------------------------------------------------------------------------*/
@@ -265,6 +353,8 @@ public:
 	static CGraphic *FogGraphic;      /// graphic for fog of war
 
 	CMapInfo Info;             /// descriptive information
+	CMapInfluence Influence;   /// influence of the players
+	unsigned long ChangeCount; /// incremented when units or terrain change
 };
 
 
@@ -54,13 +54,16 @@ class CMinimap
 	template <const int BPP>
 	void UpdateSeen(void *const pixels, const int pitch);
 
+	void MarkDirty(int x0, int y0, int x1, int y1);
+	void UpdateUnits(int red_phase);
+
 public:
 	CMinimap() : X(0), Y(0), W(0), H(0), XOffset(0), YOffset(0),
 		WithTerrain(false), ShowSelected(false),
 		Transparent(false), UpdateCache(false) {}
 
 	void UpdateXY(const Vec2i &pos);
-	void UpdateSeenXY(const Vec2i &) {}
+	void UpdateSeenXY(const Vec2i &pos);
 	void Update();
 	void Create();
 #if defined(USE_OPENGL) || defined(USE_GLES)
@@ -71,6 +74,7 @@ public:
 	void Draw() const;
 	void DrawViewportArea(const CViewport &viewport) const;
 	void AddEvent(const Vec2i &pos, IntColor color);
+	bool HasEvents() const;
 
 	Vec2i ScreenToTilePos(const PixelPos &screenPos) const;
 	PixelPos TilePosToScreenPos(const Vec2i &tilePos) const;
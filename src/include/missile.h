@@ -305,10 +305,12 @@
 --  Declarations
 ----------------------------------------------------------------------------*/
 
+class CDrawItem;
 class CGraphic;
 class CUnit;
 class CViewport;
 class CFile;
+class CSyncHasher;
 class LuaCallback;
 
 /*----------------------------------------------------------------------------
@@ -605,10 +607,15 @@ extern int CalculateDamage(const CUnit &attacker, const CUnit &goal, const Numbe
 /// fire a missile
 extern void FireMissile(CUnit &unit, CUnit *goal, const Vec2i &goalPos);
 
-extern void FindAndSortMissiles(const CViewport &vp, std::vector<Missile *> &table);
+/// Find and sort all missiles visible on map in viewport
+extern void FindAndSortMissiles(const CViewport &vp, std::vector<CDrawItem> &table);
 
 /// handle all missiles
 extern void MissileActions();
+/// Add the global missiles to a sync hash
+extern void HashGlobalMissiles(CSyncHasher &hasher);
+/// Dump the global missiles to find desyncs
+extern void DumpGlobalMissiles(FILE *file);
 /// distance from view point to missile
 extern int ViewPointDistanceToMissile(const Missile &missile);
 
@@ -64,6 +64,11 @@
 # define INADDR_NONE -1
 #endif
 
+// sendmmsg and recvmmsg move several datagrams with one system call
+#if defined(USE_LINUX) && defined(MSG_WAITFORONE)
+# define USE_UDP_BATCHES
+#endif
+
 /*----------------------------------------------------------------------------
 --  Defines
 ----------------------------------------------------------------------------*/
@@ -123,6 +128,12 @@ extern void NetCloseUDP(Socket sockfd);
 extern int NetSendUDP(Socket sockfd, unsigned long host, int port, const void *buf, int len);
 /// Receive from a UDP socket.
 extern int NetRecvUDP(Socket sockfd, void *buf, int len, unsigned long *hostFrom, int *portFrom);
+/// Send the same datagram through a UDP socket to several hosts.
+extern int NetSendUDPToHosts(Socket sockfd, const unsigned long *hosts, const int *ports, int count, const void *buf, int len);
+#ifdef USE_UDP_BATCHES
+/// Receive all pending datagrams, up to count, from a UDP socket.
+extern int NetRecvUDPBatch(Socket sockfd, unsigned char *bufs, int len, int count, int *lens, unsigned long *hostsFrom, int *portsFrom);
+#endif
 
 
 /// Open a TCP Socket port.
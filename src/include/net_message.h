@@ -34,6 +34,8 @@
 #include <stdint.h>
 #include <vector>
 
+#include "synchash.h"
+
 /*----------------------------------------------------------------------------
 --  Declarations
 ----------------------------------------------------------------------------*/
@@ -45,6 +47,8 @@
 #define NetPlayerNameSize 16
 
 #define MaxNetworkCommands 9  /// Max Commands In A Packet
+#define MaxNetworkPacketSize 1024  /// Max Size Of A Packet
+#define MaxGroupCommandUnits 128  /// Max Units In A Group Command
 
 /**
 **  Network systems active in current game.
@@ -215,13 +219,15 @@ public:
 	const CInitMessage_Header &GetHeader() const { return header; }
 	const unsigned char *Serialize() const;
 	void Deserialize(const unsigned char *p);
-	static size_t Size() { return CInitMessage_Header::Size() + PlayerMax * CNetworkHost::Size() + 2 * 4; }
+	static size_t Size() { return CInitMessage_Header::Size() + PlayerMax * CNetworkHost::Size() + 2 * 4 + 4 + 2; }
 private:
 	CInitMessage_Header header;
 public:
 	CNetworkHost hosts[PlayerMax]; /// Participants information
 	int32_t Lag;                   /// Lag time
 	int32_t gameCyclesPerUpdate;   /// Update frequency
+	uint32_t RelayHost;            /// Relay of the in-game packets, 0 for none
+	uint16_t RelayPort;            /// Port of the relay
 };
 
 class CInitMessage_Map
@@ -285,6 +291,9 @@ enum _message_type_ {
 	MessageResend,                 /// Resend message
 
 	MessageChat,                   /// Chat message
+	MessageLag,                    /// Network lag needed by the sender
+	MessageGroupCommand,           /// Same unit command for several units
+	MessageSyncHashes,             /// Sync hashes to find a desync
 
 	MessageCommandStop,            /// Unit command stop
 	MessageCommandStand,           /// Unit command stand ground
@@ -335,7 +344,7 @@ public:
 
 	size_t Serialize(unsigned char *buf) const;
 	size_t Deserialize(const unsigned char *buf);
-	static size_t Size() { return 2 + 2 + 2 + 2; }
+	size_t Size() const { return Serialize(NULL); }
 
 public:
 	uint16_t Unit;         /// Command for unit
@@ -344,6 +353,28 @@ public:
 	uint16_t Dest;         /// Destination unit
 };
 
+/**
+**  Network command message for several units.
+**
+**  A group order sends one command with the units sorted by slot.
+*/
+class CNetworkGroupCommand
+{
+public:
+	CNetworkGroupCommand() : Type(0), X(0), Y(0), Dest(0) {}
+
+	size_t Serialize(unsigned char *buf) const;
+	size_t Deserialize(const unsigned char *buf);
+	size_t Size() const { return Serialize(NULL); }
+
+public:
+	uint8_t Type;                 /// Command type of the units
+	uint16_t X;                   /// Map position X
+	uint16_t Y;                   /// Map position Y
+	uint16_t Dest;                /// Destination unit
+	std::vector<uint16_t> Units;  /// Units receiving the command
+};
+
 /**
 **  Extended network command message.
 */
@@ -408,6 +439,46 @@ public:
 	uint16_t player;
 };
 
+/**
+**  Network lag message.
+**
+**  Each player reports the lag it needs to not wait for the packets of
+**  the other players. All players adapt the lag to the reports at the
+**  same game cycle.
+*/
+class CNetworkCommandLag
+{
+public:
+	CNetworkCommandLag() : player(0), lag(0) {}
+	size_t Serialize(unsigned char *buf) const;
+	size_t Deserialize(const unsigned char *buf);
+	static size_t Size() { return 2 + 2; };
+
+public:
+	uint16_t player;
+	uint16_t lag;  /// Needed lag in game cycles
+};
+
+/**
+**  Network sync hashes message.
+**
+**  Exchanged after a desync to find its first game cycle.
+*/
+class CNetworkSyncHashes
+{
+public:
+	CNetworkSyncHashes() : player(0), flags(0), cycle(0) { memset(hashes, 0, sizeof(hashes)); }
+	size_t Serialize(unsigned char *buf) const;
+	size_t Deserialize(const unsigned char *buf);
+	static size_t Size() { return 2 + 1 + 4 + 4 * SyncHashCount; };
+
+public:
+	uint16_t player;
+	uint8_t flags;                   /// What the player wants, see SyncHashesFlags
+	uint32_t cycle;                  /// Game cycle of the hashes
+	uint32_t hashes[SyncHashCount];  /// Hash of each part of the game state
+};
+
 /**
 **  Network Selection Update
 */
@@ -35,12 +35,15 @@
 --  Includes
 ----------------------------------------------------------------------------*/
 
+#include <vector>
+
 #include "network/netsockets.h"
 
 /*----------------------------------------------------------------------------
 --  Declarations
 ----------------------------------------------------------------------------*/
 
+class CSyncHashes;
 class CUnit;
 class CUnitType;
 
@@ -55,18 +58,48 @@ public:
 	unsigned int gameCyclesPerUpdate;  /// Network update each # game cycles
 	unsigned int NetworkLag;      /// Network lag (# update cycles)
 	unsigned int timeoutInS;      /// Number of seconds until player times out
+	std::string relayHost;  /// Relay of the in-game packets, empty for none
+	unsigned int relayPort; /// Port of the relay
 
 public:
 	static const int defaultPort = 6660; /// Default communication port
+	static const int defaultRelayPort = 6662; /// Default port of the relay
 public:
 	static CNetworkParameter Instance;
 };
 
+/**
+**  Estimate the lag needed to receive the packets of a player in time.
+**
+**  A sample is the time from sending our packet for a game cycle until
+**  the packet of the player for the same cycle arrives. The delay and
+**  its deviation are smoothed like the TCP round-trip time.
+*/
+class CNetworkLagEstimator
+{
+public:
+	CNetworkLagEstimator() { Clear(); }
+	void Clear() { Delay = Deviation = Samples = 0; }
+
+	void AddSample(int delay);
+	bool IsValid() const { return Samples >= MinSamples; }
+	unsigned int NeededLag(unsigned int msPerCycle, unsigned int gameCyclesPerUpdate) const;
+
+public:
+	int Delay;      /// Smoothed delay in ms, scaled by 8
+	int Deviation;  /// Mean deviation of the delay in ms, scaled by 4
+	int Samples;    /// Number of samples
+
+	static const int MinSamples = 8;  /// Samples needed for an estimation
+	static const unsigned int MaxLag = 120;  /// Highest lag, commands wrap after 256 cycles
+};
+
 /*----------------------------------------------------------------------------
 --  Variables
 ----------------------------------------------------------------------------*/
 
 extern CUDPSocket NetworkFildes;  /// Network file descriptor
+extern CHost NetworkRelay;        /// Relay of the in-game packets, not valid without relay
 extern bool NetworkInSync;        /// Network is in sync
 
 /*----------------------------------------------------------------------------
@@ -91,6 +124,14 @@ extern void NetworkSendExtendedCommand(int command, int arg1, int arg2,
 									   int arg3, int arg4, int status);
 /// Send Selections to Team
 extern void NetworkSendSelection(CUnit **units, int count);
+/// Send sync hashes to find a desync
+extern void NetworkSendSyncHashes(int flags, const CSyncHashes &hashes);
+/// Lag to report for the delays measured from the other players
+extern unsigned int NetworkLagToReport(const std::vector<const CNetworkLagEstimator *> &estimators,
+									   unsigned int msPerCycle, unsigned int gameCyclesPerUpdate);
+/// Lag to use for the lags reported by all players
+extern unsigned int NetworkAdaptedLag(unsigned int networkLag, const std::vector<unsigned int> &reports,
+									  unsigned int gameCyclesPerUpdate);
 
 extern void NetworkCclRegister();
 
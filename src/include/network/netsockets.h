@@ -30,6 +30,7 @@
 #define NETSOCKETS_H
 
 #include <string>
+#include <vector>
 
 //@{
 
@@ -62,6 +63,7 @@ public:
 	bool Open(const CHost &host);
 	void Close();
 	void Send(const CHost &host, const void *buf, unsigned int len);
+	void Send(const std::vector<CHost> &hosts, const void *buf, unsigned int len);
 	int Recv(void *buf, int len, CHost *hostFrom);
 	void SetNonBlocking();
 	//
@@ -86,6 +88,9 @@ public:
 		unsigned int receivedBytesExpectedCount;
 		unsigned int biggestSentPacketSize;
 		unsigned int biggestReceivedPacketSize;
+		unsigned int sendCallsCount;
+		unsigned int receiveCallsCount;
+		unsigned int selectCallsCount;
 	};
 
 	void clearStatistic() { m_statistic.clear(); }
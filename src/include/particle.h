@@ -33,6 +33,7 @@
 
 #include <vector>
 
+class CDrawItem;
 class CGraphic;
 class CViewport;
 
@@ -209,7 +210,7 @@ public:
 	static void init();
 	static void exit();
 
-	void prepareToDraw(const CViewport &vp, std::vector<CParticle *> &table);
+	void prepareToDraw(const CViewport &vp, std::vector<CDrawItem> &table);
 	void endDraw();
 
 	void update();
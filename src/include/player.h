@@ -333,6 +333,7 @@ extern int NumPlayers;             /// How many player slots used
 extern CPlayer Players[PlayerMax];  /// All players
 extern CPlayer *ThisPlayer;         /// Player on local computer
 extern bool NoRescueCheck;          /// Disable rescue check
+extern unsigned long PlayerUnitsChangeCount; /// incremented when the unit counts of a player change
 extern std::vector<CColor> PlayerColorsRGB[PlayerMax]; /// Player colors
 extern std::vector<IntColor> PlayerColors[PlayerMax]; /// Player colors
 extern std::string PlayerColorNames[PlayerMax];  /// Player color names
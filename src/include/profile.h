@@ -0,0 +1,98 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name profile.h - The hot path profiler header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#ifndef __PROFILE_H__
+#define __PROFILE_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include <string>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+/**
+**  Measures the time until the end of the scope, if profiling is on.
+**
+**  The time is added to a section, which is created once with
+**  ProfileSection, and to a player, or to no player with -1:
+**
+**  static const int section = ProfileSection("ai-script");
+**  CProfileScope scope(section, player.Index);
+*/
+class CProfileScope
+{
+public:
+	CProfileScope(int section, int player) : Section(section), Player(player), Start(0)
+	{
+		if (ProfileEnabled) {
+			Begin();
+		}
+	}
+	~CProfileScope()
+	{
+		if (Start) {
+			End();
+		}
+	}
+
+	static bool ProfileEnabled;  /// Profiling is on
+
+private:
+	void Begin();
+	void End();
+
+private:
+	int Section;               /// Section the time is added to
+	int Player;                /// Player the time is added to, -1 for none
+	unsigned long long Start;  /// Start time in microseconds, 0 if not measured
+};
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/// Get the index of a profiled section, created at the first call
+extern int ProfileSection(const char *name);
+/// Turn profiling on or off
+extern void SetProfiling(bool enabled);
+/// End a game cycle, for the worst cycles
+extern void ProfileEachCycle();
+/// Get the report of the measured times
+extern std::string ProfileReport();
+/// Print the report and forget the measured times
+extern void ProfileEndGame();
+/// Register ccl functions for the profiler
+extern void ProfileCclRegister();
+
+//@}
+
+#endif // !__PROFILE_H__
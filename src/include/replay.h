@@ -56,6 +56,7 @@ class CUnit;
 
 extern bool CommandLogDisabled;    /// True, if command log is off
 extern ReplayType ReplayGameType;  /// Replay game type
+extern int ReplayTraceCycles;      /// SyncHash trace interval of VerifyReplay, 0 if not verifying
 
 /*----------------------------------------------------------------------------
 --  Functions
@@ -70,6 +71,10 @@ extern void SinglePlayerReplayEachCycle();
 extern void MultiPlayerReplayEachCycle();
 /// Load replay
 extern int LoadReplay(const std::string &name);
+/// Run a replay headless and print its SyncHash trace
+extern void VerifyReplay(const std::string &filename);
+/// End of the verified replay, print its SyncHash and stop the game
+extern void EndVerifyReplay();
 /// End logging
 extern void EndReplayLog();
 /// Clean replay
@@ -90,7 +90,7 @@ extern int LuaCall(int narg, int clear, bool exitOnError = true);
 
 inline size_t lua_rawlen(lua_State *l, int index)
 {
-	return luaL_getn(l, index);
+	return lua_objlen(l, index);
 }
 
 #endif
@@ -122,7 +122,9 @@ enum ENumber {
 
 	ENumber_NumIf,       /// If cond then Number1 else Number2.
 
-	ENumber_PlayerData   /// Numeric Player Data
+	ENumber_PlayerData,  /// Numeric Player Data
+
+	ENumber_Program      /// Compiled number description.
 };
 
 /// All possible value for a unit.
@@ -193,6 +195,9 @@ struct UnitDesc;
 */
 struct StringDesc;
 
+/// Number description compiled for a fast evaluation
+class CNumberProgram;
+
 /// for Bin operand  a ?? b
 struct BinOp {
 	NumberDesc *Left;           /// Left operand.
@@ -239,6 +244,7 @@ struct NumberDesc {
 			StringDesc *DataType; /// Player's data
 			StringDesc *ResType;  /// Resource type
 		} PlayerData; /// conditional string.
+		CNumberProgram *Program; /// Compiled number description.
 	} D;
 };
 
@@ -342,6 +348,7 @@ extern NumberDesc *Damage;  /// Damage calculation for missile.
 /// transform string in corresponding index.
 extern EnumVariable Str2EnumVariable(lua_State *l, const char *s);
 extern NumberDesc *CclParseNumberDesc(lua_State *l); /// Parse a number description.
+extern NumberDesc *ParseNumberDesc(lua_State *l);    /// Parse a number description, not compiled.
 extern UnitDesc *CclParseUnitDesc(lua_State *l);     /// Parse a unit description.
 extern CUnitType **CclParseTypeDesc(lua_State *l);   /// Parse a unit type description.
 StringDesc *CclParseStringDesc(lua_State *l);        /// Parse a string description.
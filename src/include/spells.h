@@ -37,6 +37,9 @@
 --  Includes
 ----------------------------------------------------------------------------*/
 
+#include <map>
+#include <vector>
+
 #include "luacallback.h"
 #include "unitsound.h"
 #include "vec2i.h"
@@ -137,7 +140,7 @@ class ConditionInfo
 {
 public:
 	ConditionInfo() : Alliance(0), Opponent(0), TargetSelf(0),
-		BoolFlag(NULL), Variable(NULL), CheckFunc(NULL) {};
+		BoolFlag(NULL), Variable(NULL), CheckFunc(NULL), CheckBoolFlags(false) {};
 	~ConditionInfo()
 	{
 		delete[] BoolFlag;
@@ -158,6 +161,10 @@ public:
 
 	ConditionInfoVariable *Variable;
 	LuaCallback *CheckFunc;
+
+	std::vector<int> CasterVariables;  /// Indexes of the checked variables of the caster
+	std::vector<int> TargetVariables;  /// Indexes of the checked variables of the target
+	bool CheckBoolFlags;               /// True if any BoolFlag must be checked
 	//
 	//  @todo more? feel free to add, here and to
 	//  @todo PassCondition, CclSpellParseCondition, SaveSpells
@@ -199,6 +206,24 @@ public:
 	LuaCallback *PositionAutoCast;
 };
 
+/**
+**  Units around a caster, selected once and shared by the autocast
+**  checks of all its spells.
+*/
+class AutoCastArea
+{
+public:
+	explicit AutoCastArea(const CUnit &caster) : Caster(caster) {}
+
+	const CUnit &GetCaster() const { return Caster; }
+	/// Units around the caster, in the order of SelectAroundUnit
+	const std::vector<CUnit *> &Around(int range);
+
+private:
+	const CUnit &Caster;
+	std::map<int, std::vector<CUnit *> > Units;  /// Selected units by range
+};
+
 /**
 **  Base structure of a spell type.
 */
@@ -277,7 +302,7 @@ extern int SpellCast(CUnit &caster, const SpellType &spell,
 					 CUnit *target, const Vec2i &goalPos);
 
 /// auto cast the spell if possible
-extern int AutoCastSpell(CUnit &caster, const SpellType &spell);
+extern int AutoCastSpell(CUnit &caster, const SpellType &spell, AutoCastArea *area = NULL);
 
 /// return spell type by ident string
 extern SpellType *SpellTypeByIdent(const std::string &ident);
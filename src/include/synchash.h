@@ -0,0 +1,132 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name synchash.h - The sync state hashes header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#ifndef __SYNCHASH_H__
+#define __SYNCHASH_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+/**
+**  Parts of the game state with their own hash.
+*/
+enum SyncHashType {
+	SyncHashUnits,     /// Units by slot
+	SyncHashMissiles,  /// Global missiles
+	SyncHashPlayers,   /// Player resources and counters
+	SyncHashMap,       /// Map fields, one stripe of rows each cycle
+	SyncHashRandom,    /// SyncRandSeed
+	SyncHashCount
+};
+
+/**
+**  Flags of an exchanged sync hashes message.
+*/
+enum SyncHashesFlags {
+	SyncHashesAnswer,   /// Hashes asked for by another player
+	SyncHashesRequest,  /// Ask the other players for their hashes of the cycle
+	SyncHashesDump      /// First different cycle found, dump the state
+};
+
+/**
+**  Hashes of the game state at the end of a game cycle.
+*/
+class CSyncHashes
+{
+public:
+	CSyncHashes() : Cycle(0) { memset(Hash, 0, sizeof(Hash)); }
+
+	/// Bit mask of the different hashes
+	unsigned int Differences(const CSyncHashes &rhs) const
+	{
+		unsigned int differences = 0;
+		for (int i = 0; i != SyncHashCount; ++i) {
+			if (Hash[i] != rhs.Hash[i]) {
+				differences |= 1 << i;
+			}
+		}
+		return differences;
+	}
+
+public:
+	unsigned long Cycle;              /// Game cycle of the hashes
+	unsigned int Hash[SyncHashCount]; /// Hash of each part
+};
+
+/**
+**  FNV-1a hash of values of the game state.
+*/
+class CSyncHasher
+{
+public:
+	CSyncHasher() : Hash(2166136261u) {}
+
+	void Add(int value)
+	{
+		for (int i = 0; i != 4; ++i, value >>= 8) {
+			Hash = (Hash ^ (value & 0xFF)) * 16777619u;
+		}
+	}
+
+public:
+	unsigned int Hash;  /// Hash of the values added so far
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+extern unsigned long LastSyncHashesCycle;  /// Last game cycle hashed
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/// Forget the hashes of the last game
+extern void InitSyncHashes();
+/// Hash the game state at the end of a game cycle
+extern void SyncHashesEachCycle();
+/// Get the hashes of a recent game cycle
+extern const CSyncHashes *GetSyncHashes(unsigned long cycle);
+/// The state of all players was the same at a cycle
+extern void SyncHashesMatched(unsigned long cycle);
+/// The state of another player was different at a cycle
+extern void SyncHashesMismatch(unsigned long cycle);
+/// Handle sync hashes received from another player
+extern void SyncHashesReceived(int player, int flags, const CSyncHashes &hashes);
+
+//@}
+
+#endif // !__SYNCHASH_H__
@@ -191,6 +191,9 @@ public:
 	void Save(CFile &file) const;
 	void parse(lua_State *l);
 
+	static void SavePlanes(const CMapField *fields, int width, int height, std::string &data);
+	static bool ParsePlanes(CMapField *fields, int width, int height, const std::string &data);
+
 	void setTileIndex(const CTileset &tileset, unsigned int tileIndex, int value);
 
 	unsigned int getGraphicTile() const { return tile; }
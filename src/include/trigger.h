@@ -32,6 +32,10 @@
 
 //@{
 
+#include <vector>
+
+#include "vec2i.h"
+
 /*----------------------------------------------------------------------------
 --  Declarations
 ----------------------------------------------------------------------------*/
@@ -71,6 +75,35 @@ public:
 #define ALL_BUILDINGS ((const CUnitType *)-2)
 
 
+/**
+**  Part of the map watched by native trigger conditions.
+**
+**  ChangeCount is incremented by TriggerAreasUnitChanged each time a unit
+**  of the type is inserted into or removed from the area, so a condition
+**  only looks at the units again when they moved in the area or the unit
+**  counts of the players changed.
+*/
+class CTriggerArea
+{
+public:
+	explicit CTriggerArea(const CUnitType *type);
+	CTriggerArea(const CUnitType *type, const Vec2i &minPos, const Vec2i &maxPos);
+	~CTriggerArea();
+
+	/// Check if the unit is one of the watched units
+	bool Matches(const CUnit &unit) const;
+
+	const CUnitType *Type;      /// Unit-type, or ANY_UNIT, ALL_FOODUNITS, ALL_BUILDINGS
+	Vec2i MinPos;               /// Top left tile of the area
+	Vec2i MaxPos;               /// Bottom right tile of the area
+	unsigned long ChangeCount;  /// Incremented when a watched unit enters or leaves
+
+	static std::vector<CTriggerArea *> Areas;  /// All the watched areas
+private:
+	CTriggerArea(const CTriggerArea &rhs); // No implementation
+	const CTriggerArea &operator = (const CTriggerArea &rhs); // No implementation
+};
+
 /**
 **  Data to referer game info when game running.
 */
@@ -97,6 +130,8 @@ extern TriggerDataType TriggerData;
 extern int TriggerGetPlayer(lua_State *l);/// get player number.
 extern const CUnitType *TriggerGetUnitType(lua_State *l); /// get the unit-type
 extern void TriggersEachCycle();    /// test triggers
+/// A unit was inserted into or removed from the map
+extern void TriggerAreasUnitChanged(const CUnit &unit);
 
 extern void TriggerCclRegister();   /// Register ccl features
 extern void SaveTriggers(CFile &file); /// Save the trigger module
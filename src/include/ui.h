@@ -278,6 +278,7 @@ public:
 	{}
 
 	void Draw();
+	void GetContentKey(std::vector<size_t> &key) const;
 	void Update();
 	void DoClicked(int button);
 	int DoKey(int key);
@@ -364,6 +365,63 @@ public:
 	int Y;
 };
 
+/// Panels of the game screen, see CPanelLayer
+enum PanelType {
+	PanelMenuButtons,  /// Menu, network and user buttons
+	PanelMinimap,      /// Minimap with the viewport area
+	PanelInfo,         /// Info panel with the unit buttons on it
+	PanelResources,    /// Resources of the player
+	PanelStatusLine,   /// Status line with the costs
+	PanelButtons,      /// Button panel
+	PanelTimer,        /// Game timer, when it is not on the map
+	NumPanels
+};
+
+/**
+**  Panels of the game screen, drawn again only when what they show
+**  changed.
+**
+**  Each panel has a content key, built from the values it shows: the
+**  resources, the selected units, the hovered button and so on. The
+**  software renderer keeps the drawn panels on the screen between frames.
+**  The panels are drawn again when a key changed, and only the map, the
+**  cursor and the changed panels are pushed with SDL_UpdateRects.
+**
+**  Popups, menus, the pie menu and the selection rectangle are drawn over
+**  the panels, these frames are drawn and pushed whole.
+*/
+class CPanelLayer
+{
+public:
+	CPanelLayer() : Valid(false), KeepPanels(false), AnyChanged(false),
+		ScreenWidth(0), ScreenHeight(0), CursorArea() {}
+
+	void Update();
+	void Invalidate();
+	/// Draw the panel again in the next frame
+	void SetDirty(PanelType panel) { Keys[panel].clear(); }
+	/// True if the panels are kept on the screen this frame
+	bool IsKept() const { return KeepPanels; }
+	/// True if the panels must be drawn this frame
+	bool MustDraw() const { return !KeepPanels || AnyChanged; }
+	bool IsTimerOnMap() const;
+
+private:
+	bool CanKeepPanels() const;
+	void GetKey(PanelType panel, std::vector<size_t> &key) const;
+	void InvalidatePanel(PanelType panel) const;
+
+private:
+	std::vector<size_t> Keys[NumPanels]; /// Content keys of the drawn panels
+	bool Changed[NumPanels];             /// Panels changed this frame
+	bool Valid;                          /// The screen holds the drawn panels
+	bool KeepPanels;                     /// Keep the panels this frame
+	bool AnyChanged;                     /// Any panel changed this frame
+	int ScreenWidth;                     /// Screen size of the drawn panels
+	int ScreenHeight;
+	int CursorArea[4];                   /// Cursor area of the last frame
+};
+
 class CUIUserButton
 {
 public:
@@ -474,6 +532,9 @@ public:
 	// Game timer
 	CUITimer Timer;                     /// game timer
 
+	// Panels kept on the screen
+	CPanelLayer PanelLayer;             /// panels drawn only when changed
+
 	// Offsets for 640x480 center used by menus
 	int Offset640X;                     /// Offset for 640x480 X position
 	int Offset480Y;                     /// Offset for 640x480 Y position
@@ -55,6 +55,7 @@
 class CAnimation;
 class CBuildRestrictionOnTop;
 class CConstructionFrame;
+class CDrawItem;
 class CFile;
 class Missile;
 class CMapField;
@@ -616,8 +617,8 @@ extern void CleanDecorations();
 
 /// Draw unit's shadow
 extern void DrawShadow(const CUnitType &type, int frame, const PixelPos &screenPos);
-/// Draw all units visible on map in viewport
-extern int FindAndSortUnits(const CViewport &vp, std::vector<CUnit *> &table);
+/// Find and sort all units visible on map in viewport
+extern void FindAndSortUnits(const CViewport &vp, std::vector<CDrawItem> &table);
 
 /// Show a unit's orders.
 extern void ShowOrder(const CUnit &unit);
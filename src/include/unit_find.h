@@ -311,6 +311,10 @@ extern CUnit *FindIdleWorker(const CPlayer &player, const CUnit *last);
 /// Find the neareast piece of terrain with specific flags.
 extern bool FindTerrainType(int movemask, int resmask, int range,
 							const CPlayer &player, const Vec2i &startPos, Vec2i *pos);
+/// Find the neareast piece of terrain with specific flags, keep the searched tiles.
+extern bool FindTerrainType(int movemask, int resmask, int range,
+							const CPlayer &player, const Vec2i &startPos, Vec2i *pos,
+							TerrainTraversal &terrainTraversal);
 
 extern void FindUnitsByType(const CUnitType &type, std::vector<CUnit *> &units, bool everybody = false);
 
@@ -339,6 +339,8 @@ public:
 	virtual ~CBuildRestriction() {}
 	virtual void Init() {};
 	virtual bool Check(const CUnit *builder, const CUnitType &type, const Vec2i &pos, CUnit *&ontoptarget) const = 0;
+	/// Tiles around the building in which the check looks at units
+	virtual int Range() const { return 0; }
 };
 
 class CBuildRestrictionAnd : public CBuildRestriction
@@ -360,6 +362,15 @@ public:
 		}
 	}
 	virtual bool Check(const CUnit *builder, const CUnitType &type, const Vec2i &pos, CUnit *&ontoptarget) const;
+	virtual int Range() const
+	{
+		int range = 0;
+		for (std::vector<CBuildRestriction *>::const_iterator i = _or_list.begin();
+			 i != _or_list.end(); ++i) {
+			range = std::max(range, (*i)->Range());
+		}
+		return range;
+	}
 
 	void push_back(CBuildRestriction *restriction) { _or_list.push_back(restriction); }
 public:
@@ -405,6 +416,7 @@ public:
 	virtual ~CBuildRestrictionOnTop() {};
 	virtual void Init() {this->Parent = UnitTypeByIdent(this->ParentName);};
 	virtual bool Check(const CUnit *builder, const CUnitType &type, const Vec2i &pos, CUnit *&ontoptarget) const;
+	virtual int Range() const;
 
 	std::string ParentName;  /// building that is unit is an addon too.
 	CUnitType *Parent;       /// building that is unit is an addon too.
@@ -419,6 +431,7 @@ public:
 	virtual ~CBuildRestrictionDistance() {};
 	virtual void Init() {this->RestrictType = UnitTypeByIdent(this->RestrictTypeName);};
 	virtual bool Check(const CUnit *builder, const CUnitType &type, const Vec2i &pos, CUnit *&ontoptarget) const;
+	virtual int Range() const { return Distance + 2; }
 
 	int Distance;        /// distance to build (circle)
 	DistanceTypeType DistanceType;
@@ -451,6 +464,7 @@ public:
 	virtual ~CBuildRestrictionSurroundedBy() {};
 	virtual void Init() { this->RestrictType = UnitTypeByIdent(this->RestrictTypeName); };
 	virtual bool Check(const CUnit *builder, const CUnitType &type, const Vec2i &pos, CUnit *&ontoptarget) const;
+	virtual int Range() const { return Distance + 2; }
 
 	int Distance;
 	DistanceTypeType DistanceType;
@@ -517,6 +531,7 @@ public:
 	LuaCallback *DeathExplosion;
 	LuaCallback *OnHit;             /// lua function called when unit is hit
 	LuaCallback *OnEachCycle;       /// lua function called every cycle
+	LuaCallback *OnEachCycleBatch;  /// lua function called every cycle with the slots of all units of the type
 	LuaCallback *OnEachSecond;      /// lua function called every second
 	LuaCallback *OnInit;            /// lua function called on unit init
 
@@ -121,6 +121,12 @@ extern char *strcasestr(const char *str, const char *substr);
 extern size_t strnlen(const char *str, size_t strsize);
 #endif // !HAVE_STRNLEN
 
+/// Encode binary data as base64 text
+extern std::string EncodeBase64(const std::string &data);
+
+/// Decode base64 text
+extern bool DecodeBase64(const std::string &text, std::string &data);
+
 /*----------------------------------------------------------------------------
 --  Getopt
 ----------------------------------------------------------------------------*/
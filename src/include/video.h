@@ -443,6 +443,12 @@ extern int VideoValidResolution(int w, int h);
 /// Load graphic from PNG file
 extern int LoadGraphicPNG(CGraphic *g);
 
+/// Start decoding a png graphic file in the background
+extern void PrefetchGraphicPNG(const std::string &file);
+
+/// Drop all prefetched images which were not used and stop the prefetch threads
+extern void CleanPrefetchedGraphics();
+
 #if defined(USE_OPENGL) || defined(USE_GLES)
 
 /// Make an OpenGL texture
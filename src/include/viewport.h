@@ -32,8 +32,63 @@
 
 //@{
 
+#include <vector>
+
 #include "vec2i.h"
+
+class CParticle;
 class CUnit;
+class CViewport;
+class Missile;
+
+/// Kind of a draw list entry, in drawing order for equal draw levels
+enum DrawItemType {
+	DrawItemParticle,
+	DrawItemUnit,
+	DrawItemMissile
+};
+
+/**
+**  Entry of a viewport draw list.
+**
+**  Units, missiles and particles are merged into one list.
+**  The sort keys are computed once per frame, so comparing two entries
+**  never looks at the object behind them.
+*/
+class CDrawItem
+{
+public:
+	bool operator<(const CDrawItem &rhs) const
+	{
+		if (DrawLevel != rhs.DrawLevel) {
+			return DrawLevel < rhs.DrawLevel;
+		}
+		if (Type != rhs.Type) {
+			return Type < rhs.Type;
+		}
+		if (Y != rhs.Y) {
+			return Y < rhs.Y;
+		}
+		if (X != rhs.X) {
+			return X < rhs.X;
+		}
+		return Id < rhs.Id;
+	}
+
+	/// Draw the object of this entry
+	void Draw(const CViewport &vp) const;
+
+	int DrawLevel;       /// Draw level of the object
+	DrawItemType Type;   /// Kind of the object
+	int Y;               /// Bottom map pixel position of the unit
+	int X;               /// Tile X position of the unit
+	unsigned int Id;     /// Unit slot, missile slot or particle index
+	union {
+		CUnit *unit;
+		Missile *missile;
+		CParticle *particle;
+	} Object;            /// Object to draw, only valid for the current frame
+};
 
 /**
 **  A map viewport.
@@ -121,6 +176,9 @@ public:
 	int MapHeight;            /// Height in map tiles
 
 	CUnit *Unit;              /// Bound to this unit
+
+	/// Units, missiles and particles sorted for drawing, kept between frames
+	mutable std::vector<CDrawItem> DrawList;
 };
 
 //@}
@@ -71,29 +71,22 @@ void CMap::MarkSeenTile(CMapField &mf)
 	const unsigned int tile = mf.getGraphicTile();
 	const unsigned int seentile = mf.playerInfo.SeenTile;
 
+	//rb - GRRRRRRRRRRRR
+	const unsigned int index = &mf - Map.Fields;
+	const int y = index / Info.MapWidth;
+	const int x = index - (y * Info.MapWidth);
+	const Vec2i pos(x, y);
+
+	// Fog of war may have changed, even if the tile did not.
+	UI.Minimap.UpdateSeenXY(pos);
+
 	//  Nothing changed? Seeing already the correct tile.
 	if (tile == seentile) {
 		return;
 	}
 	mf.playerInfo.SeenTile = tile;
 
-#ifdef MINIMAP_UPDATE
-	//rb - GRRRRRRRRRRRR
-	const unsigned int index = &mf - Map.Fields;
-	const int y = index / Info.MapWidth;
-	const int x = index - (y * Info.MapWidth);
-	const Vec2i pos = {x, y}
-#endif
-
 	if (this->Tileset->TileTypeTable.empty() == false) {
-#ifndef MINIMAP_UPDATE
-		//rb - GRRRRRRRRRRRR
-		const unsigned int index = &mf - Map.Fields;
-		const int y = index / Info.MapWidth;
-		const int x = index - (y * Info.MapWidth);
-		const Vec2i pos(x, y);
-#endif
-
 		//  Handle wood changes. FIXME: check if for growing wood correct?
 		if (tile == this->Tileset->getRemovedTreeTile()) {
 			FixNeighbors(MapFieldForest, 1, pos);
@@ -308,7 +301,7 @@ void CMapInfo::Clear()
 	this->MapUID = 0;
 }
 
-CMap::CMap() : Fields(NULL), NoFogOfWar(false), TileGraphic(NULL)
+CMap::CMap() : Fields(NULL), NoFogOfWar(false), TileGraphic(NULL), ChangeCount(0)
 {
 	Tileset = new CTileset;
 }
@@ -347,6 +340,7 @@ void CMap::Clean()
 	// Tileset freed by Tileset?
 
 	this->Info.Clear();
+	this->Influence.Clean();
 	this->Fields = NULL;
 	this->NoFogOfWar = false;
 	this->Tileset->clear();
@@ -377,21 +371,15 @@ void CMap::Save(CFile &file) const
 	file.printf("  \"size\", {%d, %d},\n", this->Info.MapWidth, this->Info.MapHeight);
 	file.printf("  \"%s\",\n", this->NoFogOfWar ? "no-fog-of-war" : "fog-of-war");
 	file.printf("  \"filename\", \"%s\",\n", this->Info.Filename.c_str());
-	file.printf("  \"map-fields\", {\n");
-	for (int h = 0; h < this->Info.MapHeight; ++h) {
-		file.printf("  -- %d\n", h);
-		for (int w = 0; w < this->Info.MapWidth; ++w) {
-			const CMapField &mf = *this->Field(w, h);
-
-			mf.Save(file);
-			if (w & 1) {
-				file.printf(",\n");
-			} else {
-				file.printf(", ");
-			}
-		}
+	std::string planes;
+	CMapField::SavePlanes(this->Fields, this->Info.MapWidth, this->Info.MapHeight, planes);
+	const std::string text = EncodeBase64(planes);
+
+	file.printf("  \"map-field-planes\", [[\n");
+	for (size_t i = 0; i < text.size(); i += 76) {
+		file.printf("%s\n", text.substr(i, 76).c_str());
 	}
-	file.printf("}})\n");
+	file.printf("]]})\n");
 }
 
 /*----------------------------------------------------------------------------
@@ -524,6 +512,7 @@ void CMap::ClearWoodTile(const Vec2i &pos)
 	mf.setGraphicTile(this->Tileset->getRemovedTreeTile());
 	mf.Flags &= ~(MapFieldForest | MapFieldUnpassable);
 	mf.Value = 0;
+	++ChangeCount;
 
 	UI.Minimap.UpdateXY(pos);
 	FixNeighbors(MapFieldForest, 0, pos);
@@ -542,6 +531,7 @@ void CMap::ClearRockTile(const Vec2i &pos)
 	mf.setGraphicTile(this->Tileset->getRemovedRockTile());
 	mf.Flags &= ~(MapFieldRocks | MapFieldUnpassable);
 	mf.Value = 0;
+	++ChangeCount;
 
 	UI.Minimap.UpdateXY(pos);
 	FixNeighbors(MapFieldRocks, 0, pos);
@@ -589,6 +579,7 @@ void CMap::RegenerateForestTile(const Vec2i &pos)
 		&& topMf.Value >= ForestRegeneration
 		&& !(topMf.Flags & occupedFlag)) {
 		DebugPrint("Real place wood\n");
+		++ChangeCount;
 		topMf.setTileIndex(*Map.Tileset, Map.Tileset->getDefaultWoodTileIndex(), 0);
 		topMf.setGraphicTile(Map.Tileset->getTopOneTreeTile());
 		topMf.playerInfo.SeenTile = topMf.getGraphicTile();
@@ -29,6 +29,8 @@
 
 //@{
 
+#include <algorithm>
+
 #include "stratagus.h"
 
 #include "viewport.h"
@@ -319,6 +321,26 @@ static void ShowUnitName(const CViewport &vp, PixelPos pos, CUnit *unit, bool hi
 	}
 }
 
+/**
+**  Draw the unit, missile or particle of a draw list entry.
+**
+**  @param vp  Viewport to be drawn.
+*/
+void CDrawItem::Draw(const CViewport &vp) const
+{
+	switch (Type) {
+		case DrawItemUnit:
+			Object.unit->Draw(vp);
+			break;
+		case DrawItemMissile:
+			Object.missile->DrawMissile(vp);
+			break;
+		case DrawItemParticle:
+			Object.particle->draw();
+			break;
+	}
+}
+
 /**
 **  Draw a map viewport.
 */
@@ -333,76 +355,19 @@ void CViewport::Draw() const
 	CurrentViewport = this;
 	{
 		// Now we need to sort units, missiles, particles by draw level and draw them
-		std::vector<CUnit *> unittable;
-		std::vector<Missile *> missiletable;
-		std::vector<CParticle *> particletable;
-
-		FindAndSortUnits(*this, unittable);
-		const size_t nunits = unittable.size();
-		FindAndSortMissiles(*this, missiletable);
-		const size_t nmissiles = missiletable.size();
-		ParticleManager.prepareToDraw(*this, particletable);
-		const size_t nparticles = particletable.size();
-
-		size_t i = 0;
-		size_t j = 0;
-		size_t k = 0;
-
-
-		while ((i < nunits && j < nmissiles) || (i < nunits && k < nparticles)
-			   || (j < nmissiles && k < nparticles)) {
-			if (i == nunits) {
-				if (missiletable[j]->Type->DrawLevel < particletable[k]->getDrawLevel()) {
-					missiletable[j]->DrawMissile(*this);
-					++j;
-				} else {
-					particletable[k]->draw();
-					++k;
-				}
-			} else if (j == nmissiles) {
-				if (unittable[i]->Type->DrawLevel < particletable[k]->getDrawLevel()) {
-					unittable[i]->Draw(*this);
-					++i;
-				} else {
-					particletable[k]->draw();
-					++k;
-				}
-			} else if (k == nparticles) {
-				if (unittable[i]->Type->DrawLevel < missiletable[j]->Type->DrawLevel) {
-					unittable[i]->Draw(*this);
-					++i;
-				} else {
-					missiletable[j]->DrawMissile(*this);
-					++j;
-				}
-			} else {
-				if (unittable[i]->Type->DrawLevel <= missiletable[j]->Type->DrawLevel) {
-					if (unittable[i]->Type->DrawLevel < particletable[k]->getDrawLevel()) {
-						unittable[i]->Draw(*this);
-						++i;
-					} else {
-						particletable[k]->draw();
-						++k;
-					}
-				} else {
-					if (missiletable[j]->Type->DrawLevel < particletable[k]->getDrawLevel()) {
-						missiletable[j]->DrawMissile(*this);
-						++j;
-					} else {
-						particletable[k]->draw();
-						++k;
-					}
-				}
-			}
-		}
-		for (; i < nunits; ++i) {
-			unittable[i]->Draw(*this);
-		}
-		for (; j < nmissiles; ++j) {
-			missiletable[j]->DrawMissile(*this);
-		}
-		for (; k < nparticles; ++k) {
-			particletable[k]->draw();
+		std::vector<CDrawItem> &table = this->DrawList;
+
+		FindAndSortUnits(*this, table);
+		const size_t nunits = table.size();
+		FindAndSortMissiles(*this, table);
+		const size_t nmissiles = table.size() - nunits;
+		ParticleManager.prepareToDraw(*this, table);
+
+		std::inplace_merge(table.begin(), table.begin() + nunits, table.begin() + nunits + nmissiles);
+		std::inplace_merge(table.begin(), table.begin() + nunits + nmissiles, table.end());
+
+		for (size_t i = 0; i != table.size(); ++i) {
+			table[i].Draw(*this);
 		}
 		ParticleManager.endDraw();
 	}
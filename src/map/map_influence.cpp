@@ -0,0 +1,173 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name map_influence.cpp - The influence of the players on the map. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "map.h"
+
+#include "player.h"
+#include "unit.h"
+#include "unittype.h"
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Forget all units.
+*/
+void CMapInfluence::Clean()
+{
+	Width = 0;
+	Height = 0;
+	LargestUnit = 1;
+	Cells.clear();
+	Units.clear();
+}
+
+/**
+**  Add the influence of a unit placed on the map.
+**
+**  Only alive units have influence. What is added is remembered, so
+**  the unit can change its stats or owner before it is removed again.
+**
+**  @param unit  Unit inserted into the map.
+*/
+void CMapInfluence::Insert(const CUnit &unit)
+{
+	const int width = (Map.Info.MapWidth + CellSize - 1) >> CellShift;
+	const int height = (Map.Info.MapHeight + CellSize - 1) >> CellShift;
+
+	if (width != Width || height != Height) {
+		Clean();
+		Width = width;
+		Height = height;
+		Cells.resize(Width * Height * PlayerMax);
+	}
+	if (!unit.IsAlive()) {
+		return;
+	}
+	const size_t slot = UnitNumber(unit);
+	if (slot >= Units.size()) {
+		Units.resize(slot + 1);
+	}
+	UnitEntry &entry = Units[slot];
+	const CUnitType &type = *unit.Type;
+
+	Assert(entry.Cell == -1);
+	entry.Value = CInfluence();
+	entry.Value.Units = 1;
+	if (type.CanAttack) {
+		entry.Value.Strength = unit.Stats->Variables[BASICDAMAGE_INDEX].Value
+							   + unit.Stats->Variables[PIERCINGDAMAGE_INDEX].Value;
+	}
+	entry.Value.AntiAir = (type.CanTarget & CanTargetAir) ? 1 : 0;
+	entry.Value.AntiGround = (type.CanTarget & (CanTargetLand | CanTargetSea)) ? 1 : 0;
+	entry.Cell = ((unit.tilePos.y >> CellShift) * Width + (unit.tilePos.x >> CellShift)) * PlayerMax
+				 + unit.Player->Index;
+	Cells[entry.Cell].Add(entry.Value);
+	LargestUnit = std::max(LargestUnit, std::max(type.TileWidth, type.TileHeight));
+}
+
+/**
+**  Remove the influence of a unit removed from the map.
+**
+**  @param unit  Unit removed from the map.
+*/
+void CMapInfluence::Remove(const CUnit &unit)
+{
+	const size_t slot = UnitNumber(unit);
+
+	if (slot >= Units.size() || Units[slot].Cell == -1) {
+		return;
+	}
+	UnitEntry &entry = Units[slot];
+	Cells[entry.Cell].Sub(entry.Value);
+	entry.Cell = -1;
+}
+
+/**
+**  Influence of a player in a tile rectangle.
+**
+**  The cells are coarse, so the result contains at least all units
+**  which are partly in the rectangle, and maybe some near it.
+**
+**  @param player  Index of the player.
+**  @param minPos  Top left tile of the rectangle.
+**  @param maxPos  Bottom right tile of the rectangle.
+**
+**  @return        Influence of the units of the player.
+*/
+CInfluence CMapInfluence::Get(int player, const Vec2i &minPos, const Vec2i &maxPos) const
+{
+	CInfluence influence;
+
+	if (Cells.empty()) {
+		return influence;
+	}
+	// Units count in the cell of their top left tile.
+	const int minX = std::max(0, (minPos.x - LargestUnit + 1) >> CellShift);
+	const int minY = std::max(0, (minPos.y - LargestUnit + 1) >> CellShift);
+	const int maxX = std::min(Width - 1, maxPos.x >> CellShift);
+	const int maxY = std::min(Height - 1, maxPos.y >> CellShift);
+
+	for (int y = minY; y <= maxY; ++y) {
+		for (int x = minX; x <= maxX; ++x) {
+			influence.Add(Cells[(y * Width + x) * PlayerMax + player]);
+		}
+	}
+	return influence;
+}
+
+/**
+**  Influence of all players which are enemies of a player.
+**
+**  @param player  Player whose enemies are wanted.
+**  @param minPos  Top left tile of the rectangle.
+**  @param maxPos  Bottom right tile of the rectangle.
+**
+**  @return        Influence of the enemy units.
+*/
+CInfluence CMapInfluence::GetEnemies(const CPlayer &player, const Vec2i &minPos, const Vec2i &maxPos) const
+{
+	CInfluence influence;
+
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (Players[i].IsEnemy(player)) {
+			influence.Add(Get(i, minPos, maxPos));
+		}
+	}
+	return influence;
+}
+
+//@}
@@ -217,6 +217,7 @@ void CMap::RemoveWall(const Vec2i &pos)
 	CMapField &mf = *Field(pos);
 
 	mf.Value = 0;
+	++ChangeCount;
 
 	MapFixWallTile(pos);
 	mf.Flags &= ~(MapFieldHuman | MapFieldWall | MapFieldUnpassable);
@@ -248,6 +249,7 @@ void CMap::SetWall(const Vec2i &pos, bool humanwall)
 		const int value = UnitTypeOrcWall->MapDefaultStat.Variables[HP_INDEX].Max;
 		mf.setTileIndex(*Tileset, Tileset->getOrcWallTileIndex(0), value);
 	}
+	++ChangeCount;
 
 	UI.Minimap.UpdateXY(pos);
 	MapFixWallTile(pos);
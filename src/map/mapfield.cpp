@@ -45,6 +45,15 @@
 #include "unit.h"
 #include "unit_manager.h"
 
+/// Field flags kept in saved games
+static const unsigned short SavedFieldFlags =
+	MapFieldHuman | MapFieldLandAllowed | MapFieldCoastAllowed | MapFieldWaterAllowed
+	| MapFieldNoBuilding | MapFieldUnpassable | MapFieldWall | MapFieldRocks | MapFieldForest
+	| MapFieldLandUnit | MapFieldAirUnit | MapFieldSeaUnit | MapFieldBuilding;
+
+/// Version of the map field planes format
+static const unsigned char FieldPlanesVersion = 1;
+
 CMapField::CMapField() :
 #ifdef DEBUG
 	tilesetTile(0),
@@ -150,6 +159,114 @@ void CMapField::Save(CFile &file) const
 }
 
 
+static void PutShort(std::string &data, unsigned short value)
+{
+	data += (char)(value & 0xFF);
+	data += (char)(value >> 8);
+}
+
+static unsigned short GetShort(const unsigned char *data)
+{
+	return data[0] | (data[1] << 8);
+}
+
+/**
+**  Save map fields as binary planes.
+**
+**  Each member of the fields is stored in its own plane, which is much
+**  smaller and faster to load than a lua table for each field.
+**  Contains the same information as CMapField::Save.
+**
+**  @param fields  Map fields, row by row.
+**  @param width   Map width.
+**  @param height  Map height.
+**  @param data    Filled with the planes.
+*/
+/* static */ void CMapField::SavePlanes(const CMapField *fields, int width, int height, std::string &data)
+{
+	const int size = width * height;
+
+	data.clear();
+	data.reserve(10 + size * 10);
+	data += "SMF";
+	data += (char)FieldPlanesVersion;
+	PutShort(data, width);
+	PutShort(data, height);
+
+	for (int i = 0; i != size; ++i) {
+		PutShort(data, fields[i].tile);
+	}
+	for (int i = 0; i != size; ++i) {
+		PutShort(data, fields[i].playerInfo.SeenTile);
+	}
+	for (int i = 0; i != size; ++i) {
+		PutShort(data, fields[i].Flags & SavedFieldFlags);
+	}
+	for (int i = 0; i != size; ++i) {
+		data += (char)fields[i].Value;
+	}
+	for (int i = 0; i != size; ++i) {
+		data += (char)fields[i].cost;
+	}
+	for (int i = 0; i != size; ++i) {
+		unsigned short explored = 0;
+		for (int p = 0; p != PlayerMax; ++p) {
+			if (fields[i].playerInfo.Visible[p] == 1) {
+				explored |= 1 << p;
+			}
+		}
+		PutShort(data, explored);
+	}
+}
+
+/**
+**  Load map fields from binary planes saved by CMapField::SavePlanes.
+**
+**  @param fields  Map fields, row by row.
+**  @param width   Map width.
+**  @param height  Map height.
+**  @param data    The planes.
+**
+**  @return        false if the planes don't match the map.
+*/
+/* static */ bool CMapField::ParsePlanes(CMapField *fields, int width, int height, const std::string &data)
+{
+	const int size = width * height;
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data());
+
+	if (data.size() != 8 + size * 10u || data.compare(0, 3, "SMF") != 0) {
+		return false;
+	}
+	if (p[3] != FieldPlanesVersion || GetShort(p + 4) != width || GetShort(p + 6) != height) {
+		return false;
+	}
+	p += 8;
+	for (int i = 0; i != size; ++i, p += 2) {
+		fields[i].tile = GetShort(p);
+	}
+	for (int i = 0; i != size; ++i, p += 2) {
+		fields[i].playerInfo.SeenTile = GetShort(p);
+	}
+	for (int i = 0; i != size; ++i, p += 2) {
+		fields[i].Flags |= GetShort(p) & SavedFieldFlags;
+	}
+	for (int i = 0; i != size; ++i, ++p) {
+		fields[i].Value = *p;
+	}
+	for (int i = 0; i != size; ++i, ++p) {
+		fields[i].cost = *p;
+	}
+	for (int i = 0; i != size; ++i, p += 2) {
+		const unsigned short explored = GetShort(p);
+		for (int j = 0; j != PlayerMax; ++j) {
+			if (explored & (1 << j)) {
+				fields[i].playerInfo.Visible[j] = 1;
+			}
+		}
+	}
+	return true;
+}
+
 void CMapField::parse(lua_State *l)
 {
 	if (!lua_istable(l, -1)) {
@@ -34,6 +34,7 @@
 ----------------------------------------------------------------------------*/
 
 #include <string.h>
+#include <vector>
 
 #include "stratagus.h"
 
@@ -99,6 +100,36 @@ struct MinimapEvent {
 } MinimapEvents[MAX_MINIMAP_EVENTS];
 int NumMinimapEvents;
 
+/**
+**  Unit drawn on the minimap, indexed by unit slot.
+*/
+struct MinimapUnitDot {
+	MinimapUnitDot() : X(0), Y(0), W(0), H(0), Color(0), Stamp(0) {}
+
+	int X;              /// Left minimap pixel
+	int Y;              /// Top minimap pixel
+	int W;              /// Width in minimap pixels
+	int H;              /// Height in minimap pixels
+	Uint32 Color;       /// Color of the dot
+	unsigned int Stamp; /// Update in which the dot was drawn
+};
+
+static std::vector<MinimapUnitDot> MinimapUnitDots; /// Dots by unit slot
+static std::vector<int> MinimapDrawnUnits;          /// Slots of the drawn units in draw order
+static unsigned int MinimapUpdateStamp = 1;         /// Counter of minimap updates
+
+static std::vector<int> MinimapDirtyMinX;  /// First dirty pixel of each minimap row
+static std::vector<int> MinimapDirtyMaxX;  /// Last dirty pixel of each minimap row
+static bool MinimapDirty;                  /// Any row is dirty
+
+/// Settings the minimap was last drawn with, change needs a full redraw
+static struct {
+	int PlayerIndex;
+	bool RevealMap;
+	bool NoFogOfWar;
+	bool WithTerrain;
+} MinimapDrawnWith;
+
 
 /*----------------------------------------------------------------------------
 -- Functions
@@ -186,6 +217,11 @@ void CMinimap::Create()
 
 	UpdateTerrain();
 
+	MinimapDirtyMinX.assign(H, W);
+	MinimapDirtyMaxX.assign(H, -1);
+	MinimapDrawnWith.PlayerIndex = -1;
+	MarkDirty(0, 0, W - 1, H - 1);
+
 	NumMinimapEvents = 0;
 }
 
@@ -426,12 +462,54 @@ void CMinimap::UpdateXY(const Vec2i &pos)
 		SDL_UnlockSurface(MinimapTerrainSurface);
 	}
 	SDL_UnlockSurface(Map.TileGraphic->Surface);
+
+	UpdateSeenXY(pos);
 }
 
 /**
-**  Draw a unit on the minimap.
+**  Mark a rectangle of the minimap to be redrawn on next update.
+**
+**  @param x0  Left minimap pixel.
+**  @param y0  Top minimap pixel.
+**  @param x1  Right minimap pixel (included).
+**  @param y1  Bottom minimap pixel (included).
 */
-static void DrawUnitOn(CUnit &unit, int red_phase)
+void CMinimap::MarkDirty(int x0, int y0, int x1, int y1)
+{
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, W - 1);
+	y1 = std::min(y1, int(MinimapDirtyMinX.size()) - 1);
+	for (int my = y0; my <= y1; ++my) {
+		MinimapDirtyMinX[my] = std::min(MinimapDirtyMinX[my], x0);
+		MinimapDirtyMaxX[my] = std::max(MinimapDirtyMaxX[my], x1);
+		MinimapDirty = true;
+	}
+}
+
+/**
+**  Mark the minimap pixels of a map tile to be redrawn, after a change of
+**  its terrain or fog of war.
+**
+**  @param pos  The map position to update in the minimap
+*/
+void CMinimap::UpdateSeenXY(const Vec2i &pos)
+{
+	if (MinimapDirtyMinX.empty()) {
+		return;
+	}
+	const int x0 = XOffset + (pos.x * MinimapScaleX) / MINIMAP_FAC;
+	const int y0 = YOffset + (pos.y * MinimapScaleY) / MINIMAP_FAC;
+	const int x1 = XOffset + ((pos.x + 1) * MinimapScaleX) / MINIMAP_FAC;
+	const int y1 = YOffset + ((pos.y + 1) * MinimapScaleY) / MINIMAP_FAC;
+
+	MarkDirty(x0, y0, x1, y1);
+}
+
+/**
+**  Compute the minimap dot of a unit.
+*/
+static void GetUnitDot(const CUnit &unit, int red_phase, MinimapUnitDot &dot)
 {
 	const CUnitType *type;
 
@@ -462,47 +540,99 @@ static void DrawUnitOn(CUnit &unit, int red_phase)
 		color = PlayerColors[GameSettings.Presets[unit.Player->Index].PlayerColor][0];
 	}
 
-	int mx = 1 + UI.Minimap.XOffset + Map2MinimapX[unit.tilePos.x];
-	int my = 1 + UI.Minimap.YOffset + Map2MinimapY[unit.tilePos.y];
-	int w = Map2MinimapX[type->TileWidth];
-	if (mx + w >= UI.Minimap.W) { // clip right side
-		w = UI.Minimap.W - mx;
-	}
-	int h0 = Map2MinimapY[type->TileHeight];
-	if (my + h0 >= UI.Minimap.H) { // clip bottom side
-		h0 = UI.Minimap.H - my;
-	}
+	dot.X = 1 + UI.Minimap.XOffset + Map2MinimapX[unit.tilePos.x];
+	dot.Y = 1 + UI.Minimap.YOffset + Map2MinimapY[unit.tilePos.y];
+	dot.W = std::min(Map2MinimapX[type->TileWidth] + 1, UI.Minimap.W - dot.X);
+	dot.H = std::min(Map2MinimapY[type->TileHeight] + 1, UI.Minimap.H - dot.Y);
+	dot.Color = color;
+}
+
+/**
+**  Draw a unit on the minimap.
+**
+**  Only the dirty part of each minimap row is drawn.
+*/
+static void DrawUnitOn(const MinimapUnitDot &dot)
+{
 	int bpp = 0;
 #if defined(USE_OPENGL) || defined(USE_GLES)
 	if (!UseOpenGL)
 #endif
 	{
-		SDL_Color c;
 		bpp = MinimapSurface->format->BytesPerPixel;
-		SDL_GetRGB(color, TheScreen->format, &c.r, &c.g, &c.b);
 	}
-	while (w-- >= 0) {
-		int h = h0;
-		while (h-- >= 0) {
+	for (int my = dot.Y; my < dot.Y + dot.H; ++my) {
+		const int minX = std::max(dot.X, MinimapDirtyMinX[my]);
+		const int maxX = std::min(dot.X + dot.W - 1, MinimapDirtyMaxX[my]);
+
+		for (int mx = minX; mx <= maxX; ++mx) {
 #if defined(USE_OPENGL) || defined(USE_GLES)
 			if (UseOpenGL) {
-				*(Uint32 *)&(MinimapSurfaceGL[((mx + w) + (my + h) * MinimapTextureWidth) * 4]) = color;
+				*(Uint32 *)&(MinimapSurfaceGL[(mx + my * MinimapTextureWidth) * 4]) = dot.Color;
 			} else
 #endif
 			{
-				const unsigned int index = (mx + w) * bpp + (my + h) * MinimapSurface->pitch;
+				const unsigned int index = mx * bpp + my * MinimapSurface->pitch;
 				if (bpp == 2) {
-					*(Uint16 *)&((Uint8 *)MinimapSurface->pixels)[index] = color;
+					*(Uint16 *)&((Uint8 *)MinimapSurface->pixels)[index] = dot.Color;
 				} else {
-					*(Uint32 *)&((Uint8 *)MinimapSurface->pixels)[index] = color;
+					*(Uint32 *)&((Uint8 *)MinimapSurface->pixels)[index] = dot.Color;
 				}
 			}
 		}
 	}
 }
 
+/**
+**  Find the units whose minimap dot changed since the last update, and
+**  mark their old and new place dirty.
+*/
+void CMinimap::UpdateUnits(int red_phase)
+{
+	std::vector<int> drawnUnits;
+
+	++MinimapUpdateStamp;
+	if (MinimapUnitDots.size() < UnitManager.GetUsedSlotCount()) {
+		MinimapUnitDots.resize(UnitManager.GetUsedSlotCount());
+	}
+	drawnUnits.reserve(MinimapDrawnUnits.size());
+	for (CUnitManager::Iterator it = UnitManager.begin(); it != UnitManager.end(); ++it) {
+		CUnit &unit = **it;
+		if (!unit.IsVisibleOnMinimap()) {
+			continue;
+		}
+		const int slot = UnitNumber(unit);
+		MinimapUnitDot &dot = MinimapUnitDots[slot];
+		MinimapUnitDot newDot;
+
+		GetUnitDot(unit, red_phase, newDot);
+		newDot.Stamp = MinimapUpdateStamp;
+		if (dot.Stamp + 1 != MinimapUpdateStamp || dot.X != newDot.X || dot.Y != newDot.Y
+			|| dot.W != newDot.W || dot.H != newDot.H || dot.Color != newDot.Color) {
+			if (dot.Stamp + 1 == MinimapUpdateStamp) {
+				MarkDirty(dot.X, dot.Y, dot.X + dot.W - 1, dot.Y + dot.H - 1);
+			}
+			MarkDirty(newDot.X, newDot.Y, newDot.X + newDot.W - 1, newDot.Y + newDot.H - 1);
+		}
+		dot = newDot;
+		drawnUnits.push_back(slot);
+	}
+	// Erase the units which are not drawn anymore.
+	for (size_t i = 0; i != MinimapDrawnUnits.size(); ++i) {
+		const MinimapUnitDot &dot = MinimapUnitDots[MinimapDrawnUnits[i]];
+
+		if (dot.Stamp + 1 == MinimapUpdateStamp) {
+			MarkDirty(dot.X, dot.Y, dot.X + dot.W - 1, dot.Y + dot.H - 1);
+		}
+	}
+	MinimapDrawnUnits.swap(drawnUnits);
+}
+
 /**
 **  Update the minimap with the current game information
+**
+**  Only the pixels whose terrain, fog of war or units changed since the
+**  last update are redrawn.
 */
 void CMinimap::Update()
 {
@@ -513,52 +643,74 @@ void CMinimap::Update()
 		red_phase = !red_phase;
 	}
 
-	// Clear Minimap background if not transparent
-	if (!Transparent) {
-#if defined(USE_OPENGL) || defined(USE_GLES)
-		if (UseOpenGL) {
-			memset(MinimapSurfaceGL, 0, MinimapTextureWidth * MinimapTextureHeight * 4);
-		} else
-#endif
-		{
-			SDL_FillRect(MinimapSurface, NULL, SDL_MapRGB(MinimapSurface->format, 0, 0, 0));
-		}
+	// Redraw all after a change of the point of view.
+	if (MinimapDrawnWith.PlayerIndex != ThisPlayer->Index
+		|| MinimapDrawnWith.RevealMap != (ReplayRevealMap != 0)
+		|| MinimapDrawnWith.NoFogOfWar != Map.NoFogOfWar
+		|| MinimapDrawnWith.WithTerrain != WithTerrain) {
+		MinimapDrawnWith.PlayerIndex = ThisPlayer->Index;
+		MinimapDrawnWith.RevealMap = ReplayRevealMap != 0;
+		MinimapDrawnWith.NoFogOfWar = Map.NoFogOfWar;
+		MinimapDrawnWith.WithTerrain = WithTerrain;
+		MarkDirty(0, 0, W - 1, H - 1);
 	}
 
-	int bpp;
-#if defined(USE_OPENGL) || defined(USE_GLES)
-	if (UseOpenGL) {
-		bpp = 0;
-	} else
-#endif
-	{
-		bpp = MinimapSurface->format->BytesPerPixel;
+	UpdateUnits(red_phase);
+	if (!MinimapDirty) {
+		return;
 	}
 
 	//
-	// Draw the terrain
+	// Draw the terrain, or clear the background if not transparent
 	//
-	if (WithTerrain) {
 #if defined(USE_OPENGL) || defined(USE_GLES)
-		if (UseOpenGL) {
-			memcpy(MinimapSurfaceGL, MinimapTerrainSurfaceGL, MinimapTextureWidth * MinimapTextureHeight * 4);
-		} else
+	if (UseOpenGL) {
+		for (int my = 0; my < H; ++my) {
+			if (MinimapDirtyMinX[my] > MinimapDirtyMaxX[my]) {
+				continue;
+			}
+			const int offset = (MinimapDirtyMinX[my] + my * MinimapTextureWidth) * 4;
+			const int size = (MinimapDirtyMaxX[my] - MinimapDirtyMinX[my] + 1) * 4;
+			if (WithTerrain) {
+				memcpy(MinimapSurfaceGL + offset, MinimapTerrainSurfaceGL + offset, size);
+			} else if (!Transparent) {
+				memset(MinimapSurfaceGL + offset, 0, size);
+			}
+		}
+	} else
 #endif
-		{
-			SDL_BlitSurface(MinimapTerrainSurface, NULL, MinimapSurface, NULL);
+	{
+		for (int my = 0; my < H; ++my) {
+			if (MinimapDirtyMinX[my] > MinimapDirtyMaxX[my]) {
+				continue;
+			}
+			SDL_Rect rect = {Sint16(MinimapDirtyMinX[my]), Sint16(my),
+							 Uint16(MinimapDirtyMaxX[my] - MinimapDirtyMinX[my] + 1), 1};
+			if (WithTerrain) {
+				SDL_Rect drect = rect;
+				SDL_BlitSurface(MinimapTerrainSurface, &rect, MinimapSurface, &drect);
+			} else if (!Transparent) {
+				SDL_FillRect(MinimapSurface, &rect, SDL_MapRGB(MinimapSurface->format, 0, 0, 0));
+			}
 		}
 	}
 
+	int bpp;
 #if defined(USE_OPENGL) || defined(USE_GLES)
-	if (!UseOpenGL)
+	if (UseOpenGL) {
+		bpp = 0;
+	} else
 #endif
 	{
+		bpp = MinimapSurface->format->BytesPerPixel;
 		SDL_LockSurface(MinimapSurface);
-		SDL_LockSurface(MinimapTerrainSurface);
 	}
 
+	//
+	// Draw the fog of war
+	//
 	for (int my = 0; my < H; ++my) {
-		for (int mx = 0; mx < W; ++mx) {
+		for (int mx = MinimapDirtyMinX[my]; mx <= MinimapDirtyMaxX[my]; ++mx) {
 			int visiontype; // 0 unexplored, 1 explored, >1 visible.
 
 			if (ReplayRevealMap) {
@@ -586,21 +738,11 @@ void CMinimap::Update()
 		}
 	}
 
-#if defined(USE_OPENGL) || defined(USE_GLES)
-	if (!UseOpenGL)
-#endif
-	{
-		SDL_UnlockSurface(MinimapTerrainSurface);
-	}
-
 	//
 	// Draw units on map
 	//
-	for (CUnitManager::Iterator it = UnitManager.begin(); it != UnitManager.end(); ++it) {
-		CUnit &unit = **it;
-		if (unit.IsVisibleOnMinimap()) {
-			DrawUnitOn(unit, red_phase);
-		}
+	for (size_t i = 0; i != MinimapDrawnUnits.size(); ++i) {
+		DrawUnitOn(MinimapUnitDots[MinimapDrawnUnits[i]]);
 	}
 #if defined(USE_OPENGL) || defined(USE_GLES)
 	if (!UseOpenGL)
@@ -608,6 +750,10 @@ void CMinimap::Update()
 	{
 		SDL_UnlockSurface(MinimapSurface);
 	}
+
+	std::fill(MinimapDirtyMinX.begin(), MinimapDirtyMinX.end(), W);
+	std::fill(MinimapDirtyMaxX.begin(), MinimapDirtyMaxX.end(), -1);
+	MinimapDirty = false;
 }
 
 /**
@@ -747,6 +893,11 @@ void CMinimap::Destroy()
 	Minimap2MapX = NULL;
 	delete[] Minimap2MapY;
 	Minimap2MapY = NULL;
+	MinimapDirtyMinX.clear();
+	MinimapDirtyMaxX.clear();
+	MinimapDirty = false;
+	MinimapUnitDots.clear();
+	MinimapDrawnUnits.clear();
 }
 
 /**
@@ -779,6 +930,14 @@ void CMinimap::AddEvent(const Vec2i &pos, Uint32 color)
 	++NumMinimapEvents;
 }
 
+/**
+**  Check if minimap events are shown, they change the minimap each frame.
+*/
+bool CMinimap::HasEvents() const
+{
+	return NumMinimapEvents != 0;
+}
+
 bool CMinimap::Contains(const PixelPos &screenPos) const
 {
 	return this->X <= screenPos.x && screenPos.x < this->X + this->W
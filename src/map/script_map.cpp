@@ -117,6 +117,12 @@ static int CclStratagusMap(lua_State *l)
 						lua_pop(l, 1);
 					}
 					lua_pop(l, 1);
+				} else if (!strcmp(value, "map-field-planes")) {
+					std::string planes;
+					if (!DecodeBase64(LuaToString(l, j + 1, k + 1), planes)
+						|| !CMapField::ParsePlanes(Map.Fields, Map.Info.MapWidth, Map.Info.MapHeight, planes)) {
+						LuaError(l, "incorrect map field planes");
+					}
 				} else {
 					LuaError(l, "Unsupported tag: %s" _C_ value);
 				}
@@ -49,6 +49,7 @@
 #include "player.h"
 #include "sound.h"
 #include "spells.h"
+#include "synchash.h"
 #include "trigger.h"
 #include "ui.h"
 #include "unit.h"
@@ -56,6 +57,7 @@
 #include "unitsound.h"
 #include "unittype.h"
 #include "video.h"
+#include "viewport.h"
 
 /*----------------------------------------------------------------------------
 --  Declarations
@@ -102,9 +104,17 @@ void MissileType::LoadMissileSprite()
 void LoadMissileSprites()
 {
 #ifndef DYNAMIC_LOAD
+	for (MissileTypeMap::iterator it = MissileTypes.begin(); it != MissileTypes.end(); ++it) {
+		const MissileType &mtype = *(*it).second;
+
+		if (mtype.G && !mtype.G->IsLoaded()) {
+			PrefetchGraphicPNG(mtype.G->File);
+		}
+	}
 	for (MissileTypeMap::iterator it = MissileTypes.begin(); it != MissileTypes.end(); ++it) {
 		(*it).second->LoadMissileSprite();
 	}
+	CleanPrefetchedGraphics();
 #endif
 }
 /**
@@ -553,24 +563,30 @@ void Missile::DrawMissile(const CViewport &vp) const
 	}
 }
 
-static bool MissileDrawLevelCompare(const Missile *const l, const Missile *const r)
+/**
+**  Fill the draw list entry of a missile.
+*/
+static void MakeMissileDrawItem(Missile &missile, CDrawItem &item)
 {
-	if (l->Type->DrawLevel == r->Type->DrawLevel) {
-		return l->Slot < r->Slot;
-	} else {
-		return l->Type->DrawLevel < r->Type->DrawLevel;
-	}
+	item.DrawLevel = missile.Type->DrawLevel;
+	item.Type = DrawItemMissile;
+	item.Y = 0;
+	item.X = 0;
+	item.Id = missile.Slot;
+	item.Object.missile = &missile;
 }
 
 /**
 **  Sort visible missiles on map for display.
 **
 **  @param vp         Viewport pointer.
-**  @param table      OUT : array of missile to display sorted by DrawLevel.
+**  @param table      OUT : missiles to display sorted by DrawLevel
+**                    are appended to the table.
 */
-void FindAndSortMissiles(const CViewport &vp, std::vector<Missile *> &table)
+void FindAndSortMissiles(const CViewport &vp, std::vector<CDrawItem> &table)
 {
 	typedef std::vector<Missile *>::const_iterator MissilePtrConstiterator;
+	const size_t n = table.size();
 
 	// Loop through global missiles, then through locals.
 	for (MissilePtrConstiterator i = GlobalMissiles.begin(); i != GlobalMissiles.end(); ++i) {
@@ -580,7 +596,8 @@ void FindAndSortMissiles(const CViewport &vp, std::vector<Missile *> &table)
 		}
 		// Draw only visible missiles
 		if (MissileVisibleInViewport(vp, missile)) {
-			table.push_back(&missile);
+			table.push_back(CDrawItem());
+			MakeMissileDrawItem(missile, table.back());
 		}
 	}
 
@@ -590,9 +607,10 @@ void FindAndSortMissiles(const CViewport &vp, std::vector<Missile *> &table)
 			continue;  // delayed or hidden -> aren't shown
 		}
 		// Local missile are visible.
-		table.push_back(&missile);
+		table.push_back(CDrawItem());
+		MakeMissileDrawItem(missile, table.back());
 	}
-	std::sort(table.begin(), table.end(), MissileDrawLevelCompare);
+	std::sort(table.begin() + n, table.end());
 }
 
 /**
@@ -1198,6 +1216,41 @@ void MissileActions()
 	MissilesActionLoop(LocalMissiles);
 }
 
+/**
+**  Add the global missiles to a sync hash.
+**
+**  Local missiles are only seen by this player.
+*/
+void HashGlobalMissiles(CSyncHasher &hasher)
+{
+	for (std::vector<Missile *>::const_iterator it = GlobalMissiles.begin(); it != GlobalMissiles.end(); ++it) {
+		const Missile &missile = **it;
+
+		hasher.Add(missile.Slot);
+		hasher.Add(missile.position.x);
+		hasher.Add(missile.position.y);
+		hasher.Add(missile.State);
+		hasher.Add(missile.Wait);
+		hasher.Add(missile.Delay);
+		hasher.Add(missile.TTL);
+		hasher.Add(missile.Damage);
+	}
+}
+
+/**
+**  Dump the global missiles to find desyncs.
+*/
+void DumpGlobalMissiles(FILE *file)
+{
+	for (std::vector<Missile *>::const_iterator it = GlobalMissiles.begin(); it != GlobalMissiles.end(); ++it) {
+		const Missile &missile = **it;
+
+		fprintf(file, "missile %u %s %d,%d state %d wait %d delay %d ttl %d damage %d\n",
+				missile.Slot, missile.Type->Ident.c_str(), missile.position.x, missile.position.y,
+				missile.State, missile.Wait, missile.Delay, missile.TTL, missile.Damage);
+	}
+}
+
 /**
 **  Calculate distance from view-point to missile.
 **
@@ -517,6 +517,53 @@ int NetRecvUDP(Socket sockfd, void *buf, int len, unsigned long *hostFrom, int *
 	return l;
 }
 
+#ifdef USE_UDP_BATCHES
+/**
+**  Receive all pending datagrams, up to count, from a UDP socket.
+**  Waits for the first datagram, but not for the others.
+**
+**  @param sockfd     Socket
+**  @param bufs       Receive message buffers, count buffers of len bytes.
+**  @param len        Length of each receive message buffer.
+**  @param count      Number of receive message buffers.
+**  @param lens       Number of bytes placed in each buffer.
+**  @param hostsFrom  hosts of the senders.
+**  @param portsFrom  ports of the senders.
+**
+**  @return Number of datagrams received, or -1 if failure.
+*/
+int NetRecvUDPBatch(Socket sockfd, unsigned char *bufs, int len, int count, int *lens,
+					unsigned long *hostsFrom, int *portsFrom)
+{
+	std::vector<struct mmsghdr> msgs(count);
+	std::vector<struct iovec> iovs(count);
+	std::vector<struct sockaddr_in> sock_addrs(count);
+
+	for (int i = 0; i != count; ++i) {
+		iovs[i].iov_base = bufs + i * len;
+		iovs[i].iov_len = len;
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &sock_addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+	}
+	const int n = recvmmsg(sockfd, &msgs[0], count, MSG_WAITFORONE, NULL);
+
+	if (n < 0) {
+		PrintFunction();
+		fprintf(stdout, "Could not read from UDP socket\n");
+		return -1;
+	}
+	for (int i = 0; i != n; ++i) {
+		lens[i] = msgs[i].msg_len;
+		hostsFrom[i] = sock_addrs[i].sin_addr.s_addr;
+		portsFrom[i] = ntohs(sock_addrs[i].sin_port);
+	}
+	return n;
+}
+#endif
+
 /**
 **  Receive from a TCP socket.
 **
@@ -569,6 +616,63 @@ int NetSendUDP(Socket sockfd, unsigned long host, int port,
 	return sendto(sockfd, (sendtobuftype)buf, len, 0, (struct sockaddr *)&sock_addr, n);
 }
 
+/**
+**  Send the same datagram through a UDP socket to several hosts, with one
+**  system call where sendmmsg is available.
+**
+**  @param sockfd  Socket
+**  @param hosts   Hosts to send to (network byte order).
+**  @param ports   Ports of the hosts to send to.
+**  @param count   Number of hosts.
+**  @param buf     Send message buffer.
+**  @param len     Send message buffer length.
+**
+**  @return Number of datagrams sent.
+*/
+int NetSendUDPToHosts(Socket sockfd, const unsigned long *hosts, const int *ports, int count,
+					  const void *buf, int len)
+{
+#ifdef USE_UDP_BATCHES
+	std::vector<struct mmsghdr> msgs(count);
+	std::vector<struct sockaddr_in> sock_addrs(count);
+	struct iovec iov;
+
+	iov.iov_base = const_cast<void *>(buf);
+	iov.iov_len = len;
+	for (int i = 0; i != count; ++i) {
+		memset(&sock_addrs[i], 0, sizeof(sock_addrs[i]));
+		sock_addrs[i].sin_addr.s_addr = hosts[i];
+		sock_addrs[i].sin_port = htons(ports[i]);
+		sock_addrs[i].sin_family = AF_INET;
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_iov = &iov;
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &sock_addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+	}
+	int done = 0;
+	int sent = 0;
+	while (done != count) {
+		const int n = sendmmsg(sockfd, &msgs[done], count - done, 0);
+		if (n > 0) {
+			done += n;
+			sent += n;
+		} else if (n == 0 || errno != EINTR) {
+			++done; // skip the datagram that failed, like sendto
+		}
+	}
+	return sent;
+#else
+	int sent = 0;
+	for (int i = 0; i != count; ++i) {
+		if (NetSendUDP(sockfd, hosts[i], ports[i], buf, len) >= 0) {
+			++sent;
+		}
+	}
+	return sent;
+#endif
+}
+
 /**
 **  Send through a TCP socket.
 **
@@ -592,7 +696,7 @@ int NetSendTCP(Socket sockfd, const void *buf, int len)
 */
 int NetListenTCP(Socket sockfd)
 {
-	return listen(sockfd, PlayerMax);
+	return listen(sockfd, SOMAXCONN);
 }
 
 /**
@@ -121,16 +121,25 @@ size_t serialize(unsigned char *buf, const std::vector<unsigned char> &data)
 		buf += serialize16(buf, uint16_t(data.size()));
 		memcpy(buf, &data[0], data.size());
 		buf += data.size();
-		//Wyrmgus start
-//		if ((data.size() & 0x03) != 0) {
-//			memset(buf, 0, data.size() & 0x03);
-//		}
-		//Wyrmgus end
 	}
-	//Wyrmgus start
-//	return 2 + ((data.size() + 3) & ~0x03); // round up to multiple of 4 for alignment.
-	return 2 + (data.size() + 3);
-	//Wyrmgus end
+	return 2 + data.size();
+}
+/**
+**  Serialize a number in 7 bit groups, the high bit marks that more follow.
+*/
+size_t serializeVarint(unsigned char *buf, uint32_t data)
+{
+	size_t size = 1;
+
+	for (; data >= 0x80; data >>= 7, ++size) {
+		if (buf) {
+			*buf++ = uint8_t(data | 0x80);
+		}
+	}
+	if (buf) {
+		*buf = uint8_t(data);
+	}
+	return size;
 }
 
 size_t deserialize32(const unsigned char *buf, uint32_t *data)
@@ -186,10 +195,28 @@ size_t deserialize(const unsigned char *buf, std::vector<unsigned char> &data)
 
 	buf += deserialize16(buf, &size);
 	data.assign(buf, buf + size);
-	//Wyrmgus start
-//	return 2 + ((data.size() + 3) & ~0x03); // round up to multiple of 4 for alignment.
-	return 2 + (data.size() + 3);
-	//Wyrmgus end
+	return 2 + data.size();
+}
+size_t deserializeVarint(const unsigned char *buf, uint32_t *data)
+{
+	const unsigned char *p = buf;
+
+	*data = 0;
+	for (int shift = 0; shift < 32; shift += 7) {
+		*data |= uint32_t(*p & 0x7F) << shift;
+		if ((*p++ & 0x80) == 0) {
+			break;
+		}
+	}
+	return p - buf;
+}
+size_t deserializeVarint(const unsigned char *buf, uint16_t *data)
+{
+	uint32_t value;
+	const size_t size = deserializeVarint(buf, &value);
+
+	*data = uint16_t(value);
+	return size;
 }
 
 //
@@ -467,6 +494,8 @@ CInitMessage_Welcome::CInitMessage_Welcome() :
 {
 	this->Lag = CNetworkParameter::Instance.NetworkLag;
 	this->gameCyclesPerUpdate = CNetworkParameter::Instance.gameCyclesPerUpdate;
+	this->RelayHost = NetworkRelay.getIp();
+	this->RelayPort = NetworkRelay.getPort();
 }
 
 const unsigned char *CInitMessage_Welcome::Serialize() const
@@ -480,6 +509,8 @@ const unsigned char *CInitMessage_Welcome::Serialize() const
 	}
 	p += serialize32(p, this->Lag);
 	p += serialize32(p, this->gameCyclesPerUpdate);
+	p += serialize32(p, this->RelayHost);
+	p += serialize16(p, this->RelayPort);
 	return buf;
 }
 
@@ -491,6 +522,8 @@ void CInitMessage_Welcome::Deserialize(const unsigned char *p)
 	}
 	p += deserialize32(p, &this->Lag);
 	p += deserialize32(p, &this->gameCyclesPerUpdate);
+	p += deserialize32(p, &this->RelayHost);
+	p += deserialize16(p, &this->RelayPort);
 }
 
 //
@@ -583,21 +616,68 @@ void CInitMessage_Resync::Deserialize(const unsigned char *p)
 
 size_t CNetworkCommand::Serialize(unsigned char *buf) const
 {
-	unsigned char *p = buf;
-	p += serialize16(p, this->Unit);
-	p += serialize16(p, this->X);
-	p += serialize16(p, this->Y);
-	p += serialize16(p, this->Dest);
-	return p - buf;
+	size_t size = 0;
+	size += serializeVarint(buf ? buf + size : NULL, this->Unit);
+	size += serializeVarint(buf ? buf + size : NULL, this->X);
+	size += serializeVarint(buf ? buf + size : NULL, this->Y);
+	// No destination (0xFFFF) is the most common value.
+	size += serializeVarint(buf ? buf + size : NULL, uint16_t(this->Dest + 1));
+	return size;
 }
 
 size_t CNetworkCommand::Deserialize(const unsigned char *buf)
 {
 	const unsigned char *p = buf;
-	p += deserialize16(p, &this->Unit);
-	p += deserialize16(p, &this->X);
-	p += deserialize16(p, &this->Y);
-	p += deserialize16(p, &this->Dest);
+	p += deserializeVarint(p, &this->Unit);
+	p += deserializeVarint(p, &this->X);
+	p += deserializeVarint(p, &this->Y);
+	p += deserializeVarint(p, &this->Dest);
+	this->Dest -= 1;
+	return p - buf;
+}
+
+//
+// CNetworkGroupCommand
+//
+
+size_t CNetworkGroupCommand::Serialize(unsigned char *buf) const
+{
+	size_t size = 0;
+	size += serializeVarint(buf ? buf + size : NULL, this->Type);
+	size += serializeVarint(buf ? buf + size : NULL, this->X);
+	size += serializeVarint(buf ? buf + size : NULL, this->Y);
+	size += serializeVarint(buf ? buf + size : NULL, uint16_t(this->Dest + 1));
+	size += serializeVarint(buf ? buf + size : NULL, uint32_t(this->Units.size()));
+	// Units are sorted, store the distance to the previous one.
+	uint16_t previous = 0;
+	for (size_t i = 0; i != this->Units.size(); ++i) {
+		size += serializeVarint(buf ? buf + size : NULL, uint16_t(this->Units[i] - previous));
+		previous = this->Units[i];
+	}
+	return size;
+}
+
+size_t CNetworkGroupCommand::Deserialize(const unsigned char *buf)
+{
+	const unsigned char *p = buf;
+	uint32_t type;
+	uint32_t count;
+
+	p += deserializeVarint(p, &type);
+	this->Type = uint8_t(type);
+	p += deserializeVarint(p, &this->X);
+	p += deserializeVarint(p, &this->Y);
+	p += deserializeVarint(p, &this->Dest);
+	this->Dest -= 1;
+	p += deserializeVarint(p, &count);
+	this->Units.resize(std::min<uint32_t>(count, MaxGroupCommandUnits));
+	uint16_t previous = 0;
+	for (size_t i = 0; i != this->Units.size(); ++i) {
+		uint16_t distance;
+		p += deserializeVarint(p, &distance);
+		this->Units[i] = previous + distance;
+		previous = this->Units[i];
+	}
 	return p - buf;
 }
 
@@ -690,6 +770,54 @@ size_t CNetworkCommandQuit::Deserialize(const unsigned char *buf)
 	return p - buf;
 }
 
+//
+// CNetworkCommandLag
+//
+
+size_t CNetworkCommandLag::Serialize(unsigned char *buf) const
+{
+	unsigned char *p = buf;
+	p += serialize16(p, this->player);
+	p += serialize16(p, this->lag);
+	return p - buf;
+}
+
+size_t CNetworkCommandLag::Deserialize(const unsigned char *buf)
+{
+	const unsigned char *p = buf;
+	p += deserialize16(p, &this->player);
+	p += deserialize16(p, &this->lag);
+	return p - buf;
+}
+
+//
+// CNetworkSyncHashes
+//
+
+size_t CNetworkSyncHashes::Serialize(unsigned char *buf) const
+{
+	unsigned char *p = buf;
+	p += serialize16(p, this->player);
+	p += serialize8(p, this->flags);
+	p += serialize32(p, this->cycle);
+	for (int i = 0; i != SyncHashCount; ++i) {
+		p += serialize32(p, this->hashes[i]);
+	}
+	return p - buf;
+}
+
+size_t CNetworkSyncHashes::Deserialize(const unsigned char *buf)
+{
+	const unsigned char *p = buf;
+	p += deserialize16(p, &this->player);
+	p += deserialize8(p, &this->flags);
+	p += deserialize32(p, &this->cycle);
+	for (int i = 0; i != SyncHashCount; ++i) {
+		p += deserialize32(p, &this->hashes[i]);
+	}
+	return p - buf;
+}
+
 //
 // CNetworkSelection
 //
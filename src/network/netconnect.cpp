@@ -781,6 +781,7 @@ void CClient::Parse_Welcome(const unsigned char *buf)
 	Hosts[0].SetName(msg.hosts[0].PlyName); // Name of server player
 	CNetworkParameter::Instance.NetworkLag = msg.Lag;
 	CNetworkParameter::Instance.gameCyclesPerUpdate = msg.gameCyclesPerUpdate;
+	NetworkRelay = CHost(msg.RelayHost, msg.RelayPort);
 
 	Hosts[0].Host = serverHost.getIp();
 	Hosts[0].Port = serverHost.getPort();
@@ -69,27 +69,113 @@ bool CHost::isValid() const
 class CUDPSocket_Impl
 {
 public:
-	CUDPSocket_Impl() : socket(Socket(-1)) {}
+	CUDPSocket_Impl() : sendCalls(0), receiveCalls(0), selectCalls(0), socket(Socket(-1))
+#ifdef USE_UDP_BATCHES
+		, receivedCount(0), nextReceived(0)
+#endif
+	{}
 	~CUDPSocket_Impl() { if (IsValid()) { Close(); } }
 	bool Open(const CHost &host) { socket = NetOpenUDP(host.getIp(), host.getPort()); return socket != INVALID_SOCKET; }
-	void Close() { NetCloseUDP(socket); socket = Socket(-1); }
-	void Send(const CHost &host, const void *buf, unsigned int len) { NetSendUDP(socket, host.getIp(), host.getPort(), buf, len); }
-	int Recv(void *buf, int len, CHost *hostFrom)
+	void Close()
 	{
-		unsigned long ip;
-		int port;
-		int res = NetRecvUDP(socket, buf, len, &ip, &port);
-		*hostFrom = CHost(ip, port);
-		return res;
+		NetCloseUDP(socket);
+		socket = Socket(-1);
+#ifdef USE_UDP_BATCHES
+		receivedCount = nextReceived = 0;
+#endif
+	}
+	void Send(const CHost &host, const void *buf, unsigned int len)
+	{
+		NetSendUDP(socket, host.getIp(), host.getPort(), buf, len);
+		++sendCalls;
 	}
+	void Send(const std::vector<CHost> &hosts, const void *buf, unsigned int len);
+	int Recv(void *buf, int len, CHost *hostFrom);
 	void SetNonBlocking() { NetSetNonBlocking(socket); }
-	int HasDataToRead(int timeout) { return NetSocketReady(socket, timeout); }
+	int HasDataToRead(int timeout)
+	{
+#ifdef USE_UDP_BATCHES
+		if (nextReceived != receivedCount) {
+			return 1;
+		}
+#endif
+		++selectCalls;
+		return NetSocketReady(socket, timeout);
+	}
 	bool IsValid() const { return socket != Socket(-1); }
 	int GetSocketAddresses(unsigned long *ips, int maxAddr) { return NetSocketAddr(socket, ips, maxAddr); }
+public:
+	unsigned int sendCalls;     /// System calls to send datagrams
+	unsigned int receiveCalls;  /// System calls to receive datagrams
+	unsigned int selectCalls;   /// System calls to wait for datagrams
 private:
 	Socket socket;
+#ifdef USE_UDP_BATCHES
+	static const int BatchSize = 32;       /// Datagrams received at once
+	static const int BatchBufSize = 2048;  /// Size of each receive buffer
+
+	std::vector<unsigned char> receivedBufs;  /// Received, not yet read datagrams
+	int receivedLens[BatchSize];
+	unsigned long receivedIps[BatchSize];
+	int receivedPorts[BatchSize];
+	int receivedCount;  /// Number of datagrams in the buffers
+	int nextReceived;   /// Next datagram to read
+#endif
 };
 
+void CUDPSocket_Impl::Send(const std::vector<CHost> &hosts, const void *buf, unsigned int len)
+{
+	std::vector<unsigned long> ips(hosts.size());
+	std::vector<int> ports(hosts.size());
+
+	if (hosts.empty()) {
+		return;
+	}
+	for (size_t i = 0; i != hosts.size(); ++i) {
+		ips[i] = hosts[i].getIp();
+		ports[i] = hosts[i].getPort();
+	}
+	NetSendUDPToHosts(socket, &ips[0], &ports[0], hosts.size(), buf, len);
+#ifdef USE_UDP_BATCHES
+	++sendCalls;
+#else
+	sendCalls += hosts.size();
+#endif
+}
+
+/**
+**  Receive a datagram. With batches, all pending datagrams are received
+**  at once and returned by the next calls.
+*/
+int CUDPSocket_Impl::Recv(void *buf, int len, CHost *hostFrom)
+{
+#ifdef USE_UDP_BATCHES
+	if (nextReceived == receivedCount) {
+		receivedBufs.resize(BatchSize * BatchBufSize);
+		nextReceived = 0;
+		receivedCount = NetRecvUDPBatch(socket, &receivedBufs[0], BatchBufSize, BatchSize,
+										receivedLens, receivedIps, receivedPorts);
+		++receiveCalls;
+		if (receivedCount < 0) {
+			receivedCount = 0;
+			return -1;
+		}
+	}
+	const int i = nextReceived++;
+	const int res = std::min(len, receivedLens[i]);
+	memcpy(buf, &receivedBufs[i * BatchBufSize], res);
+	*hostFrom = CHost(receivedIps[i], receivedPorts[i]);
+	return res;
+#else
+	unsigned long ip;
+	int port;
+	int res = NetRecvUDP(socket, buf, len, &ip, &port);
+	++receiveCalls;
+	*hostFrom = CHost(ip, port);
+	return res;
+#endif
+}
+
 //
 // CUDPSocket
 //
@@ -111,6 +197,9 @@ void CUDPSocket::CStatistic::clear()
 	sentPacketsCount = 0;
 	biggestReceivedPacketSize = 0;
 	biggestSentPacketSize = 0;
+	sendCallsCount = 0;
+	receiveCallsCount = 0;
+	selectCallsCount = 0;
 }
 
 #endif
@@ -141,14 +230,40 @@ void CUDPSocket::Send(const CHost &host, const void *buf, unsigned int len)
 	++m_statistic.sentPacketsCount;
 	m_statistic.sentBytesCount += len;
 	m_statistic.biggestSentPacketSize = std::max(m_statistic.biggestSentPacketSize, len);
+	++m_statistic.sendCallsCount;
 #endif
 	m_impl->Send(host, buf, len);
 }
 
+/**
+**  Send the same datagram to several hosts, with one system call where
+**  the system allows it.
+*/
+void CUDPSocket::Send(const std::vector<CHost> &hosts, const void *buf, unsigned int len)
+{
+#ifdef DEBUG
+	const unsigned int calls = m_impl->sendCalls;
+
+	m_statistic.sentPacketsCount += hosts.size();
+	m_statistic.sentBytesCount += hosts.size() * len;
+	if (!hosts.empty()) {
+		m_statistic.biggestSentPacketSize = std::max(m_statistic.biggestSentPacketSize, len);
+	}
+#endif
+	m_impl->Send(hosts, buf, len);
+#ifdef DEBUG
+	m_statistic.sendCallsCount += m_impl->sendCalls - calls;
+#endif
+}
+
 int CUDPSocket::Recv(void *buf, int len, CHost *hostFrom)
 {
+#ifdef DEBUG
+	const unsigned int calls = m_impl->receiveCalls;
+#endif
 	const int res = m_impl->Recv(buf, len, hostFrom);
 #ifdef DEBUG
+	m_statistic.receiveCallsCount += m_impl->receiveCalls - calls;
 	m_statistic.receivedBytesExpectedCount += len;
 	if (res == -1) {
 		++m_statistic.receivedErrorCount;
@@ -168,7 +283,14 @@ void CUDPSocket::SetNonBlocking()
 
 int CUDPSocket::HasDataToRead(int timeout)
 {
+#ifdef DEBUG
+	const unsigned int calls = m_impl->selectCalls;
+	const int res = m_impl->HasDataToRead(timeout);
+	m_statistic.selectCallsCount += m_impl->selectCalls - calls;
+	return res;
+#else
 	return m_impl->HasDataToRead(timeout);
+#endif
 }
 
 bool CUDPSocket::IsValid() const
@@ -146,6 +146,22 @@
 ** If there are missing packages, the game is paused and old commands
 ** are resend to all clients.
 **
+** The lag chosen in the game setup is only the start value. Each player
+** measures how long the packets of the others take to arrive after it sent
+** its own packet for the same gameNetCycle and periodically sends the lag
+** it needs in a MessageLag. Every NetworkLagUpdates updates all players
+** switch to the highest reported lag at the same gameNetCycle. When the lag
+** grows, the skipped gameNetCycles are sent at once; when it shrinks,
+** nothing is sent until the new lag reaches the last sent gameNetCycle.
+**
+** Without a relay the clients send their packets to the server, which
+** forwards them to the other clients. If the server is started with a
+** relay (option -r), the address of the relay is sent to the clients in
+** the welcome message and all players send their in-game packets only to
+** the relay (tools/netrelay.cpp). The relay forwards each packet to the
+** other players, answers the resend requests from its copies of the
+** packets and logs the commands of the game.
+**
 ** @section missing What features are missing
 **
 ** @li The recover from lost packets can be improved, as the player knows
@@ -156,8 +172,7 @@
 **
 ** @li Add a server/client protocol, which allows more players per game.
 **
-** @li Lag (latency) and bandwidth should be automatic detected during game setup
-** and later during game automatic adapted.
+** @li Bandwidth should be automatic detected during game setup.
 **
 ** @li Also it would be nice, if we support viewing clients. This means
 ** other people can view the game in progress.
@@ -165,8 +180,8 @@
 ** @li The current protocol only uses single cast, for local LAN we
 ** should also support broadcast and multicast.
 **
-** @li Proxy and relays should be supported, to improve the playable
-** over the internet.
+** @li Proxies should be supported, to improve the playable over the
+** internet.
 **
 ** @li We can sort the command by importants, currently all commands are
 ** send in order, only chat messages are send if there are free slots.
@@ -237,6 +252,7 @@
 #include "player.h"
 #include "replay.h"
 #include "sound.h"
+#include "synchash.h"
 #include "translate.h"
 #include "unit.h"
 #include "unit_manager.h"
@@ -282,23 +298,67 @@ CNetworkParameter::CNetworkParameter()
 	gameCyclesPerUpdate = 1;
 	NetworkLag = 10;
 	timeoutInS = 45;
+	relayPort = defaultRelayPort;
 }
 
 void CNetworkParameter::FixValues()
 {
 	gameCyclesPerUpdate = std::max(gameCyclesPerUpdate, 1u);
 	NetworkLag = std::max(NetworkLag, 2u * gameCyclesPerUpdate);
+	// Commands are only sent for multiples of gameCyclesPerUpdate.
+	NetworkLag = (NetworkLag + gameCyclesPerUpdate - 1) / gameCyclesPerUpdate * gameCyclesPerUpdate;
+}
+
+/* static */ const unsigned int CNetworkLagEstimator::MaxLag;
+
+/**
+**  Add a measured delay.
+**
+**  @param delay  Delay of a packet in ms.
+*/
+void CNetworkLagEstimator::AddSample(int delay)
+{
+	delay = std::max(delay, 0);
+	if (Samples++ == 0) {
+		Delay = delay << 3;
+		Deviation = delay << 1;
+		return;
+	}
+	const int error = delay - (Delay >> 3);
+	Delay += error;
+	Deviation += abs(error) - (Deviation >> 2);
+}
+
+/**
+**  Lag needed to receive the packets in time.
+**
+**  A packet sent lag game cycles ahead must arrive before the game
+**  cycle after the update which checks that its gameNetCycle is ready.
+**
+**  @param msPerCycle           Duration of a game cycle in ms.
+**  @param gameCyclesPerUpdate  Game cycles between network updates.
+**
+**  @return  Lag in game cycles, a multiple of gameCyclesPerUpdate.
+*/
+unsigned int CNetworkLagEstimator::NeededLag(unsigned int msPerCycle, unsigned int gameCyclesPerUpdate) const
+{
+	const unsigned int delay = (Delay >> 3) + Deviation;
+	const unsigned int cycles = (delay + msPerCycle - 1) / msPerCycle + gameCyclesPerUpdate - 1;
+
+	return (cycles + gameCyclesPerUpdate - 1) / gameCyclesPerUpdate * gameCyclesPerUpdate;
 }
 
 bool NetworkInSync = true;                 /// Network is in sync
 
 CUDPSocket NetworkFildes;                  /// Network file descriptor
+CHost NetworkRelay;                        /// Relay of the in-game packets
 
 static unsigned long NetworkLastFrame[PlayerMax]; /// Last frame received packet
 static unsigned long NetworkLastCycle[PlayerMax]; /// Last cycle received packet
 
 static int NetworkSyncSeeds[256];          /// Network sync seeds.
 static int NetworkSyncHashs[256];          /// Network sync hashs.
+static unsigned long NetworkSyncCycles[256]; /// Game cycle of the network sync hashs.
 static CNetworkCommandQueue NetworkIn[256][PlayerMax][MaxNetworkCommands]; /// Per-player network packet input queue
 static std::deque<CNetworkCommandQueue> CommandsIn;    /// Network command input queue
 static std::deque<CNetworkCommandQueue> MsgCommandsIn; /// Network message input queue
@@ -330,6 +390,9 @@ static void printStatistic(const CUDPSocket::CStatistic &statistic)
 			   statistic.receivedPacketsCount _C_ statistic.receivedBytesCount
 			   _C_ statistic.biggestReceivedPacketSize);
 	DebugPrint("Received: %d error(s).\n" _C_ statistic.receivedErrorCount);
+	DebugPrint("System calls: %d to send, %d to receive, %d to wait.\n"
+			   _C_ statistic.sendCallsCount _C_ statistic.receiveCallsCount
+			   _C_ statistic.selectCallsCount);
 }
 
 static CNetworkStat NetworkStat;
@@ -337,6 +400,14 @@ static CNetworkStat NetworkStat;
 
 static int PlayerQuit[PlayerMax];          /// Player quit
 
+static const unsigned int NetworkLagUpdates = 16;   /// Adapt the lag every # network updates
+
+static unsigned long NetworkLastSentCycle;           /// Last gameNetCycle we sent commands for
+static unsigned long NetworkSentTicks[256];          /// Time we sent our commands of a gameNetCycle
+static unsigned long NetworkArrivalTicks[256][PlayerMax]; /// Time the commands of a player arrived
+static CNetworkLagEstimator NetworkLagEstimators[PlayerMax]; /// Delay of the packets of each player
+static unsigned int NetworkLagReports[PlayerMax];    /// Lag needed by each player
+
 //----------------------------------------------------------------------------
 //  Mid-Level api functions
 //----------------------------------------------------------------------------
@@ -354,15 +425,18 @@ static void NetworkBroadcast(const CNetworkPacket &packet, int numcommands, int
 	packet.Serialize(buf, numcommands);
 
 	// Send to all clients.
-	if (NetConnectType == 1) { // server
+	if (NetworkRelay.isValid()) { // the relay forwards to everybody
+		NetworkFildes.Send(NetworkRelay, buf, size);
+	} else if (NetConnectType == 1) { // server
+		std::vector<CHost> hosts;
 		for (int i = 0; i < HostsCount; ++i) {
-			const CHost host(Hosts[i].Host, Hosts[i].Port);
 			if (Hosts[i].PlyNr == player) {
 				continue;
 			}
-			NetworkFildes.Send(host, buf, size);
+			hosts.push_back(CHost(Hosts[i].Host, Hosts[i].Port));
 		}
-	} else { // client		
+		NetworkFildes.Send(hosts, buf, size);
+	} else { // client
 		const CHost host(Hosts[HostsCount - 1].Host, Hosts[HostsCount - 1].Port);
 		NetworkFildes.Send(host, buf, size);
 	}
@@ -422,6 +496,13 @@ void InitNetwork1()
 	DebugPrint("My host:port %s\n" _C_ hostStr.c_str());
 #endif
 
+	// Clients get the relay of the server with the welcome message.
+	const std::string &relayHost = CNetworkParameter::Instance.relayHost;
+	NetworkRelay = relayHost.empty() ? CHost() : CHost(relayHost.c_str(), CNetworkParameter::Instance.relayPort);
+	if (!relayHost.empty() && !NetworkRelay.isValid()) {
+		fprintf(stderr, "NETWORK: Relay %s not found, playing without relay\n", relayHost.c_str());
+	}
+
 	unsigned long ips[10];
 	int networkNumInterfaces = NetworkFildes.GetSocketAddresses(ips, 10);
 	if (networkNumInterfaces) {
@@ -500,9 +581,20 @@ void NetworkOnStartGame()
 	}
 	memset(NetworkSyncSeeds, 0, sizeof(NetworkSyncSeeds));
 	memset(NetworkSyncHashs, 0, sizeof(NetworkSyncHashs));
+	memset(NetworkSyncCycles, 0, sizeof(NetworkSyncCycles));
+	InitSyncHashes();
 	memset(PlayerQuit, 0, sizeof(PlayerQuit));
 	memset(NetworkLastFrame, 0, sizeof(NetworkLastFrame));
 	memset(NetworkLastCycle, 0, sizeof(NetworkLastCycle));
+
+	const unsigned int gameCyclesPerUpdate = CNetworkParameter::Instance.gameCyclesPerUpdate;
+	NetworkLastSentCycle = CNetworkParameter::Instance.NetworkLag / gameCyclesPerUpdate * gameCyclesPerUpdate;
+	memset(NetworkSentTicks, 0, sizeof(NetworkSentTicks));
+	memset(NetworkArrivalTicks, 0, sizeof(NetworkArrivalTicks));
+	for (int i = 0; i != PlayerMax; ++i) {
+		NetworkLagEstimators[i].Clear();
+		NetworkLagReports[i] = CNetworkParameter::Instance.NetworkLag;
+	}
 }
 
 //----------------------------------------------------------------------------
@@ -622,6 +714,28 @@ void NetworkSendSelection(CUnit **units, int count)
 	CommandsIn.push_back(ncq);
 }
 
+/**
+**  Send sync hashes to find a desync. (Message is sent with low priority)
+**
+**  @param flags   What we want, see ::SyncHashesFlags.
+**  @param hashes  Our hashes of a game cycle.
+*/
+void NetworkSendSyncHashes(int flags, const CSyncHashes &hashes)
+{
+	CNetworkSyncHashes nsh;
+	nsh.player = ThisPlayer->Index;
+	nsh.flags = flags;
+	nsh.cycle = hashes.Cycle;
+	for (int i = 0; i != SyncHashCount; ++i) {
+		nsh.hashes[i] = hashes.Hash[i];
+	}
+	CNetworkCommandQueue ncq;
+	ncq.Type = MessageSyncHashes;
+	ncq.Data.resize(nsh.Size());
+	nsh.Serialize(&ncq.Data[0]);
+	MsgCommandsIn.push_back(ncq);
+}
+
 /**
 **  Send chat message. (Message is sent with low priority)
 **
@@ -721,32 +835,41 @@ static void ParseResendCommand(const CNetworkPacket &packet)
 	}
 }
 
-static bool IsAValidCommand_Command(const CNetworkPacket &packet, int index, const int player)
+static bool IsAValidCommandUnit(unsigned int slot, int type, const int player)
 {
-	CNetworkCommand nc;
-	nc.Deserialize(&packet.Command[index][0]);
-	const unsigned int slot = nc.Unit;
 	const CUnit *unit = slot < UnitManager.GetUsedSlotCount() ? &UnitManager.GetSlotUnit(slot) : NULL;
 
-	if (unit && (unit->Player->Index == player
-				 || Players[player].IsTeamed(*unit) || unit->Player->Type == PlayerNeutral)) {
-		return true;
-	} else {
+	if (!unit) {
 		return false;
 	}
+	if ((type & 0x7F) == MessageCommandDismiss && unit->Type->ClicksToExplode) {
+		return true;
+	}
+	return unit->Player->Index == player
+		   || Players[player].IsTeamed(*unit) || unit->Player->Type == PlayerNeutral;
 }
 
-static bool IsAValidCommand_Dismiss(const CNetworkPacket &packet, int index, const int player)
+static bool IsAValidCommand_Command(const CNetworkPacket &packet, int index, const int player)
 {
 	CNetworkCommand nc;
 	nc.Deserialize(&packet.Command[index][0]);
-	const unsigned int slot = nc.Unit;
-	const CUnit *unit = slot < UnitManager.GetUsedSlotCount() ? &UnitManager.GetSlotUnit(slot) : NULL;
+	return IsAValidCommandUnit(nc.Unit, packet.Header.Type[index], player);
+}
 
-	if (unit && unit->Type->ClicksToExplode) {
-		return true;
+static bool IsAValidCommand_Group(const CNetworkPacket &packet, int index, const int player)
+{
+	CNetworkGroupCommand ngc;
+	ngc.Deserialize(&packet.Command[index][0]);
+	// Only unit commands can be grouped.
+	if ((ngc.Type & 0x7F) < MessageCommandStop || (ngc.Type & 0x7F) == MessageExtendedCommand) {
+		return false;
 	}
-	return IsAValidCommand_Command(packet, index, player);
+	for (size_t i = 0; i != ngc.Units.size(); ++i) {
+		if (!IsAValidCommandUnit(ngc.Units[i], ngc.Type, player)) {
+			return false;
+		}
+	}
+	return !ngc.Units.empty();
 }
 
 static bool IsAValidCommand(const CNetworkPacket &packet, int index, const int player)
@@ -758,8 +881,10 @@ static bool IsAValidCommand(const CNetworkPacket &packet, int index, const int p
 		case MessageQuit:      // FIXME: ensure it's from the right player
 		case MessageResend:    // FIXME: ensure it's from the right player
 		case MessageChat:      // FIXME: ensure it's from the right player
+		case MessageLag:       // FIXME: ensure it's from the right player
+		case MessageSyncHashes: // FIXME: ensure it's from the right player
 			return true;
-		case MessageCommandDismiss: return IsAValidCommand_Dismiss(packet, index, player);
+		case MessageGroupCommand: return IsAValidCommand_Group(packet, index, player);
 		default: return IsAValidCommand_Command(packet, index, player);
 	}
 	// FIXME: not all values in nc have been validated
@@ -783,7 +908,7 @@ static void NetworkParseInGameEvent(const unsigned char *buf, int len, const CHo
 		}
 		player = Hosts[index].PlyNr;
 	}
-	if (NetConnectType == 1) {
+	if (NetConnectType == 1 && !NetworkRelay.isValid()) {
 		if (player != 255) {
 			NetworkBroadcast(packet, commands, player);
 		}
@@ -793,6 +918,16 @@ static void NetworkParseInGameEvent(const unsigned char *buf, int len, const CHo
 		return;
 	}
 	NetworkLastCycle[player] = packet.Header.Cycle;
+	if (commands > 0 && packet.Header.Type[0] != MessageResend) {
+		unsigned long n = ((GameCycle + 128) & ~0xFF) | packet.Header.Cycle;
+		if (n > GameCycle + 128) {
+			n -= 0x100;
+		}
+		// Remember the first arrival, resent packets don't tell the delay.
+		if (NetworkIn[packet.Header.Cycle][player][0].Time != n) {
+			NetworkArrivalTicks[packet.Header.Cycle][player] = GetTicks();
+		}
+	}
 	// Parse the packet commands.
 	for (int i = 0; i != commands; ++i) {
 		// Handle some messages.
@@ -853,7 +988,7 @@ void NetworkEvent()
 		return;
 	}
 	// Read the packet.
-	unsigned char buf[1024];
+	unsigned char buf[MaxNetworkPacketSize];
 	CHost host;
 	int len = NetworkFildes.Recv(&buf, sizeof(buf), &host);
 	if (len < 0) {
@@ -884,9 +1019,7 @@ void NetworkQuitGame()
 	if (!ThisPlayer || IsNetworkGame() == false) {
 		return;
 	}
-	const int gameCyclesPerUpdate = CNetworkParameter::Instance.gameCyclesPerUpdate;
-	const int NetworkLag = CNetworkParameter::Instance.NetworkLag;
-	const int n = (GameCycle + gameCyclesPerUpdate) / gameCyclesPerUpdate * gameCyclesPerUpdate + NetworkLag;
+	const unsigned long n = NetworkLastSentCycle + CNetworkParameter::Instance.gameCyclesPerUpdate;
 	CNetworkCommandQueue(&ncqs)[MaxNetworkCommands] = NetworkIn[n & 0xFF][ThisPlayer->Index];
 	CNetworkCommandQuit nc;
 	nc.player = ThisPlayer->Index;
@@ -917,7 +1050,27 @@ static void NetworkExecCommand_Sync(const CNetworkCommandQueue &ncq)
 		DebugPrint("\nNetwork out of sync %x!=%x! %d!=%d! Cycle %lu\n\n" _C_
 				   syncSeed _C_ NetworkSyncSeeds[gameNetCycle & 0xFF] _C_
 				   syncHash _C_ NetworkSyncHashs[gameNetCycle & 0xFF] _C_ GameCycle);
+		SyncHashesMismatch(NetworkSyncCycles[gameNetCycle & 0xFF]);
+	} else {
+		SyncHashesMatched(NetworkSyncCycles[gameNetCycle & 0xFF]);
+	}
+}
+
+static void NetworkExecCommand_SyncHashes(const CNetworkCommandQueue &ncq)
+{
+	Assert((ncq.Type & 0x7F) == MessageSyncHashes);
+	CNetworkSyncHashes nsh;
+
+	nsh.Deserialize(&ncq.Data[0]);
+	if (nsh.player >= PlayerMax) {
+		return;
+	}
+	CSyncHashes hashes;
+	hashes.Cycle = nsh.cycle;
+	for (int i = 0; i != SyncHashCount; ++i) {
+		hashes.Hash[i] = nsh.hashes[i];
 	}
+	SyncHashesReceived(nsh.player, nsh.flags, hashes);
 }
 
 static void NetworkExecCommand_Selection(const CNetworkCommandQueue &ncq)
@@ -961,6 +1114,17 @@ static void NetworkExecCommand_Quit(const CNetworkCommandQueue &ncq)
 	CommandQuit(nc.player);
 }
 
+static void NetworkExecCommand_Lag(const CNetworkCommandQueue &ncq)
+{
+	Assert((ncq.Type & 0x7F) == MessageLag);
+	CNetworkCommandLag nc;
+
+	nc.Deserialize(&ncq.Data[0]);
+	if (nc.player < PlayerMax) {
+		NetworkLagReports[nc.player] = nc.lag;
+	}
+}
+
 static void NetworkExecCommand_ExtendedCommand(const CNetworkCommandQueue &ncq)
 {
 	Assert((ncq.Type & 0x7F) == MessageExtendedCommand);
@@ -979,6 +1143,17 @@ static void NetworkExecCommand_Command(const CNetworkCommandQueue &ncq)
 	ExecCommand(ncq.Type, nc.Unit, nc.X, nc.Y, nc.Dest);
 }
 
+static void NetworkExecCommand_Group(const CNetworkCommandQueue &ncq)
+{
+	Assert((ncq.Type & 0x7F) == MessageGroupCommand);
+	CNetworkGroupCommand ngc;
+
+	ngc.Deserialize(&ncq.Data[0]);
+	for (size_t i = 0; i != ngc.Units.size(); ++i) {
+		ExecCommand(ngc.Type, ngc.Units[i], ngc.X, ngc.Y, ngc.Dest);
+	}
+}
+
 /**
 **  Execute a network command.
 **
@@ -991,6 +1166,9 @@ static void NetworkExecCommand(const CNetworkCommandQueue &ncq)
 		case MessageSelection: NetworkExecCommand_Selection(ncq); break;
 		case MessageChat: NetworkExecCommand_Chat(ncq); break;
 		case MessageQuit: NetworkExecCommand_Quit(ncq); break;
+		case MessageLag: NetworkExecCommand_Lag(ncq); break;
+		case MessageGroupCommand: NetworkExecCommand_Group(ncq); break;
+		case MessageSyncHashes: NetworkExecCommand_SyncHashes(ncq); break;
 		case MessageExtendedCommand: NetworkExecCommand_ExtendedCommand(ncq); break;
 		case MessageNone:
 			// Nothing to Do, This Message Should Never be Executed
@@ -1000,6 +1178,65 @@ static void NetworkExecCommand(const CNetworkCommandQueue &ncq)
 	}
 }
 
+/**
+**  Merge the unit commands following ncq which only differ in the unit
+**  into one group command, like the commands of a group order.
+**
+**  @param ncq  Command taken from the command input queue.
+*/
+static void NetworkGroupCommands(CNetworkCommandQueue &ncq)
+{
+	if ((ncq.Type & 0x7F) < MessageCommandStop || (ncq.Type & 0x7F) == MessageExtendedCommand
+		|| CommandsIn.empty() || CommandsIn.front().Type != ncq.Type) {
+		return;
+	}
+	CNetworkCommand nc;
+	nc.Deserialize(&ncq.Data[0]);
+
+	CNetworkGroupCommand ngc;
+	ngc.Type = ncq.Type;
+	ngc.X = nc.X;
+	ngc.Y = nc.Y;
+	ngc.Dest = nc.Dest;
+	ngc.Units.push_back(nc.Unit);
+	while (!CommandsIn.empty() && CommandsIn.front().Type == ncq.Type
+		   && ngc.Units.size() < MaxGroupCommandUnits) {
+		CNetworkCommand next;
+		next.Deserialize(&CommandsIn.front().Data[0]);
+		if (next.X != nc.X || next.Y != nc.Y || next.Dest != nc.Dest) {
+			break;
+		}
+		ngc.Units.push_back(next.Unit);
+		CommandsIn.pop_front();
+	}
+	if (ngc.Units.size() == 1) {
+		return;
+	}
+	std::sort(ngc.Units.begin(), ngc.Units.end());
+	ncq.Type = MessageGroupCommand;
+	ncq.Data.resize(ngc.Size());
+	ngc.Serialize(&ncq.Data[0]);
+}
+
+/**
+**  Check if a command still fits into the packet.
+**
+**  @param size         Size of the packet so far, updated if the command fits.
+**  @param ncq          Command to add.
+**  @param numcommands  Number of commands in the packet.
+*/
+static bool NetworkFitsPacket(size_t &size, const CNetworkCommandQueue &ncq, int numcommands)
+{
+	// Each command has a 2 byte length prefix.
+	const size_t commandSize = 2 + ncq.Data.size();
+
+	if (numcommands && size + commandSize > MaxNetworkPacketSize) {
+		return false;
+	}
+	size += commandSize;
+	return true;
+}
+
 /**
 **  Network send commands.
 */
@@ -1019,10 +1256,12 @@ static void NetworkSendCommands(unsigned long gameNetCycle)
 		ncq[0].Time = gameNetCycle;
 		numcommands = 1;
 	} else {
+		size_t size = CNetworkPacketHeader::Size();
+
 		while (!CommandsIn.empty() && numcommands < MaxNetworkCommands) {
-			const CNetworkCommandQueue &incommand = CommandsIn.front();
+			CNetworkCommandQueue incommand = CommandsIn.front();
 #ifdef DEBUG
-			if (incommand.Type != MessageExtendedCommand) {
+			if (incommand.Type != MessageExtendedCommand && incommand.Type != MessageSelection) {
 				CNetworkCommand nc;
 				nc.Deserialize(&incommand.Data[0]);
 
@@ -1033,13 +1272,21 @@ static void NetworkSendCommands(unsigned long gameNetCycle)
 				}
 			}
 #endif
+			CommandsIn.pop_front();
+			NetworkGroupCommands(incommand);
+			if (!NetworkFitsPacket(size, incommand, numcommands)) {
+				CommandsIn.push_front(incommand);
+				break;
+			}
 			ncq[numcommands] = incommand;
 			ncq[numcommands].Time = gameNetCycle;
 			++numcommands;
-			CommandsIn.pop_front();
 		}
 		while (!MsgCommandsIn.empty() && numcommands < MaxNetworkCommands) {
 			const CNetworkCommandQueue &incommand = MsgCommandsIn.front();
+			if (!NetworkFitsPacket(size, incommand, numcommands)) {
+				break;
+			}
 			ncq[numcommands] = incommand;
 			ncq[numcommands].Time = gameNetCycle;
 			++numcommands;
@@ -1051,9 +1298,129 @@ static void NetworkSendCommands(unsigned long gameNetCycle)
 	}
 	NetworkSyncSeeds[gameNetCycle & 0xFF] = SyncRandSeed;
 	NetworkSyncHashs[gameNetCycle & 0xFF] = SyncHash;
+	// The state is the one hashed at the end of the last game cycle.
+	NetworkSyncCycles[gameNetCycle & 0xFF] = LastSyncHashesCycle;
+	NetworkSentTicks[gameNetCycle & 0xFF] = GetTicks();
+	NetworkLastSentCycle = gameNetCycle;
 	NetworkSendPacket(ncq);
 }
 
+/**
+**  Measure the delay of the packets of the other players.
+**
+**  @param gameNetCycle  Game cycle whose commands are complete.
+*/
+static void NetworkMeasureDelays(unsigned long gameNetCycle)
+{
+	const unsigned long sentTicks = NetworkSentTicks[gameNetCycle & 0xFF];
+
+	for (int i = 0; i < HostsCount; ++i) {
+		unsigned long &arrivalTicks = NetworkArrivalTicks[gameNetCycle & 0xFF][Hosts[i].PlyNr];
+
+		if (sentTicks && arrivalTicks) {
+			NetworkLagEstimators[Hosts[i].PlyNr].AddSample(long(arrivalTicks - sentTicks));
+		}
+		arrivalTicks = 0;
+	}
+}
+
+/**
+**  Lag to report for the delays measured from the other players.
+**
+**  @param estimators           Delays of the packets of the other players.
+**  @param msPerCycle           Duration of a game cycle in ms.
+**  @param gameCyclesPerUpdate  Game cycles between network updates.
+**
+**  @return  Lag needed to receive the packets of all of them in time, 0
+**           if no delay is known yet.
+*/
+unsigned int NetworkLagToReport(const std::vector<const CNetworkLagEstimator *> &estimators,
+								unsigned int msPerCycle, unsigned int gameCyclesPerUpdate)
+{
+	unsigned int lag = 0;
+
+	for (size_t i = 0; i != estimators.size(); ++i) {
+		if (estimators[i]->IsValid()) {
+			lag = std::max(lag, estimators[i]->NeededLag(msPerCycle, gameCyclesPerUpdate));
+		}
+	}
+	return std::min(lag, CNetworkLagEstimator::MaxLag);
+}
+
+/**
+**  Lag to use for the lags reported by all players.
+**
+**  The lag grows at once to the highest report but shrinks one update at
+**  a time, to not stall on the next delay peak.
+**
+**  @param networkLag           Current lag.
+**  @param reports              Last lag reported by each player.
+**  @param gameCyclesPerUpdate  Game cycles between network updates.
+**
+**  @return  New lag, a multiple of gameCyclesPerUpdate.
+*/
+unsigned int NetworkAdaptedLag(unsigned int networkLag, const std::vector<unsigned int> &reports,
+							   unsigned int gameCyclesPerUpdate)
+{
+	unsigned int lag = 0;
+
+	for (size_t i = 0; i != reports.size(); ++i) {
+		lag = std::max(lag, reports[i]);
+	}
+	if (lag < networkLag) {
+		lag = networkLag - gameCyclesPerUpdate;
+	}
+	lag = std::max(lag, 2 * gameCyclesPerUpdate);
+	return std::min(lag, CNetworkLagEstimator::MaxLag / gameCyclesPerUpdate * gameCyclesPerUpdate);
+}
+
+/**
+**  Send the lag we need to receive the packets of all players in time.
+*/
+static void NetworkSendLag()
+{
+	const unsigned int msPerCycle = std::max(100000 / (FRAMES_PER_SECOND * std::max(VideoSyncSpeed, 1)), 1);
+	std::vector<const CNetworkLagEstimator *> estimators;
+
+	for (int i = 0; i < HostsCount; ++i) {
+		estimators.push_back(&NetworkLagEstimators[Hosts[i].PlyNr]);
+	}
+	const unsigned int lag = NetworkLagToReport(estimators, msPerCycle, CNetworkParameter::Instance.gameCyclesPerUpdate);
+	if (lag == 0) {
+		return;
+	}
+	CNetworkCommandLag nc;
+	nc.player = ThisPlayer->Index;
+	nc.lag = lag;
+	CNetworkCommandQueue ncq;
+	ncq.Type = MessageLag;
+	ncq.Data.resize(nc.Size());
+	nc.Serialize(&ncq.Data[0]);
+	MsgCommandsIn.push_back(ncq);
+}
+
+/**
+**  Adapt the lag to the highest lag reported by the players.
+**
+**  All players execute the reports at the same game cycle, so they all
+**  switch to the same lag.
+*/
+static void NetworkAdaptLag()
+{
+	unsigned int &networkLag = CNetworkParameter::Instance.NetworkLag;
+	std::vector<unsigned int> reports;
+
+	reports.push_back(NetworkLagReports[ThisPlayer->Index]);
+	for (int i = 0; i < HostsCount; ++i) {
+		reports.push_back(NetworkLagReports[Hosts[i].PlyNr]);
+	}
+	const unsigned int lag = NetworkAdaptedLag(networkLag, reports, CNetworkParameter::Instance.gameCyclesPerUpdate);
+	if (lag != networkLag) {
+		DebugPrint("Network lag %d -> %d at cycle %lu\n" _C_ networkLag _C_ lag _C_ GameCycle);
+		networkLag = lag;
+	}
+}
+
 /**
 **  Network execute commands.
 */
@@ -1086,10 +1453,24 @@ void NetworkCommands()
 		return;
 	}
 	const unsigned long gameNetCycle = GameCycle;
+	const unsigned int gameCyclesPerUpdate = CNetworkParameter::Instance.gameCyclesPerUpdate;
+	const unsigned int update = gameNetCycle / gameCyclesPerUpdate;
+
+	if (update % NetworkLagUpdates == NetworkLagUpdates / 2) {
+		NetworkSendLag();
+	}
 	// Send messages to all clients (other players)
-	NetworkSendCommands(gameNetCycle + CNetworkParameter::Instance.NetworkLag);
+	// A grown lag skipped some gameNetCycles, a shrunk lag sends nothing.
+	const unsigned long lastCycle = gameNetCycle + CNetworkParameter::Instance.NetworkLag;
+	while (NetworkLastSentCycle + gameCyclesPerUpdate <= lastCycle) {
+		NetworkSendCommands(NetworkLastSentCycle + gameCyclesPerUpdate);
+	}
+	NetworkMeasureDelays(gameNetCycle);
 	NetworkExecCommands(gameNetCycle);
-	NetworkInSync = IsNetworkCommandReady(gameNetCycle + CNetworkParameter::Instance.gameCyclesPerUpdate);
+	if (update % NetworkLagUpdates == 0) {
+		NetworkAdaptLag();
+	}
+	NetworkInSync = IsNetworkCommandReady(gameNetCycle + gameCyclesPerUpdate);
 }
 
 static void CheckPlayerThatTimeOut(int hostIndex)
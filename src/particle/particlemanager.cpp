@@ -33,6 +33,7 @@
 #include "particle.h"
 #include "ui.h"
 #include "video.h"
+#include "viewport.h"
 
 #include <algorithm>
 
@@ -72,23 +73,33 @@ void CParticleManager::clear()
 	new_particles.clear();
 }
 
-static inline bool DrawLevelCompare(const CParticle *lhs, const CParticle *rhs)
-{
-	return lhs->getDrawLevel() < rhs->getDrawLevel();
-}
-
-void CParticleManager::prepareToDraw(const CViewport &vp, std::vector<CParticle *> &table)
+/**
+**  Append the particles visible in a viewport to a draw list.
+**
+**  @param vp     Viewport to be drawn.
+**  @param table  OUT: visible particles sorted by draw level are appended.
+*/
+void CParticleManager::prepareToDraw(const CViewport &vp, std::vector<CDrawItem> &table)
 {
 	this->vp = &vp;
+	const size_t n = table.size();
 
-	for (std::vector<CParticle *>::iterator it = particles.begin(); it != particles.end(); ++it) {
-		CParticle &particle = **it;
+	for (size_t i = 0; i != particles.size(); ++i) {
+		CParticle &particle = *particles[i];
 		if (particle.isVisible(vp)) {
-			table.push_back(&particle);
+			table.push_back(CDrawItem());
+			CDrawItem &item = table.back();
+
+			item.DrawLevel = particle.getDrawLevel();
+			item.Type = DrawItemParticle;
+			item.Y = 0;
+			item.X = 0;
+			item.Id = i;
+			item.Object.particle = &particle;
 		}
 	}
 
-	std::sort(table.begin(), table.end(), DrawLevelCompare);
+	std::sort(table.begin() + n, table.end());
 }
 
 void CParticleManager::endDraw()
@@ -218,6 +218,24 @@ static void CclSpellCondition(lua_State *l, ConditionInfo *condition)
 			LuaError(l, "Unsuported condition tag: %s" _C_ value);
 		}
 	}
+	// Keep the checks to do, so PassCondition doesn't test every variable and flag.
+	condition->CasterVariables.clear();
+	condition->TargetVariables.clear();
+	for (unsigned int i = 0; i < UnitTypeVar.GetNumberVariable(); i++) {
+		if (condition->Variable[i].Check) {
+			if (condition->Variable[i].ConditionApplyOnCaster) {
+				condition->CasterVariables.push_back(i);
+			} else {
+				condition->TargetVariables.push_back(i);
+			}
+		}
+	}
+	condition->CheckBoolFlags = false;
+	for (size_t i = 0; i != new_bool_size; ++i) {
+		if (condition->BoolFlag[i] != CONDITION_TRUE) {
+			condition->CheckBoolFlags = true;
+		}
+	}
 }
 
 /**
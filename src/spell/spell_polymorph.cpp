@@ -93,6 +93,7 @@
 		} else {
 			caster.Player->TotalKills++;
 		}
+		++PlayerUnitsChangeCount;
 		if (UseHPForXp) {
 			caster.Variable[XP_INDEX].Max += target->Variable[HP_INDEX].Value;
 		} else {
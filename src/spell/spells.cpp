@@ -89,18 +89,65 @@ static Target *NewTargetUnit(CUnit &unit)
 // ****************************************************************************
 
 /**
-**  Check the condition.
+**  Check the condition of a variable.
+**
+**  @param condition  Condition on the variable.
+**  @param unit       Unit to check.
+**  @param index      Index of the variable.
+**
+**  @return           true if passed, false otherwise.
+*/
+static bool PassVariableCondition(const ConditionInfoVariable &condition, const CUnit &unit, int index)
+{
+	const CVariable &variable = unit.Variable[index];
+
+	if (condition.Enable != CONDITION_TRUE) {
+		if ((condition.Enable == CONDITION_ONLY) ^ (variable.Enable)) {
+			return false;
+		}
+	}
+	// Value and Max
+	if (condition.ExactValue != -1 && condition.ExactValue != variable.Value) {
+		return false;
+	}
+	if (condition.ExceptValue != -1 && condition.ExceptValue == variable.Value) {
+		return false;
+	}
+	if (condition.MinValue >= variable.Value) {
+		return false;
+	}
+	if (condition.MaxValue != -1 && condition.MaxValue <= variable.Value) {
+		return false;
+	}
+	if (condition.MinMax >= variable.Max) {
+		return false;
+	}
+	if (!variable.Max) {
+		return true;
+	}
+	// Percent
+	if (condition.MinValuePercent * variable.Max >= 100 * variable.Value) {
+		return false;
+	}
+	if (condition.MaxValuePercent * variable.Max <= 100 * variable.Value) {
+		return false;
+	}
+	return true;
+}
+
+/**
+**  Check the part of the condition which only depends on the caster.
+**
+**  It is the same for every target, so it can be checked once before
+**  looking for targets.
 **
 **  @param caster      Pointer to caster unit.
 **  @param spell       Pointer to the spell to cast.
-**  @param target      Pointer to target unit, or 0 if it is a position spell.
-**  @param goalPos     position, or {-1, -1} if it is a unit spell.
 **  @param condition   Pointer to condition info.
 **
 **  @return            true if passed, false otherwise.
 */
-static bool PassCondition(const CUnit &caster, const SpellType &spell, const CUnit *target,
-						  const Vec2i &goalPos, const ConditionInfo *condition)
+static bool PassCasterCondition(const CUnit &caster, const SpellType &spell, const ConditionInfo *condition)
 {
 	if (caster.Variable[MANA_INDEX].Value < spell.ManaCost) { // Check caster mana.
 		return false;
@@ -113,6 +160,34 @@ static bool PassCondition(const CUnit &caster, const SpellType &spell, const CUn
 	if (caster.Player->CheckCosts(spell.Costs, false)) {
 		return false;
 	}
+	if (!condition) { // no condition, pass.
+		return true;
+	}
+	for (size_t i = 0; i != condition->CasterVariables.size(); ++i) {
+		const int index = condition->CasterVariables[i];
+
+		if (!PassVariableCondition(condition->Variable[index], caster, index)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+**  Check the part of the condition which depends on the target.
+**
+**  @param caster      Pointer to caster unit.
+**  @param spell       Pointer to the spell to cast.
+**  @param target      Pointer to target unit, or 0 if it is a position spell.
+**  @param goalPos     position, or {-1, -1} if it is a unit spell.
+**  @param condition   Pointer to condition info.
+**
+**  @return            true if passed, false otherwise.
+**  @note the caster condition must have been checked with PassCasterCondition.
+*/
+static bool PassTargetCondition(const CUnit &caster, const SpellType &spell, const CUnit *target,
+								const Vec2i &goalPos, const ConditionInfo *condition)
+{
 	if (spell.Target == TargetUnit) { // Casting a unit spell without a target.
 		if ((!target) || target->IsAlive() == false) {
 			return false;
@@ -121,60 +196,19 @@ static bool PassCondition(const CUnit &caster, const SpellType &spell, const CUn
 	if (!condition) { // no condition, pass.
 		return true;
 	}
-	for (unsigned int i = 0; i < UnitTypeVar.GetNumberVariable(); i++) { // for custom variables
-		const CUnit *unit;
-
-		if (!condition->Variable[i].Check) {
-			continue;
-		}
+	//  Spell should target location and have unit condition.
+	if (target) {
+		for (size_t i = 0; i != condition->TargetVariables.size(); ++i) {
+			const int index = condition->TargetVariables[i];
 
-		unit = (condition->Variable[i].ConditionApplyOnCaster) ? &caster : target;
-		//  Spell should target location and have unit condition.
-		if (unit == NULL) {
-			continue;
-		}
-		if (condition->Variable[i].Enable != CONDITION_TRUE) {
-			if ((condition->Variable[i].Enable == CONDITION_ONLY) ^ (unit->Variable[i].Enable)) {
+			if (!PassVariableCondition(condition->Variable[index], *target, index)) {
 				return false;
 			}
 		}
-		// Value and Max
-		if (condition->Variable[i].ExactValue != -1 &&
-			condition->Variable[i].ExactValue != unit->Variable[i].Value) {
-			return false;
-		}
-		if (condition->Variable[i].ExceptValue != -1 &&
-			condition->Variable[i].ExceptValue == unit->Variable[i].Value) {
-			return false;
-		}
-		if (condition->Variable[i].MinValue >= unit->Variable[i].Value) {
-			return false;
-		}
-		if (condition->Variable[i].MaxValue != -1 &&
-			condition->Variable[i].MaxValue <= unit->Variable[i].Value) {
-			return false;
-		}
-
-		if (condition->Variable[i].MinMax >= unit->Variable[i].Max) {
-			return false;
-		}
-
-		if (!unit->Variable[i].Max) {
-			continue;
-		}
-		// Percent
-		if (condition->Variable[i].MinValuePercent * unit->Variable[i].Max
-			>= 100 * unit->Variable[i].Value) {
-			return false;
-		}
-		if (condition->Variable[i].MaxValuePercent * unit->Variable[i].Max
-			<= 100 * unit->Variable[i].Value) {
+		if (condition->CheckBoolFlags && !target->Type->CheckUserBoolFlags(condition->BoolFlag)) {
 			return false;
 		}
 	}
-	if (target && !target->Type->CheckUserBoolFlags(condition->BoolFlag)) {
-		return false;
-	}
 
 	if (condition->CheckFunc) {
 		condition->CheckFunc->pushPreamble();
@@ -213,6 +247,24 @@ static bool PassCondition(const CUnit &caster, const SpellType &spell, const CUn
 	return true;
 }
 
+/**
+**  Check the condition.
+**
+**  @param caster      Pointer to caster unit.
+**  @param spell       Pointer to the spell to cast.
+**  @param target      Pointer to target unit, or 0 if it is a position spell.
+**  @param goalPos     position, or {-1, -1} if it is a unit spell.
+**  @param condition   Pointer to condition info.
+**
+**  @return            true if passed, false otherwise.
+*/
+static bool PassCondition(const CUnit &caster, const SpellType &spell, const CUnit *target,
+						  const Vec2i &goalPos, const ConditionInfo *condition)
+{
+	return PassCasterCondition(caster, spell, condition)
+		   && PassTargetCondition(caster, spell, target, goalPos, condition);
+}
+
 class AutoCastPrioritySort
 {
 public:
@@ -240,17 +292,39 @@ private:
 	const bool reverse;
 };
 
+/**
+**  Get the units around the caster.
+**
+**  The selection of each range is done once, later calls with the same
+**  range return the same units in the same order.
+**
+**  @param range  Range of the selection.
+**
+**  @return       Units around the caster.
+*/
+const std::vector<CUnit *> &AutoCastArea::Around(int range)
+{
+	std::map<int, std::vector<CUnit *> >::iterator it = Units.find(range);
+
+	if (it == Units.end()) {
+		it = Units.insert(std::make_pair(range, std::vector<CUnit *>())).first;
+		SelectAroundUnit(Caster, range, it->second);
+	}
+	return it->second;
+}
+
 /**
 **  Select the target for the autocast.
 **
 **  @param caster    Unit who would cast the spell.
 **  @param spell     Spell-type pointer.
+**  @param area      Units around the caster.
 **
 **  @return          Target* chosen target or Null if spell can't be cast.
 **  @todo FIXME: should be global (for AI) ???
 **  @todo FIXME: write for position target.
 */
-static Target *SelectTargetUnitsOfAutoCast(CUnit &caster, const SpellType &spell)
+static Target *SelectTargetUnitsOfAutoCast(CUnit &caster, const SpellType &spell, AutoCastArea &area)
 {
 	AutoCastInfo *autocast;
 
@@ -265,9 +339,22 @@ static Target *SelectTargetUnitsOfAutoCast(CUnit &caster, const SpellType &spell
 	int range = autocast->Range;
 	int minRange = autocast->MinRange;
 
+	// Nothing to look for if the caster itself doesn't pass.
+	if (!PassCasterCondition(caster, spell, spell.Condition)
+		|| !PassCasterCondition(caster, spell, autocast->Condition)) {
+		return NULL;
+	}
+
 	// Select all units aroung the caster
+	const std::vector<CUnit *> &around = area.Around(range);
 	std::vector<CUnit *> table;
-	SelectAroundUnit(caster, range, table, OutOfMinRange(minRange, caster.tilePos));
+	const OutOfMinRange outOfMinRange(minRange, caster.tilePos);
+	table.reserve(around.size());
+	for (size_t i = 0; i != around.size(); ++i) {
+		if (outOfMinRange(around[i])) {
+			table.push_back(around[i]);
+		}
+	}
 
 	// Check generic conditions. FIXME: a better way to do this?
 	if (autocast->Combat != CONDITION_TRUE) {
@@ -290,8 +377,8 @@ static Target *SelectTargetUnitsOfAutoCast(CUnit &caster, const SpellType &spell
 
 	switch (spell.Target) {
 		case TargetSelf :
-			if (PassCondition(caster, spell, &caster, pos, spell.Condition)
-				&& PassCondition(caster, spell, &caster, pos, autocast->Condition)) {
+			if (PassTargetCondition(caster, spell, &caster, pos, spell.Condition)
+				&& PassTargetCondition(caster, spell, &caster, pos, autocast->Condition)) {
 				return NewTargetUnit(caster);
 			}
 			return NULL;
@@ -309,8 +396,8 @@ static Target *SelectTargetUnitsOfAutoCast(CUnit &caster, const SpellType &spell
 							continue;
 						}
 					}
-					if (PassCondition(caster, spell, table[i], pos, spell.Condition)
-						&& PassCondition(caster, spell, table[i], pos, autocast->Condition)) {
+					if (PassTargetCondition(caster, spell, table[i], pos, spell.Condition)
+						&& PassTargetCondition(caster, spell, table[i], pos, autocast->Condition)) {
 							table[count++] = table[i];
 					}
 				}
@@ -363,8 +450,8 @@ static Target *SelectTargetUnitsOfAutoCast(CUnit &caster, const SpellType &spell
 						continue;
 					}
 				}
-				if (PassCondition(caster, spell, table[i], pos, spell.Condition)
-					&& PassCondition(caster, spell, table[i], pos, autocast->Condition)) {
+				if (PassTargetCondition(caster, spell, table[i], pos, spell.Condition)
+					&& PassTargetCondition(caster, spell, table[i], pos, autocast->Condition)) {
 					table[n++] = table[i];
 				}
 			}
@@ -466,10 +553,11 @@ bool CanCastSpell(const CUnit &caster, const SpellType &spell,
 **
 **  @param caster    Unit who can cast the spell.
 **  @param spell     Spell-type pointer.
+**  @param area      Units around the caster shared with its other spells, or NULL.
 **
 **  @return          1 if spell is casted, 0 if not.
 */
-int AutoCastSpell(CUnit &caster, const SpellType &spell)
+int AutoCastSpell(CUnit &caster, const SpellType &spell, AutoCastArea *area)
 {
 	//  Check for mana and cooldown time, trivial optimization.
 	if (!SpellIsAvailable(*caster.Player, spell.Slot)
@@ -477,7 +565,14 @@ int AutoCastSpell(CUnit &caster, const SpellType &spell)
 		|| caster.SpellCoolDownTimers[spell.Slot]) {
 		return 0;
 	}
-	Target *target = SelectTargetUnitsOfAutoCast(caster, spell);
+	Target *target;
+	if (area) {
+		Assert(&area->GetCaster() == &caster);
+		target = SelectTargetUnitsOfAutoCast(caster, spell, *area);
+	} else {
+		AutoCastArea ownArea(caster);
+		target = SelectTargetUnitsOfAutoCast(caster, spell, ownArea);
+	}
 	if (target == NULL) {
 		return 0;
 	} else {
@@ -62,12 +62,14 @@ public:
 	~PImpl();
 
 	int open(const char *name, long flags);
+	int openBuffer();
 	int close();
 	void flush();
 	int read(void *buf, size_t len);
 	int seek(long offset, int whence);
 	long tell();
 	int write(const void *buf, size_t len);
+	void takeBuffer(std::string &buffer);
 
 private:
 	PImpl(const PImpl &rhs); // No implementation
@@ -82,6 +84,7 @@ private:
 #ifdef USE_BZ2LIB
 	BZFILE *cl_bz;   /// bzip2 file pointer
 #endif // !USE_BZ2LIB
+	std::string cl_buffer; /// memory buffer
 };
 
 CFile::CFile() : pimpl(new CFile::PImpl)
@@ -107,6 +110,18 @@ int CFile::open(const char *name, long flags)
 	return pimpl->open(name, flags);
 }
 
+/**
+**  Open a memory buffer for writing.
+**
+**  Used to build a file in memory, which is written out later.
+**
+**  @return 0 for success
+*/
+int CFile::openBuffer()
+{
+	return pimpl->openBuffer();
+}
+
 /**
 **  CLclose Library file close
 */
@@ -150,6 +165,27 @@ long CFile::tell()
 	return pimpl->tell();
 }
 
+/**
+**  CLwrite Library file write
+**
+**  @param buf  Pointer to the data to write.
+**  @param len  number of bytes to write.
+*/
+int CFile::write(const void *buf, size_t len)
+{
+	return pimpl->write(buf, len);
+}
+
+/**
+**  Take the data written to a memory buffer.
+**
+**  @param buffer  Gets the data, the buffer is empty afterwards.
+*/
+void CFile::takeBuffer(std::string &buffer)
+{
+	pimpl->takeBuffer(buffer);
+}
+
 /**
 **  CLprintf Library file write
 **
@@ -347,6 +383,20 @@ int CFile::PImpl::open(const char *name, long openflags)
 	return 0;
 }
 
+int CFile::PImpl::openBuffer()
+{
+	cl_buffer.clear();
+	cl_type = CLF_TYPE_BUFFER;
+	return 0;
+}
+
+void CFile::PImpl::takeBuffer(std::string &buffer)
+{
+	Assert(cl_type == CLF_TYPE_BUFFER || cl_type == CLF_TYPE_INVALID);
+	buffer.clear();
+	buffer.swap(cl_buffer);
+}
+
 int CFile::PImpl::close()
 {
 	int ret = EOF;
@@ -367,6 +417,9 @@ int CFile::PImpl::close()
 			ret = 0;
 		}
 #endif // USE_BZ2LIB
+		if (tp == CLF_TYPE_BUFFER) {
+			ret = 0;
+		}
 	} else {
 		errno = EBADF;
 	}
@@ -438,6 +491,10 @@ int CFile::PImpl::write(const void *buf, size_t size)
 			ret = BZ2_bzwrite(cl_bz, const_cast<void *>(buf), size);
 		}
 #endif // USE_BZ2LIB
+		if (tp == CLF_TYPE_BUFFER) {
+			cl_buffer.append(static_cast<const char *>(buf), size);
+			ret = size;
+		}
 	} else {
 		errno = EBADF;
 	}
@@ -490,6 +547,9 @@ long CFile::PImpl::tell()
 			ret = -1;
 		}
 #endif // USE_BZ2LIB
+		if (tp == CLF_TYPE_BUFFER) {
+			ret = cl_buffer.size();
+		}
 	} else {
 		errno = EBADF;
 	}
@@ -35,6 +35,47 @@
 
 #include "script.h"
 
+/**
+**  Error handler of the callbacks, adds the traceback to the message.
+*/
+static int LuaCallbackTraceback(lua_State *l)
+{
+	lua_getglobal(l, "debug");
+	if (!lua_istable(l, -1)) {
+		lua_pop(l, 1);
+		return 1;
+	}
+	lua_getfield(l, -1, "traceback");
+	if (!lua_isfunction(l, -1)) {
+		lua_pop(l, 2);
+		return 1;
+	}
+	lua_pushvalue(l, 1);  // pass error message
+	lua_pushnumber(l, 2);  // skip this function and traceback
+	lua_call(l, 2, 1);  // call debug.traceback
+	return 1;
+}
+
+/// Registry reference to LuaCallbackTraceback, shared by all callbacks
+static int TracebackRef = LUA_NOREF;
+
+/**
+**  Make sure TracebackRef refers to the error handler in a Lua state.
+**
+**  @param l  Lua state
+*/
+static void InitTracebackRef(lua_State *l)
+{
+	lua_rawgeti(l, LUA_REGISTRYINDEX, TracebackRef);
+	const bool valid = lua_tocfunction(l, -1) == LuaCallbackTraceback;
+	lua_pop(l, 1);
+	if (!valid) {
+		// Creating a C function allocates, so it is done only once.
+		lua_pushcfunction(l, LuaCallbackTraceback);
+		TracebackRef = luaL_ref(l, LUA_REGISTRYINDEX);
+	}
+}
+
 /**
 **  LuaCallback constructor
 **
@@ -50,6 +91,7 @@ LuaCallback::LuaCallback(lua_State *l, lua_Object f) :
 	}
 	lua_pushvalue(l, f);
 	luaref = luaL_ref(l, LUA_REGISTRYINDEX);
+	InitTracebackRef(l);
 }
 
 /**
@@ -59,7 +101,7 @@ LuaCallback::LuaCallback(lua_State *l, lua_Object f) :
 void LuaCallback::pushPreamble()
 {
 	base = lua_gettop(luastate);
-	lua_getglobal(luastate, "_TRACEBACK");
+	lua_rawgeti(luastate, LUA_REGISTRYINDEX, TracebackRef);
 	lua_rawgeti(luastate, LUA_REGISTRYINDEX, luaref);
 	arguments = 0;
 }
@@ -82,11 +124,10 @@ void LuaCallback::pushInteger(int value)
 */
 void LuaCallback::pushIntegers(const std::vector<int> &values)
 {
-	lua_newtable(luastate);
+	lua_createtable(luastate, values.size(), 0);
 	for (size_t i = 0; i < values.size(); ++i) {
-		lua_pushnumber(luastate, i + 1);
 		lua_pushnumber(luastate, values[i]);
-		lua_settable(luastate, -3);
+		lua_rawseti(luastate, -2, i + 1);
 	}
 	arguments++;
 }
@@ -145,8 +186,7 @@ int LuaCallback::popInteger()
 */
 void LuaCallback::run(int results)
 {
-	//FIXME call error reporting function
-	int status = lua_pcall(luastate, arguments, results, base);
+	const int status = lua_pcall(luastate, arguments, results, base + 1);
 
 	if (status) {
 		const char *msg = lua_tostring(luastate, -1);
@@ -157,6 +197,7 @@ void LuaCallback::run(int results)
 		fprintf(stderr, "%s\n", msg);
 		lua_pop(luastate, 1);
 	}
+	lua_remove(luastate, base + 1);  // remove the error handler below the results
 	rescount = results;
 }
 
@@ -42,9 +42,11 @@
 #include "missile.h"
 #include "network.h"
 #include "particle.h"
+#include "profile.h"
 #include "replay.h"
 #include "results.h"
 #include "sound.h"
+#include "synchash.h"
 #include "translate.h"
 #include "trigger.h"
 #include "ui.h"
@@ -67,6 +69,10 @@ int MouseScrollState = ScrollNone;
 EventCallback GameCallbacks;   /// Game callbacks
 EventCallback EditorCallbacks; /// Editor callbacks
 
+static const int ProfileTriggers = ProfileSection("triggers");             /// Profiled triggers
+static const int ProfileUnitActions = ProfileSection("unit-actions");      /// Profiled unit actions
+static const int ProfileMissileActions = ProfileSection("missile-actions");/// Profiled missiles
+
 //----------------------------------------------------------------------------
 // Functions
 //----------------------------------------------------------------------------
@@ -168,13 +174,25 @@ void DrawMapArea()
 */
 void UpdateDisplay()
 {
+	if (GameRunning || Editor.Running == EditorEditing) {
+		if ((Preference.BigScreen && !BigMapMode) || (!Preference.BigScreen && BigMapMode)) {
+			UiToggleBigMap();
+		}
+	}
+	UI.PanelLayer.Update();
+
 	if (GameRunning || Editor.Running == EditorEditing) {
 		// to prevent empty spaces in the UI
+		if (UI.PanelLayer.MustDraw()) {
 #if defined(USE_OPENGL) || defined(USE_GLES)
-		Video.FillRectangleClip(ColorBlack, 0, 0, Video.ViewportWidth, Video.ViewportHeight);
+			Video.FillRectangleClip(ColorBlack, 0, 0, Video.ViewportWidth, Video.ViewportHeight);
 #else
-		Video.FillRectangleClip(ColorBlack, 0, 0, Video.Width, Video.Height);
+			Video.FillRectangleClip(ColorBlack, 0, 0, Video.Width, Video.Height);
 #endif
+		} else {
+			Video.FillRectangleClip(ColorBlack, UI.MapArea.X, UI.MapArea.Y,
+									UI.MapArea.EndX - UI.MapArea.X + 1, UI.MapArea.EndY - UI.MapArea.Y + 1);
+		}
 		DrawMapArea();
 		DrawMessages();
 
@@ -182,11 +200,7 @@ void UpdateDisplay()
 			DrawCursor();
 		}
 
-		if ((Preference.BigScreen && !BigMapMode) || (!Preference.BigScreen && BigMapMode)) {
-			UiToggleBigMap();
-		}
-
-		if (!BigMapMode) {
+		if (!BigMapMode && UI.PanelLayer.MustDraw()) {
 			for (size_t i = 0; i < UI.Fillers.size(); ++i) {
 				UI.Fillers[i].G->DrawSubClip(0, 0,
 											 UI.Fillers[i].G->Width,
@@ -206,7 +220,9 @@ void UpdateDisplay()
 			UI.ButtonPanel.Draw();
 		}
 
-		DrawTimer();
+		if (UI.PanelLayer.MustDraw() || UI.PanelLayer.IsTimerOnMap()) {
+			DrawTimer();
+		}
 	}
 
 	DrawPieMenu(); // draw pie menu only if needed
@@ -220,7 +236,7 @@ void UpdateDisplay()
 	//
 	// Update changes to display.
 	//
-	Invalidate();
+	UI.PanelLayer.Invalidate();
 }
 
 static void InitGameCallbacks()
@@ -249,9 +265,18 @@ static void GameLogicLoop()
 		++GameCycle;
 		MultiPlayerReplayEachCycle();
 		NetworkCommands(); // Get network commands
-		TriggersEachCycle();// handle triggers
-		UnitActions();      // handle units
-		MissileActions();   // handle missiles
+		{
+			CProfileScope scope(ProfileTriggers, -1);
+			TriggersEachCycle();// handle triggers
+		}
+		{
+			CProfileScope scope(ProfileUnitActions, -1);
+			UnitActions();      // handle units
+		}
+		{
+			CProfileScope scope(ProfileMissileActions, -1);
+			MissileActions();   // handle missiles
+		}
 		PlayersEachCycle(); // handle players
 		UpdateTimer();      // update game timer
 
@@ -298,11 +323,15 @@ static void GameLogicLoop()
 				}
 			}
 		}
+		if (IsNetworkGame()) {
+			SyncHashesEachCycle(); // hash state to find desyncs
+		}
+		ProfileEachCycle();
 		
 		if (Preference.AutosaveMinutes != 0 && !IsNetworkGame() && GameCycle > 0 && (GameCycle % (CYCLES_PER_SECOND * 60 * Preference.AutosaveMinutes)) == 0) { // autosave every X minutes (default is 5), if the option is enabled
 		//Wyrmgus end
 			UI.StatusLine.Set(_("Autosave"));
-			SaveGame("autosave.sav");
+			AutosaveGame("autosave.sav");
 		}
 	}
 
@@ -310,7 +339,9 @@ static void GameLogicLoop()
 	ParticleManager.update(); // handle particles
 	CheckMusicFinished(); // Check for next song
 
-	if (FastForwardCycle <= GameCycle || !(GameCycle & 0x3f)) {
+	if (ReplayTraceCycles) {
+		// Verifying a replay, run as fast as possible
+	} else if (FastForwardCycle <= GameCycle || !(GameCycle & 0x3f)) {
 		WaitEventsOneFrame();
 	}
 
@@ -344,6 +375,7 @@ static void DisplayLoop()
 	if (UI.Minimap.UpdateCache) {
 		UI.Minimap.Update();
 		UI.Minimap.UpdateCache = false;
+		UI.PanelLayer.SetDirty(PanelMinimap);
 	}
 
 	//
@@ -382,7 +414,9 @@ static void DisplayLoop()
 static void SingleGameLoop()
 {
 	while (GameRunning) {
-		DisplayLoop();
+		if (!ReplayTraceCycles) {
+			DisplayLoop();
+		}
 		GameLogicLoop();
 	}
 }
@@ -421,6 +455,8 @@ void GameMainLoop()
 	MultiPlayerReplayEachCycle();
 
 	SingleGameLoop();
+	WaitForAutosave();
+	EndVerifyReplay();
 
 	//
 	// Game over
@@ -314,6 +314,7 @@ CPlayer *ThisPlayer;              /// Player on this computer
 PlayerRace PlayerRaces;          /// Player races
 
 bool NoRescueCheck;               /// Disable rescue check
+unsigned long PlayerUnitsChangeCount; /// Incremented when the unit counts of a player change
 
 /**
 **  Colors used for minimap.
@@ -793,6 +794,7 @@ void CPlayer::AddUnit(CUnit &unit)
 	this->Units.push_back(&unit);
 	unit.Player = this;
 	Assert(this->Units[unit.PlayerSlot] == &unit);
+	++PlayerUnitsChangeCount;
 }
 
 void CPlayer::RemoveUnit(CUnit &unit)
@@ -808,6 +810,7 @@ void CPlayer::RemoveUnit(CUnit &unit)
 	this->Units.pop_back();
 	unit.PlayerSlot = static_cast<size_t>(-1);
 	Assert(last == &unit || this->Units[last->PlayerSlot] == last);
+	++PlayerUnitsChangeCount;
 }
 
 void CPlayer::UpdateFreeWorkers()
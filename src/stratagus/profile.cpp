@@ -0,0 +1,310 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name profile.cpp - The hot path profiler. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "profile.h"
+
+#include "script.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef USE_WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+/// Measured times of a section for a player
+struct ProfileData {
+	ProfileData() : Calls(0), Time(0), Max(0) {}
+
+	unsigned long Calls;      /// Number of measured scopes
+	unsigned long long Time;  /// Total time in microseconds
+	unsigned long long Max;   /// Longest scope in microseconds
+};
+
+/// Game cycle with its measured time
+struct ProfileCycle {
+	unsigned long Cycle;      /// Game cycle
+	unsigned long long Time;  /// Time of the outermost scopes in microseconds
+};
+
+/// Upper bounds of the cycle time histogram in microseconds
+static const unsigned long long ProfileHistogramBounds[] = {
+	100, 250, 500, 1000, 2000, 4000, 8000, 16000, 33000
+};
+static const int ProfileHistogramSize = sizeof(ProfileHistogramBounds) / sizeof(*ProfileHistogramBounds) + 1;
+static const size_t ProfileWorstCycles = 10;  /// Number of worst cycles kept
+
+bool CProfileScope::ProfileEnabled;
+
+static std::vector<ProfileData> Profiles;          /// By section, then by player + 1
+static int ProfileDepth;                            /// Number of open scopes
+static unsigned long long ProfileCycleTime;         /// Time of the current cycle
+static unsigned long ProfileCycles;                 /// Number of profiled cycles
+static unsigned long ProfileHistogram[ProfileHistogramSize]; /// Cycles by time
+static std::vector<ProfileCycle> ProfileWorst;      /// Worst cycles, longest first
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Names of the sections, by index.
+*/
+static std::vector<std::string> &ProfileSectionNames()
+{
+	static std::vector<std::string> names;
+	return names;
+}
+
+/**
+**  Get a monotonic time in microseconds.
+*/
+static unsigned long long ProfileTime()
+{
+#ifdef USE_WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (counter.QuadPart / frequency.QuadPart) * 1000000
+		   + (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/**
+**  Get the index of a profiled section.
+**
+**  @param name  Name of the section.
+**
+**  @return      Index of the section, created at the first call.
+*/
+int ProfileSection(const char *name)
+{
+	std::vector<std::string> &names = ProfileSectionNames();
+
+	for (size_t i = 0; i != names.size(); ++i) {
+		if (names[i] == name) {
+			return i;
+		}
+	}
+	names.push_back(name);
+	return names.size() - 1;
+}
+
+void CProfileScope::Begin()
+{
+	Start = std::max(ProfileTime(), 1ULL);
+	++ProfileDepth;
+}
+
+void CProfileScope::End()
+{
+	const unsigned long long time = ProfileTime() - Start;
+	const size_t index = Section * (PlayerMax + 1) + Player + 1;
+
+	if (index >= Profiles.size()) {
+		Profiles.resize(ProfileSectionNames().size() * (PlayerMax + 1));
+	}
+	ProfileData &data = Profiles[index];
+	++data.Calls;
+	data.Time += time;
+	data.Max = std::max(data.Max, time);
+	if (--ProfileDepth == 0) {
+		ProfileCycleTime += time;
+	}
+}
+
+/**
+**  Turn profiling on or off.
+*/
+void SetProfiling(bool enabled)
+{
+	CProfileScope::ProfileEnabled = enabled;
+}
+
+/**
+**  End a game cycle: add its time to the histogram and the worst cycles.
+*/
+void ProfileEachCycle()
+{
+	if (!CProfileScope::ProfileEnabled) {
+		return;
+	}
+	const unsigned long long time = ProfileCycleTime;
+	int bucket = 0;
+
+	ProfileCycleTime = 0;
+	++ProfileCycles;
+	while (bucket != ProfileHistogramSize - 1 && time >= ProfileHistogramBounds[bucket]) {
+		++bucket;
+	}
+	++ProfileHistogram[bucket];
+
+	if (ProfileWorst.size() == ProfileWorstCycles && time <= ProfileWorst.back().Time) {
+		return;
+	}
+	const ProfileCycle cycle = { GameCycle, time };
+	std::vector<ProfileCycle>::iterator it = ProfileWorst.begin();
+	while (it != ProfileWorst.end() && it->Time >= time) {
+		++it;
+	}
+	ProfileWorst.insert(it, cycle);
+	if (ProfileWorst.size() > ProfileWorstCycles) {
+		ProfileWorst.pop_back();
+	}
+}
+
+static bool CompareProfiles(const std::pair<const ProfileData *, size_t> &lhs, const std::pair<const ProfileData *, size_t> &rhs)
+{
+	return lhs.first->Time > rhs.first->Time;
+}
+
+/**
+**  Get the report of the measured times.
+**
+**  @return  The sections by total time, the histogram of the cycle times
+**           and the worst cycles.
+*/
+std::string ProfileReport()
+{
+	const std::vector<std::string> &names = ProfileSectionNames();
+	std::vector<std::pair<const ProfileData *, size_t> > profiles;
+	std::string report;
+	char buf[256];
+
+	for (size_t i = 0; i != Profiles.size(); ++i) {
+		if (Profiles[i].Calls) {
+			profiles.push_back(std::make_pair(&Profiles[i], i));
+		}
+	}
+	std::sort(profiles.begin(), profiles.end(), CompareProfiles);
+
+	snprintf(buf, sizeof(buf), "Profile of %lu cycles\n%-24s %6s %9s %11s %9s %9s\n", ProfileCycles,
+			 "section", "player", "calls", "total ms", "per ms", "max ms");
+	report += buf;
+	for (size_t i = 0; i != profiles.size(); ++i) {
+		const ProfileData &data = *profiles[i].first;
+		const int player = profiles[i].second % (PlayerMax + 1) - 1;
+		char playerName[8] = "-";
+
+		if (player != -1) {
+			snprintf(playerName, sizeof(playerName), "%d", player);
+		}
+		snprintf(buf, sizeof(buf), "%-24s %6s %9lu %11.3f %9.3f %9.3f\n",
+				 names[profiles[i].second / (PlayerMax + 1)].c_str(), playerName,
+				 data.Calls, data.Time / 1000.0, data.Time / 1000.0 / data.Calls, data.Max / 1000.0);
+		report += buf;
+	}
+
+	report += "Cycle times:";
+	for (int i = 0; i != ProfileHistogramSize; ++i) {
+		if (i != ProfileHistogramSize - 1) {
+			snprintf(buf, sizeof(buf), " <%gms %lu", ProfileHistogramBounds[i] / 1000.0, ProfileHistogram[i]);
+		} else {
+			snprintf(buf, sizeof(buf), " more %lu", ProfileHistogram[i]);
+		}
+		report += buf;
+	}
+	report += "\nWorst cycles:";
+	for (size_t i = 0; i != ProfileWorst.size(); ++i) {
+		snprintf(buf, sizeof(buf), " %lu %.3fms", ProfileWorst[i].Cycle, ProfileWorst[i].Time / 1000.0);
+		report += buf;
+	}
+	report += "\n";
+	return report;
+}
+
+/**
+**  Print the report at the end of a game and forget the measured times.
+*/
+void ProfileEndGame()
+{
+	if (ProfileCycles) {
+		fprintf(stdout, "%s", ProfileReport().c_str());
+		fflush(stdout);
+	}
+	Profiles.clear();
+	ProfileCycleTime = 0;
+	ProfileCycles = 0;
+	memset(ProfileHistogram, 0, sizeof(ProfileHistogram));
+	ProfileWorst.clear();
+}
+
+/**
+**  Turn profiling on or off.
+**
+**  @param l  Lua state.
+*/
+static int CclSetProfiling(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	SetProfiling(LuaToBoolean(l, 1));
+	return 0;
+}
+
+/**
+**  Get the report of the measured times.
+**
+**  @param l  Lua state.
+*/
+static int CclGetProfileReport(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+	lua_pushstring(l, ProfileReport().c_str());
+	return 1;
+}
+
+/**
+**  Register ccl functions for the profiler.
+*/
+void ProfileCclRegister()
+{
+	lua_register(Lua, "SetProfiling", CclSetProfiling);
+	lua_register(Lua, "GetProfileReport", CclGetProfileReport);
+}
+
+//@}
@@ -420,9 +420,9 @@ static void ParseBinOp(lua_State *l, BinOp *binop)
 	Assert(lua_rawlen(l, -1) == 2);
 
 	lua_rawgeti(l, -1, 1); // left
-	binop->Left = CclParseNumberDesc(l);
+	binop->Left = ParseNumberDesc(l);
 	lua_rawgeti(l, -1, 2); // right
-	binop->Right = CclParseNumberDesc(l);
+	binop->Right = ParseNumberDesc(l);
 	lua_pop(l, 1); // table.
 }
 
@@ -591,13 +591,13 @@ static std::string CallLuaStringFunction(unsigned int handler)
 }
 
 /**
-**  Return number.
+**  Return number, not compiled.
 **
 **  @param l  lua state.
 **
 **  @return   number.
 */
-NumberDesc *CclParseNumberDesc(lua_State *l)
+NumberDesc *ParseNumberDesc(lua_State *l)
 {
 	NumberDesc *res = new NumberDesc;
 
@@ -636,7 +636,7 @@ NumberDesc *CclParseNumberDesc(lua_State *l)
 			ParseBinOp(l, &res->D.binOp);
 		} else if (!strcmp(key, "Rand")) {
 			res->e = ENumber_Rand;
-			res->D.N = CclParseNumberDesc(l);
+			res->D.N = ParseNumberDesc(l);
 		} else if (!strcmp(key, "GreaterThan")) {
 			res->e = ENumber_Gt;
 			ParseBinOp(l, &res->D.binOp);
@@ -748,12 +748,13 @@ NumberDesc *CclParseNumberDesc(lua_State *l)
 				LuaError(l, "Bad number of args in NumIf\n");
 			}
 			lua_rawgeti(l, -1, 1); // Condition.
-			res->D.NumIf.Cond = CclParseNumberDesc(l);
+			res->D.NumIf.Cond = ParseNumberDesc(l);
 			lua_rawgeti(l, -1, 2); // Then.
-			res->D.NumIf.BTrue = CclParseNumberDesc(l);
+			res->D.NumIf.BTrue = ParseNumberDesc(l);
+			res->D.NumIf.BFalse = NULL;
 			if (lua_rawlen(l, -1) == 3) {
 				lua_rawgeti(l, -1, 3); // Else.
-				res->D.NumIf.BFalse = CclParseNumberDesc(l);
+				res->D.NumIf.BFalse = ParseNumberDesc(l);
 			}
 			lua_pop(l, 1); // table.
 		} else if (!strcmp(key, "PlayerData")) {
@@ -762,7 +763,7 @@ NumberDesc *CclParseNumberDesc(lua_State *l)
 				LuaError(l, "Bad number of args in PlayerData\n");
 			}
 			lua_rawgeti(l, -1, 1); // Player.
-			res->D.PlayerData.Player = CclParseNumberDesc(l);
+			res->D.PlayerData.Player = ParseNumberDesc(l);
 			lua_rawgeti(l, -1, 2); // DataType.
 			res->D.PlayerData.DataType = CclParseStringDesc(l);
 			if (lua_rawlen(l, -1) == 3) {
@@ -781,6 +782,335 @@ NumberDesc *CclParseNumberDesc(lua_State *l)
 	return res;
 }
 
+/**
+**  Compute a binary operation of a number description.
+**
+**  @param e  The operation.
+**  @param a  Left operand.
+**  @param b  Right operand.
+**
+**  @return   The result.
+*/
+static int EvalBinOp(ENumber e, int a, int b)
+{
+	switch (e) {
+		case ENumber_Add : return a + b;
+		case ENumber_Sub : return a - b;
+		case ENumber_Mul : return a * b;
+		case ENumber_Div : return b ? a / b : 0; // FIXME : manage better this.
+		case ENumber_Min : return std::min(a, b);
+		case ENumber_Max : return std::max(a, b);
+		case ENumber_Gt : return a > b ? 1 : 0;
+		case ENumber_GtEq : return a >= b ? 1 : 0;
+		case ENumber_Lt : return a < b ? 1 : 0;
+		case ENumber_LtEq : return a <= b ? 1 : 0;
+		case ENumber_Eq : return a == b ? 1 : 0;
+		case ENumber_NEq : return a != b ? 1 : 0;
+		default:
+			Assert(0);
+			return 0;
+	}
+}
+
+static bool IsBinOp(ENumber e)
+{
+	return (ENumber_Add <= e && e <= ENumber_Max) || (ENumber_Gt <= e && e <= ENumber_NEq);
+}
+
+/**
+**  Replace the operations on constants by their result.
+**
+**  @param number  Number description to simplify.
+*/
+static void FoldNumberDesc(NumberDesc *number)
+{
+	if (IsBinOp(number->e)) {
+		FoldNumberDesc(number->D.binOp.Left);
+		FoldNumberDesc(number->D.binOp.Right);
+		if (number->D.binOp.Left->e == ENumber_Dir && number->D.binOp.Right->e == ENumber_Dir) {
+			const int value = EvalBinOp(number->e, number->D.binOp.Left->D.Val, number->D.binOp.Right->D.Val);
+
+			FreeNumberDesc(number);
+			number->e = ENumber_Dir;
+			number->D.Val = value;
+		}
+	} else if (number->e == ENumber_Rand) {
+		FoldNumberDesc(number->D.N);
+	} else if (number->e == ENumber_NumIf) {
+		FoldNumberDesc(number->D.NumIf.Cond);
+		FoldNumberDesc(number->D.NumIf.BTrue);
+		if (number->D.NumIf.BFalse) {
+			FoldNumberDesc(number->D.NumIf.BFalse);
+		}
+		if (number->D.NumIf.Cond->e == ENumber_Dir) {
+			NumberDesc **branch = number->D.NumIf.Cond->D.Val ? &number->D.NumIf.BTrue : &number->D.NumIf.BFalse;
+			NumberDesc *taken = *branch;
+
+			*branch = NULL;
+			FreeNumberDesc(number);
+			if (taken) {
+				*number = *taken;
+				delete taken;
+			} else {
+				number->e = ENumber_Dir;
+				number->D.Val = 0;
+			}
+		}
+	}
+}
+
+/**
+**  Number description compiled into a flat program.
+**
+**  The operations are stored in evaluation order and take their operands
+**  from a small stack, so an evaluation neither recurses nor follows the
+**  pointers of the tree. Leaves which read the game state are evaluated
+**  by EvalNumber.
+*/
+class CNumberProgram
+{
+public:
+	explicit CNumberProgram(NumberDesc *number) : Number(number) {}
+	~CNumberProgram()
+	{
+		FreeNumberDesc(Number);
+		delete Number;
+	}
+
+	/// Compile the number description, false if it is too deep
+	bool Compile()
+	{
+		int depth = 0;
+		return Compile(*Number, depth);
+	}
+	/// Give back the number description without freeing it
+	NumberDesc *Release()
+	{
+		NumberDesc *number = Number;
+		Number = NULL;
+		return number;
+	}
+	int Eval() const;
+
+private:
+	enum EOperation {
+		OpPush,         /// Push Val
+		OpNode,         /// Push EvalNumber(Node)
+		OpBinary,       /// Replace the two top values by the result of Val (ENumber)
+		OpRand,         /// Replace the top value a by Rand(a)
+		OpJumpIfFalse,  /// Pop a value, go to Val if it is zero
+		OpJump          /// Go to Val
+	};
+
+	struct Instruction {
+		EOperation Op;
+		int Val;
+		const NumberDesc *Node;
+	};
+
+	static const int MaxStack = 32;  /// Max depth of the evaluation stack
+
+	bool Compile(const NumberDesc &number, int &depth);
+	void Emit(EOperation op, int val, const NumberDesc *node = NULL)
+	{
+		Instruction instruction = { op, val, node };
+		Code.push_back(instruction);
+	}
+
+	std::vector<Instruction> Code;  /// The program
+	NumberDesc *Number;             /// The compiled number description
+};
+
+/**
+**  Add the operations of a number description to the program.
+**
+**  @param number  Number description to compile.
+**  @param depth   Depth of the stack, increased by one by the operations.
+**
+**  @return        false if the stack of the program would be too deep.
+*/
+bool CNumberProgram::Compile(const NumberDesc &number, int &depth)
+{
+	if (IsBinOp(number.e)) {
+		if (!Compile(*number.D.binOp.Left, depth) || !Compile(*number.D.binOp.Right, depth)) {
+			return false;
+		}
+		Emit(OpBinary, number.e);
+		--depth;
+		return true;
+	}
+	switch (number.e) {
+		case ENumber_Dir :
+			Emit(OpPush, number.D.Val);
+			break;
+		case ENumber_Rand :
+			if (!Compile(*number.D.N, depth)) {
+				return false;
+			}
+			Emit(OpRand, 0);
+			return true;
+		case ENumber_NumIf : {
+			if (!Compile(*number.D.NumIf.Cond, depth)) {
+				return false;
+			}
+			const size_t jumpIfFalse = Code.size();
+			Emit(OpJumpIfFalse, 0);
+			--depth;
+			if (!Compile(*number.D.NumIf.BTrue, depth)) {
+				return false;
+			}
+			const size_t jump = Code.size();
+			Emit(OpJump, 0);
+			--depth;
+			Code[jumpIfFalse].Val = Code.size();
+			if (number.D.NumIf.BFalse) {
+				if (!Compile(*number.D.NumIf.BFalse, depth)) {
+					return false;
+				}
+			} else {
+				Emit(OpPush, 0);
+				++depth;
+			}
+			Code[jump].Val = Code.size();
+			return true;
+		}
+		default:
+			Emit(OpNode, 0, &number);
+			break;
+	}
+	++depth;
+	return depth <= MaxStack;
+}
+
+/**
+**  Evaluate the program.
+**
+**  @return  the result number.
+*/
+int CNumberProgram::Eval() const
+{
+	int stack[MaxStack];
+	int top = 0;
+	const size_t size = Code.size();
+
+	for (size_t pc = 0; pc != size; ++pc) {
+		const Instruction &instruction = Code[pc];
+
+		switch (instruction.Op) {
+			case OpPush :
+				stack[top++] = instruction.Val;
+				break;
+			case OpNode :
+				stack[top++] = EvalNumber(instruction.Node);
+				break;
+			case OpBinary :
+				--top;
+				stack[top - 1] = EvalBinOp(ENumber(instruction.Val), stack[top - 1], stack[top]);
+				break;
+			case OpRand :
+				stack[top - 1] = SyncRand() % stack[top - 1];
+				break;
+			case OpJumpIfFalse :
+				if (!stack[--top]) {
+					pc = instruction.Val - 1;
+				}
+				break;
+			case OpJump :
+				pc = instruction.Val - 1;
+				break;
+		}
+	}
+	Assert(top == 1);
+	return stack[0];
+}
+
+/**
+**  Simplify a number description and compile it, if it has operations.
+**
+**  @param number  Number description to compile.
+**
+**  @return        The number description to use instead.
+*/
+static NumberDesc *CompileNumberDesc(NumberDesc *number)
+{
+	FoldNumberDesc(number);
+	if (!IsBinOp(number->e) && number->e != ENumber_Rand && number->e != ENumber_NumIf) {
+		return number;
+	}
+	CNumberProgram *program = new CNumberProgram(number);
+	if (!program->Compile()) {
+		program->Release();
+		delete program;
+		return number;
+	}
+	NumberDesc *res = new NumberDesc;
+	res->e = ENumber_Program;
+	res->D.Program = program;
+	return res;
+}
+
+/**
+**  Return number.
+**
+**  @param l  lua state.
+**
+**  @return   number.
+*/
+NumberDesc *CclParseNumberDesc(lua_State *l)
+{
+	return CompileNumberDesc(ParseNumberDesc(l));
+}
+
+/**
+**  Replace the parts of a string description which are constant by their
+**  result. The operands must be already simplified.
+**
+**  @param s  String description to simplify.
+*/
+static void FoldStringDesc(StringDesc *s)
+{
+	if (s->e == EString_String && s->D.Number->e == ENumber_Dir) {
+		char buffer[16];
+
+		sprintf(buffer, "%d", s->D.Number->D.Val);
+		FreeStringDesc(s);
+		s->e = EString_Dir;
+		s->D.Val = new_strdup(buffer);
+	} else if (s->e == EString_InverseVideo && s->D.String->e == EString_Dir) {
+		const std::string res = std::string("~<") + s->D.String->D.Val + "~>";
+
+		FreeStringDesc(s);
+		s->e = EString_Dir;
+		s->D.Val = new_strdup(res.c_str());
+	} else if (s->e == EString_Concat) {
+		// Join the following constant strings.
+		int n = 0;
+		for (int i = 0; i < s->D.Concat.n; ++i) {
+			StringDesc *part = s->D.Concat.Strings[i];
+
+			if (n && part->e == EString_Dir && s->D.Concat.Strings[n - 1]->e == EString_Dir) {
+				StringDesc *previous = s->D.Concat.Strings[n - 1];
+				const std::string res = std::string(previous->D.Val) + part->D.Val;
+
+				delete[] previous->D.Val;
+				previous->D.Val = new_strdup(res.c_str());
+				FreeStringDesc(part);
+				delete part;
+			} else {
+				s->D.Concat.Strings[n++] = part;
+			}
+		}
+		s->D.Concat.n = n;
+		if (n == 1 && s->D.Concat.Strings[0]->e == EString_Dir) {
+			StringDesc *part = s->D.Concat.Strings[0];
+
+			delete[] s->D.Concat.Strings;
+			*s = *part;
+			delete part;
+		}
+	}
+}
+
 /**
 **  Return String description.
 **
@@ -892,6 +1222,7 @@ StringDesc *CclParseStringDesc(lua_State *l)
 		LuaError(l, "Parse Error in ParseString");
 	}
 	lua_pop(l, 1);
+	FoldStringDesc(res);
 	return res;
 }
 
@@ -1029,6 +1360,8 @@ int EvalNumber(const NumberDesc *number)
 			} else {
 				return 0;
 			}
+		case ENumber_Program : // compiled number.
+			return number->D.Program->Eval();
 		case ENumber_PlayerData : // getplayerdata(player, data, res);
 			int player = EvalNumber(number->D.PlayerData.Player);
 			std::string data = EvalString(number->D.PlayerData.DataType);
@@ -1215,6 +1548,9 @@ void FreeNumberDesc(NumberDesc *number)
 			FreeNumberDesc(number->D.NumIf.BFalse);
 			delete number->D.NumIf.BFalse;
 			break;
+		case ENumber_Program : // compiled number.
+			delete number->D.Program;
+			break;
 		case ENumber_PlayerData : // getplayerdata(player, data, res);
 			FreeNumberDesc(number->D.PlayerData.Player);
 			delete number->D.PlayerData.Player;
@@ -839,8 +839,10 @@ static int CclSetPlayerData(lua_State *l)
 		p->Score = LuaToNumber(l, 3);
 	} else if (!strcmp(data, "TotalUnits")) {
 		p->TotalUnits = LuaToNumber(l, 3);
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(data, "TotalBuildings")) {
 		p->TotalBuildings = LuaToNumber(l, 3);
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(data, "TotalResources")) {
 		LuaCheckArgs(l, 4);
 
@@ -849,8 +851,10 @@ static int CclSetPlayerData(lua_State *l)
 		p->TotalResources[resId] = LuaToNumber(l, 4);
 	} else if (!strcmp(data, "TotalRazings")) {
 		p->TotalRazings = LuaToNumber(l, 3);
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(data, "TotalKills")) {
 		p->TotalKills = LuaToNumber(l, 3);
+		++PlayerUnitsChangeCount;
 	} else if (!strcmp(data, "SpeedResourcesHarvest")) {
 		LuaCheckArgs(l, 4);
 
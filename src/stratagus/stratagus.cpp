@@ -239,6 +239,7 @@ std::string StratagusLibPath;        /// Path for data directory
 const char NameLine[] = NAME " v" VERSION ", " COPYRIGHT;
 
 std::string CliMapName;          /// Filename of the map given on the command line
+static std::string CliReplayName; /// Filename of the replay to verify
 std::string MenuRace;
 
 bool EnableDebugPrint;           /// if enabled, print the debug messages
@@ -465,8 +466,12 @@ static void Usage()
 #endif
 		"\t-p\t\tEnables debug messages printing in console\n"
 		"\t-P port\t\tNetwork port to use\n"
+		"\t-r host[:port]\tRelay the in-game packets of the games hosted by this player\n"
+		"\t-R replay\tVerify a replay: run it without video and sound, as fast as possible,\n"
+		"\t  \t\tand print its SyncHash trace\n"
 		"\t-s sleep\tNumber of frames for the AI to sleep before it starts\n"
 		"\t-S speed\tSync speed (100 = 30 frames/s)\n"
+		"\t-T cycles\tSyncHash trace interval for -R (default 100)\n"
 		"\t-u userpath\tPath where stratagus saves preferences, log and savegame\n"
 		"\t-v mode\t\tVideo mode resolution in format <xres>x<yres>\n"
 		"\t-W\t\tWindowed video mode\n"
@@ -523,7 +528,7 @@ void ParseCommandLine(int argc, char **argv, Parameters &parameters)
 {
 	char *sep;
 	for (;;) {
-		switch (getopt(argc, argv, "ac:d:D:eE:FG:hiI:lN:oOP:ps:S:u:v:Wx:Z:?-")) {
+		switch (getopt(argc, argv, "ac:d:D:eE:FG:hiI:lN:oOP:pr:R:s:S:T:u:v:Wx:Z:?-")) {
 			case 'a':
 				EnableAssert = true;
 				continue;
@@ -591,12 +596,34 @@ void ParseCommandLine(int argc, char **argv, Parameters &parameters)
 			case 'p':
 				EnableDebugPrint = true;
 				continue;
+			case 'r':
+				CNetworkParameter::Instance.relayHost = optarg;
+				sep = strchr(optarg, ':');
+				if (sep) {
+					CNetworkParameter::Instance.relayHost.resize(sep - optarg);
+					CNetworkParameter::Instance.relayPort = atoi(sep + 1);
+				}
+				continue;
+			case 'R':
+				CliReplayName = optarg;
+				if (!ReplayTraceCycles) {
+					ReplayTraceCycles = 100;
+				}
+				continue;
 			case 's':
 				AiSleepCycles = atoi(optarg);
 				continue;
 			case 'S':
 				VideoSyncSpeed = atoi(optarg);
 				continue;
+			case 'T':
+				ReplayTraceCycles = atoi(optarg);
+				if (ReplayTraceCycles <= 0) {
+					fprintf(stderr, "%s: incorrect SyncHash trace interval -- '%s'\n", argv[0], optarg);
+					Usage();
+					ExitFatal(-1);
+				}
+				continue;
 			case 'u':
 				Parameters::Instance.SetUserDirectory(optarg);
 				continue;
@@ -665,6 +692,10 @@ void ParseCommandLine(int argc, char **argv, Parameters &parameters)
 		break;
 	}
 
+	if (CliReplayName.empty()) {
+		ReplayTraceCycles = 0;
+	}
+
 	if (argc - optind > 1) {
 		fprintf(stderr, "too many map files. if you meant to pass game arguments, these go after '--'\n");
 		Usage();
@@ -765,11 +796,20 @@ int stratagusMain(int argc, char **argv)
 	PrintHeader();
 	PrintLicense();
 
+	if (!CliReplayName.empty()) {
+		// Verifying a replay, nothing is shown
+		SDL_putenv(const_cast<char *>("SDL_VIDEODRIVER=dummy"));
+#if defined(USE_OPENGL) || defined(USE_GLES)
+		ForceUseOpenGL = 1;
+		UseOpenGL = 0;
+#endif
+	}
+
 	// Setup video display
 	InitVideo();
 
 	// Setup sound card
-	if (!InitSound()) {
+	if (CliReplayName.empty() && !InitSound()) {
 		InitMusic();
 	}
 
@@ -782,7 +822,9 @@ int stratagusMain(int argc, char **argv)
 	LoadFonts();
 	SetClipping(0, 0, Video.Width - 1, Video.Height - 1);
 	Video.ClearScreen();
-	ShowTitleScreens();
+	if (CliReplayName.empty()) {
+		ShowTitleScreens();
+	}
 
 	// Init player data
 	ThisPlayer = NULL;
@@ -793,6 +835,12 @@ int stratagusMain(int argc, char **argv)
 	UnitManager.Init(); // Units memory management
 	PreMenuSetup();     // Load everything needed for menus
 
+	if (!CliReplayName.empty()) {
+		initGuichan();
+		VerifyReplay(CliReplayName);
+		Exit(0);
+	}
+
 	MenuLoop();
 
 	Exit(0);
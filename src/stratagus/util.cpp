@@ -295,6 +295,83 @@ char *strcasestr(const char *a, const char *b)
 }
 #endif // !HAVE_STRCASESTR
 
+static const char Base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+**  Encode binary data as base64 text.
+**
+**  @param data  Data to encode.
+**
+**  @return      The base64 text, padded with '='.
+*/
+std::string EncodeBase64(const std::string &data)
+{
+	std::string text;
+	text.reserve((data.size() + 2) / 3 * 4);
+
+	for (size_t i = 0; i < data.size(); i += 3) {
+		const size_t left = data.size() - i;
+		unsigned int bits = (unsigned char)data[i] << 16;
+		if (left > 1) {
+			bits |= (unsigned char)data[i + 1] << 8;
+		}
+		if (left > 2) {
+			bits |= (unsigned char)data[i + 2];
+		}
+		text += Base64Chars[(bits >> 18) & 0x3F];
+		text += Base64Chars[(bits >> 12) & 0x3F];
+		text += left > 1 ? Base64Chars[(bits >> 6) & 0x3F] : '=';
+		text += left > 2 ? Base64Chars[bits & 0x3F] : '=';
+	}
+	return text;
+}
+
+/**
+**  Decode base64 text. White space is ignored.
+**
+**  @param text  Base64 text.
+**  @param data  The decoded data.
+**
+**  @return      true if the text was valid base64.
+*/
+bool DecodeBase64(const std::string &text, std::string &data)
+{
+	static signed char values[256];
+	if (!values[0]) {
+		memset(values, -1, sizeof(values));
+		for (int i = 0; i != 64; ++i) {
+			values[(unsigned char)Base64Chars[i]] = i;
+		}
+	}
+	unsigned int bits = 0;
+	int numBits = 0;
+	bool padding = false;
+
+	data.clear();
+	data.reserve(text.size() / 4 * 3);
+	for (size_t i = 0; i < text.size(); ++i) {
+		const char c = text[i];
+		if (isspace((unsigned char)c)) {
+			continue;
+		}
+		if (c == '=') {
+			padding = true;
+			continue;
+		}
+		const int value = values[(unsigned char)c];
+		if (value < 0 || padding) {
+			return false;
+		}
+		bits = (bits << 6) | value;
+		numBits += 6;
+		if (numBits >= 8) {
+			numBits -= 8;
+			data += (char)((bits >> numBits) & 0xFF);
+		}
+	}
+	return true;
+}
+
 
 /*----------------------------------------------------------------------------
 --  Getopt
@@ -724,6 +724,42 @@ void DrawPopup(const ButtonAction &button, const CUIButton &uibutton, int x, int
 #endif
 }
 
+/**
+**  Get the content key of the button panel, see CPanelLayer.
+**
+**  @param key  Gets the values shown by the button panel.
+*/
+void CButtonPanel::GetContentKey(std::vector<size_t> &key) const
+{
+	key.push_back(CurrentButtons.size());
+	key.push_back(ShowCommandKey);
+	if (CurrentButtons.empty() || Selected.empty()) {
+		return;
+	}
+	key.push_back(Selected[0]->RescuedFrom ? Selected[0]->RescuedFrom->Index : Selected[0]->Player->Index);
+	for (int i = 0; i < (int) UI.ButtonPanel.Buttons.size(); ++i) {
+		const ButtonAction &button = CurrentButtons[i];
+
+		key.push_back(button.Pos);
+		if (button.Pos == -1) {
+			continue;
+		}
+		key.push_back(button.Action);
+		key.push_back(button.Value);
+		key.push_back(button.Key);
+		key.push_back(reinterpret_cast<size_t>(button.Icon.Icon));
+		key.push_back(GetButtonStatus(button, ButtonUnderCursor));
+		for (size_t j = 0; j != Selected.size(); ++j) {
+			if (!IsButtonAllowed(*Selected[j], button)) {
+				key.push_back(0);
+				break;
+			} else if (button.Action == ButtonSpellCast) {
+				key.push_back((*Selected[j]).SpellCoolDownTimers[SpellTypeTable[button.Value]->Slot]);
+			}
+		}
+	}
+}
+
 /**
 **  Draw button panel.
 **
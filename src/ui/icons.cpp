@@ -280,12 +280,20 @@ bool IconConfig::Load()
 */
 void LoadIcons()
 {
+	for (IconMap::iterator it = Icons.begin(); it != Icons.end(); ++it) {
+		const CIcon &icon = *(*it).second;
+
+		if (!icon.G->IsLoaded()) {
+			PrefetchGraphicPNG(icon.G->File);
+		}
+	}
 	for (IconMap::iterator it = Icons.begin(); it != Icons.end(); ++it) {
 		CIcon &icon = *(*it).second;
 
 		ShowLoadProgress(_("Icons %s"), icon.G->File.c_str());
 		icon.Load();
 	}
+	CleanPrefetchedGraphics();
 }
 
 /**
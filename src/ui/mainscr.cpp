@@ -59,13 +59,17 @@
 #include "unittype.h"
 #include "upgrade.h"
 #include "video.h"
+#include "widgets.h"
 
 #ifdef DEBUG
 #include "../ai/ai_local.h"
 #endif
 
+#include <limits.h>
 #include <sstream>
 
+extern gcn::Gui *Gui;
+
 /*----------------------------------------------------------------------------
 --  UI BUTTONS
 ----------------------------------------------------------------------------*/
@@ -651,6 +655,7 @@ public:
 	void UpdateMessages();
 	void AddUniqueMessage(const char *s);
 	void DrawMessages();
+	int GetShownLines() const;
 	void CleanMessages();
 	void ToggleShowMessages() { show = !show; }
 #ifdef DEBUG
@@ -932,6 +937,22 @@ void UpdateMessages()
 /**
 **  Clean messages
 */
+/**
+**  Get the number of message lines drawn over the map.
+*/
+int MessagesDisplay::GetShownLines() const
+{
+	if (!show || !Preference.ShowMessages) {
+		return 0;
+	}
+#ifdef DEBUG
+	if (showBuilList && ThisPlayer->Ai) {
+		return ThisPlayer->Ai->UnitTypeBuilt.size();
+	}
+#endif
+	return MessagesCount;
+}
+
 void CleanMessages()
 {
 	allmessages.CleanMessages();
@@ -1214,4 +1235,378 @@ void UpdateTimer()
 	}
 }
 
+/*----------------------------------------------------------------------------
+--  PANEL LAYER
+----------------------------------------------------------------------------*/
+
+/**
+**  Bounding box of the screen areas drawn by a panel.
+*/
+class CPanelArea
+{
+public:
+	CPanelArea() : X0(INT_MAX), Y0(INT_MAX), X1(INT_MIN), Y1(INT_MIN) {}
+
+	void Add(int x, int y, int w, int h)
+	{
+		X0 = std::min(X0, x);
+		Y0 = std::min(Y0, y);
+		X1 = std::max(X1, x + w);
+		Y1 = std::max(Y1, y + h);
+	}
+	void Add(const CUIButton *button)
+	{
+		if (button && button->X != -1 && button->Style) {
+			Add(button->X, button->Y, button->Style->Width, button->Style->Height);
+		}
+	}
+	void Add(const std::vector<CUIButton> &buttons)
+	{
+		for (size_t i = 0; i != buttons.size(); ++i) {
+			Add(&buttons[i]);
+		}
+	}
+	/// Add a row of the screen, for texts of unknown width
+	void AddRow(int y, int h) { Add(0, y, Video.Width, h); }
+
+	void Invalidate(int margin = 0) const
+	{
+		const int x0 = std::max(X0 - margin, 0);
+		const int y0 = std::max(Y0 - margin, 0);
+		const int x1 = std::min(X1 + margin, Video.Width);
+		const int y1 = std::min(Y1 + margin, Video.Height);
+
+		if (x0 < x1 && y0 < y1) {
+			InvalidateArea(x0, y0, x1 - x0, y1 - y0);
+		}
+	}
+
+private:
+	int X0;
+	int Y0;
+	int X1;
+	int Y1;
+};
+
+/**
+**  Add the values shown for a unit in the info panel to a content key.
+*/
+static void AddUnitKey(std::vector<size_t> &key, CUnit &unit)
+{
+	UpdateUnitVariables(unit);
+	key.push_back(UnitNumber(unit));
+	key.push_back(reinterpret_cast<size_t>(unit.Type));
+	key.push_back(unit.Player->Index);
+	key.push_back(unit.RescuedFrom ? unit.RescuedFrom->Index : -1);
+	for (unsigned int i = 0; i != UnitTypeVar.GetNumberVariable(); ++i) {
+		key.push_back(unit.Variable[i].Value);
+		key.push_back(unit.Variable[i].Max);
+		key.push_back(unit.Variable[i].Enable);
+	}
+	key.push_back(unit.Orders.size());
+	for (size_t i = 0; i != unit.Orders.size(); ++i) {
+		const COrder &order = *unit.Orders[i];
+
+		key.push_back(order.Action);
+		if (order.Action == UnitActionTrain) {
+			key.push_back(reinterpret_cast<size_t>(&static_cast<const COrder_Train &>(order).GetUnitType()));
+		} else if (order.Action == UnitActionUpgradeTo) {
+			key.push_back(reinterpret_cast<size_t>(&static_cast<const COrder_UpgradeTo &>(order).GetUnitType()));
+		} else if (order.Action == UnitActionResearch) {
+			key.push_back(reinterpret_cast<size_t>(&static_cast<const COrder_Research &>(order).GetUpgrade()));
+		}
+	}
+	CUnit *uins = unit.UnitInside;
+	for (int i = 0; i < unit.InsideCount; ++i, uins = uins->NextContained) {
+		key.push_back(uins->Boarded);
+		key.push_back(reinterpret_cast<size_t>(uins->Type));
+		key.push_back(uins->Variable[HP_INDEX].Value);
+		key.push_back(uins->Variable[MANA_INDEX].Value);
+	}
+#ifdef USE_MNG
+	if (unit.Type->Portrait.Num) {
+		// Animated portrait
+		key.push_back(FrameCounter);
+	}
+#endif
+}
+
+/**
+**  Check if the panels can be kept on the screen this frame.
+**
+**  Only the software renderer keeps them, and only if nothing but the map
+**  and the cursor is drawn over them.
+*/
+bool CPanelLayer::CanKeepPanels() const
+{
+#if defined(USE_OPENGL) || defined(USE_GLES)
+	if (UseOpenGL) {
+		return false;
+	}
+#endif
+	if (!GameRunning || BigMapMode) {
+		return false;
+	}
+	if (CursorState == CursorStateRectangle || CursorState == CursorStatePieMenu) {
+		return false;
+	}
+	// Popup of the button under the cursor
+	if (ButtonAreaUnderCursor == ButtonAreaButton && KeyState != KeyStateInput) {
+		return false;
+	}
+	// Game menus
+	if (Gui && dynamic_cast<MenuScreen *>(Gui->getTop())) {
+		return false;
+	}
+	// Messages which don't fit on the map
+	const int lines = allmessages.GetShownLines();
+	if (lines && (UI.MapArea.EndX + 1 < Video.Width
+				  || UI.MapArea.Y + 8 + lines * (UI.MessageFont->Height() + 1) > UI.MapArea.EndY)) {
+		return false;
+	}
+	return true;
+}
+
+/**
+**  Check if the game timer is drawn on the map, where it is drawn each
+**  frame.
+*/
+bool CPanelLayer::IsTimerOnMap() const
+{
+	return UI.MapArea.X <= UI.Timer.X && UI.Timer.X <= UI.MapArea.EndX
+		   && UI.MapArea.Y <= UI.Timer.Y && UI.Timer.Y <= UI.MapArea.EndY;
+}
+
+/**
+**  Get the content key of a panel, built from the values it shows.
+**
+**  @param panel  The panel.
+**  @param key    Gets the values shown by the panel.
+*/
+void CPanelLayer::GetKey(PanelType panel, std::vector<size_t> &key) const
+{
+	switch (panel) {
+		case PanelMenuButtons:
+			key.push_back(IsNetworkGame());
+			key.push_back(ButtonAreaUnderCursor == ButtonAreaMenu ? ButtonUnderCursor : -1);
+			key.push_back(GameMenuButtonClicked);
+			key.push_back(GameDiplomacyButtonClicked);
+			for (size_t i = 0; i != UI.UserButtons.size(); ++i) {
+				key.push_back(UI.UserButtons[i].Clicked);
+				key.push_back(ButtonAreaUnderCursor == ButtonAreaUser && size_t(ButtonUnderCursor) == i);
+			}
+			break;
+		case PanelMinimap: {
+			const CViewport &vp = *UI.SelectedViewport;
+
+			// Changed by the minimap events, else by CMinimap::Update
+			key.push_back(UI.Minimap.HasEvents() ? FrameCounter : 0);
+			key.push_back(vp.MapPos.x);
+			key.push_back(vp.MapPos.y);
+			key.push_back(vp.MapWidth);
+			key.push_back(vp.MapHeight);
+			break;
+		}
+		case PanelInfo:
+			key.push_back(ButtonAreaUnderCursor);
+			key.push_back(ButtonUnderCursor);
+			key.push_back(MouseButtons);
+			key.push_back(ReplayRevealMap);
+			// Texts of the info panel can be lua expressions, draw them
+			// each second.
+			key.push_back(GameCycle / CYCLES_PER_SECOND);
+			key.push_back(Selected.size());
+			for (size_t i = 0; i != Selected.size(); ++i) {
+				AddUnitKey(key, *Selected[i]);
+			}
+			if (!Selected.empty()) {
+				break;
+			}
+			if (UnitUnderCursor && !UnitUnderCursor->Type->BoolFlag[ISNOTSELECTABLE_INDEX].value
+				&& (ReplayRevealMap || UnitUnderCursor->IsVisible(*ThisPlayer))) {
+				AddUnitKey(key, *UnitUnderCursor);
+			} else {
+				key.push_back(GameCycle);
+				key.push_back(VideoSyncSpeed);
+				for (int i = 0; i < PlayerMax - 1; ++i) {
+					key.push_back(Players[i].Type);
+					key.push_back(Players[i].Score);
+					key.push_back(ThisPlayer->IsAllied(Players[i]) * 2 + ThisPlayer->IsEnemy(Players[i]));
+				}
+			}
+			break;
+		case PanelResources:
+			for (int i = 0; i < MaxCosts; ++i) {
+				key.push_back(ThisPlayer->Resources[i]);
+				key.push_back(ThisPlayer->StoredResources[i]);
+				key.push_back(ThisPlayer->MaxResources[i]);
+			}
+			key.push_back(ThisPlayer->Demand);
+			key.push_back(ThisPlayer->Supply);
+			key.push_back(ThisPlayer->Score);
+			key.push_back(ThisPlayer->FreeWorkers.size());
+			break;
+		case PanelStatusLine: {
+			const std::string &text = UI.StatusLine.Get();
+
+			key.assign(text.begin(), text.end());
+			key.insert(key.end(), UI.StatusLine.Costs, UI.StatusLine.Costs + ManaResCost + 1);
+			key.push_back(text.size());
+			break;
+		}
+		case PanelButtons:
+			UI.ButtonPanel.GetContentKey(key);
+			break;
+		case PanelTimer:
+			key.push_back(GameTimer.Init);
+			key.push_back(GameTimer.Cycles / CYCLES_PER_SECOND);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+**  Find the panels whose content changed since they were drawn.
+**
+**  Called each frame before the game screen is drawn.
+*/
+void CPanelLayer::Update()
+{
+	const bool keep = CanKeepPanels();
+	std::vector<size_t> key;
+
+	AnyChanged = false;
+	for (int i = 0; i != NumPanels; ++i) {
+		key.clear();
+		if (GameRunning) {
+			GetKey(PanelType(i), key);
+		}
+		Changed[i] = key != Keys[i];
+		AnyChanged |= Changed[i];
+		if (Changed[i]) {
+			Keys[i].swap(key);
+		}
+	}
+	// The screen keeps the panels only if the last frame drew them and
+	// nothing else over them.
+	KeepPanels = keep && Valid && ScreenWidth == Video.Width && ScreenHeight == Video.Height;
+	Valid = keep;
+	ScreenWidth = Video.Width;
+	ScreenHeight = Video.Height;
+}
+
+/**
+**  Invalidate the area of a changed panel.
+*/
+void CPanelLayer::InvalidatePanel(PanelType panel) const
+{
+	CPanelArea area;
+
+	switch (panel) {
+		case PanelMenuButtons:
+			area.Add(&UI.MenuButton);
+			area.Add(&UI.NetworkMenuButton);
+			area.Add(&UI.NetworkDiplomacyButton);
+			for (size_t i = 0; i != UI.UserButtons.size(); ++i) {
+				area.Add(&UI.UserButtons[i].Button);
+			}
+			break;
+		case PanelMinimap:
+			area.Add(UI.Minimap.X, UI.Minimap.Y, UI.Minimap.W, UI.Minimap.H);
+			break;
+		case PanelInfo:
+			if (UI.InfoPanel.G) {
+				area.Add(UI.InfoPanel.X, UI.InfoPanel.Y, UI.InfoPanel.G->Width, UI.InfoPanel.G->Height);
+			}
+			for (size_t i = 0; i != UI.InfoPanelContents.size(); ++i) {
+				area.Add(UI.InfoPanelContents[i]->PosX, UI.InfoPanelContents[i]->PosY, 1, 1);
+			}
+			area.Add(UI.SingleSelectedButton);
+			area.Add(UI.SelectedButtons);
+			area.Add(UI.SingleTrainingButton);
+			area.Add(UI.TrainingButtons);
+			area.Add(UI.UpgradingButton);
+			area.Add(UI.ResearchingButton);
+			area.Add(UI.TransportingButtons);
+			area.Add(UI.MaxSelectedTextX, UI.MaxSelectedTextY, 1, 1);
+			// Room for the life bars under the unit icons
+			area.Invalidate(12);
+			return;
+		case PanelResources:
+			for (int i = 0; i < MaxResourceInfo; ++i) {
+				const CResourceInfo &info = UI.Resources[i];
+
+				if (info.G && i <= FreeWorkersCount) {
+					area.AddRow(info.IconY, info.G->Height);
+				}
+				if (info.TextX != -1) {
+					area.AddRow(info.TextY, GetGameFont().Height() + 3);
+				}
+			}
+			break;
+		case PanelStatusLine:
+			area.AddRow(UI.StatusLine.TextY, UI.StatusLine.Font->Height());
+			for (int i = 0; i <= ManaResCost; ++i) {
+				if (UI.Resources[i].G) {
+					area.AddRow(UI.StatusLine.TextY, UI.Resources[i].G->Height);
+				}
+			}
+			break;
+		case PanelButtons:
+			if (UI.ButtonPanel.G) {
+				area.Add(UI.ButtonPanel.X, UI.ButtonPanel.Y, UI.ButtonPanel.G->Width, UI.ButtonPanel.G->Height);
+			}
+			area.Add(UI.ButtonPanel.Buttons);
+			break;
+		case PanelTimer:
+			if (!IsTimerOnMap() && UI.Timer.Font) {
+				area.AddRow(UI.Timer.Y, UI.Timer.Font->Height());
+			}
+			break;
+		default:
+			break;
+	}
+	area.Invalidate();
+}
+
+/**
+**  Invalidate the changed areas of the game screen.
+**
+**  Called each frame after the game screen is drawn. If the panels were
+**  not kept, the whole screen is invalidated.
+*/
+void CPanelLayer::Invalidate()
+{
+	int cursorArea[4] = {0, 0, 0, 0};
+
+	if (GameCursor && GameCursor->G) {
+		cursorArea[0] = CursorScreenPos.x - GameCursor->HotPos.x;
+		cursorArea[1] = CursorScreenPos.y - GameCursor->HotPos.y;
+		cursorArea[2] = GameCursor->G->getWidth();
+		cursorArea[3] = GameCursor->G->getHeight();
+	}
+	if (!KeepPanels) {
+		::Invalidate();
+	} else {
+		CPanelArea map;
+
+		map.Add(UI.MapArea.X, UI.MapArea.Y, UI.MapArea.EndX - UI.MapArea.X + 1, UI.MapArea.EndY - UI.MapArea.Y + 1);
+		map.Invalidate();
+		for (int i = 0; i != NumPanels; ++i) {
+			if (Changed[i]) {
+				InvalidatePanel(PanelType(i));
+			}
+		}
+		// The cursor of the last frame was removed, see HideCursor
+		CPanelArea cursor;
+		cursor.Add(CursorArea[0], CursorArea[1], CursorArea[2], CursorArea[3]);
+		cursor.Invalidate();
+		cursor = CPanelArea();
+		cursor.Add(cursorArea[0], cursorArea[1], cursorArea[2], cursorArea[3]);
+		cursor.Invalidate();
+	}
+	memcpy(CursorArea, cursorArea, sizeof(CursorArea));
+}
+
 //@}
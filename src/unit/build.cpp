@@ -376,6 +376,13 @@ bool CBuildRestrictionOnTop::Check(const CUnit *builder, const CUnitType &, cons
 	return false;
 }
 
+/**
+**  Range of the OnTop Restriction, the units on the parent are checked.
+*/
+int CBuildRestrictionOnTop::Range() const
+{
+	return this->Parent ? std::max(this->Parent->TileWidth, this->Parent->TileHeight) : 0;
+}
 
 /**
 **  Can build unit here.
@@ -660,6 +660,8 @@ static int CclDefineUnitType(lua_State *l)
 			type->OnHit = new LuaCallback(l, -1);
 		} else if (!strcmp(value, "OnEachCycle")) {
 			type->OnEachCycle = new LuaCallback(l, -1);
+		} else if (!strcmp(value, "OnEachCycleBatch")) {
+			type->OnEachCycleBatch = new LuaCallback(l, -1);
 		} else if (!strcmp(value, "OnEachSecond")) {
 			type->OnEachSecond = new LuaCallback(l, -1);
 		} else if (!strcmp(value, "OnInit")) {
@@ -1764,8 +1764,14 @@ void CUnit::ChangeOwner(CPlayer &newplayer)
 	}
 
 	MapUnmarkUnitSight(*this);
+	if (!Removed) {
+		Map.Influence.Remove(*this);
+	}
 	newplayer.AddUnit(*this);
 	Stats = &Type->Stats[newplayer.Index];
+	if (!Removed) {
+		Map.Influence.Insert(*this);
+	}
 	UpdateUnitSightRange(*this);
 	MapMarkUnitSight(*this);
 
@@ -2546,6 +2552,7 @@ static void HitUnit_IncreaseScoreForKill(CUnit &attacker, CUnit &target)
 	} else {
 		attacker.Player->TotalKills++;
 	}
+	++PlayerUnitsChangeCount;
 	if (UseHPForXp) {
 		attacker.Variable[XP_INDEX].Max += target.Variable[HP_INDEX].Value;
 	} else {
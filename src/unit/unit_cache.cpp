@@ -43,6 +43,7 @@
 #include "unit.h"
 #include "unittype.h"
 #include "map.h"
+#include "trigger.h"
 
 /**
 **  Insert new unit into cache.
@@ -66,6 +67,9 @@ void CMap::Insert(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < Info.MapWidth);
 		index += Info.MapWidth;
 	} while (--i && unit.tilePos.y + (i - h) < Info.MapHeight);
+	Influence.Insert(unit);
+	TriggerAreasUnitChanged(unit);
+	++ChangeCount;
 }
 
 /**
@@ -76,6 +80,9 @@ void CMap::Insert(CUnit &unit)
 void CMap::Remove(CUnit &unit)
 {
 	Assert(!unit.Removed);
+	Influence.Remove(unit);
+	TriggerAreasUnitChanged(unit);
+	++ChangeCount;
 	unsigned int index = unit.Offset;
 	const int w = unit.Type->TileWidth;
 	const int h = unit.Type->TileHeight;
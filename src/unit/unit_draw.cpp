@@ -55,10 +55,12 @@
 #include "translate.h"
 #include "unit.h"
 #include "unit_find.h"
+#include "unit_manager.h"
 #include "unitsound.h"
 #include "unittype.h"
 #include "ui.h"
 #include "video.h"
+#include "viewport.h"
 
 /*----------------------------------------------------------------------------
 -- Variables
@@ -344,11 +346,15 @@ void DecorationCclRegister()
 void LoadDecorations()
 {
 	std::vector<Decoration>::iterator i;
+	for (i = DecoSprite.SpriteArray.begin(); i != DecoSprite.SpriteArray.end(); ++i) {
+		PrefetchGraphicPNG((*i).File);
+	}
 	for (i = DecoSprite.SpriteArray.begin(); i != DecoSprite.SpriteArray.end(); ++i) {
 		ShowLoadProgress(_("Decorations '%s'"), (*i).File.c_str());
 		(*i).Sprite = CGraphic::New((*i).File, (*i).Width, (*i).Height);
 		(*i).Sprite->Load();
 	}
+	CleanPrefetchedGraphics();
 }
 
 /**
@@ -903,56 +909,112 @@ void CUnit::Draw(const CViewport &vp) const
 }
 
 /**
-**  Compare what order 2 units should be drawn on the map
-**
-**  @param c1  First Unit to compare (*Unit)
-**  @param c2  Second Unit to compare (*Unit)
+**  Unit filter for units visible in a viewport.
+*/
+class IsVisibleInViewportFilter
+{
+public:
+	explicit IsVisibleInViewportFilter(const CViewport &vp) : vp(&vp) {}
+	bool operator()(const CUnit *unit) const { return unit->IsVisibleInViewport(*vp); }
+private:
+	const CViewport *vp;
+};
+
+/**
+**  Fill the draw list entry of a unit.
 **
+**  Units are sorted by draw level, then by their Y position (bottom of
+**  sprite) on the map, then by X position.
 */
-static inline bool DrawLevelCompare(const CUnit *c1, const CUnit *c2)
+static void MakeUnitDrawItem(CUnit &unit, CDrawItem &item)
 {
-	int drawlevel1 = c1->GetDrawLevel();
-	int drawlevel2 = c2->GetDrawLevel();
-
-	if (drawlevel1 == drawlevel2) {
-		// diffpos compares unit's Y positions (bottom of sprite) on the map
-		// and uses X position in case Y positions are equal.
-		const int pos1 = (c1->tilePos.y + c1->Type->TileHeight - 1) * PixelTileSize.y + c1->IY;
-		const int pos2 = (c2->tilePos.y + c2->Type->TileHeight - 1) * PixelTileSize.y + c2->IY;
-		return pos1 == pos2 ?
-			   (c1->tilePos.x != c2->tilePos.x ? c1->tilePos.x < c2->tilePos.x : UnitNumber(*c1) < UnitNumber(*c2)) : pos1 < pos2;
-	} else {
-		return drawlevel1 < drawlevel2;
-	}
+	item.DrawLevel = unit.GetDrawLevel();
+	item.Type = DrawItemUnit;
+	item.Y = (unit.tilePos.y + unit.Type->TileHeight - 1) * PixelTileSize.y + unit.IY;
+	item.X = unit.tilePos.x;
+	item.Id = UnitNumber(unit);
+	item.Object.unit = &unit;
 }
 
 /**
 **  Find all units to draw in viewport.
 **
-**  @param vp     Viewport to be drawn.
-**  @param table  Table of units to return in sorted order
+**  The table keeps the order of the previous frame: units still visible
+**  are kept in place and sorted by insertion sort, which is about linear
+**  for the nearly sorted data of steady frames. Newly visible units are
+**  sorted apart and merged in.
 **
+**  @param vp     Viewport to be drawn.
+**  @param table  IN: draw list of the previous frame,
+**                OUT: units to draw in sorted order.
 */
-int FindAndSortUnits(const CViewport &vp, std::vector<CUnit *> &table)
+void FindAndSortUnits(const CViewport &vp, std::vector<CDrawItem> &table)
 {
+	// Per unit slot: DrawStamp if visible, DrawStamp + 1 once in the table.
+	static std::vector<unsigned int> drawStamps;
+	static unsigned int drawStamp = 0;
+	static std::vector<CUnit *> units;
+
+	drawStamp += 2;
+	if (drawStamp == 0) {
+		std::fill(drawStamps.begin(), drawStamps.end(), 0);
+		drawStamp = 2;
+	}
+	if (drawStamps.size() < UnitManager.GetUsedSlotCount()) {
+		drawStamps.resize(UnitManager.GetUsedSlotCount(), 0);
+	}
+
 	//  Select all units touching the viewpoint.
 	const Vec2i offset(1, 1);
 	const Vec2i vpSize(vp.MapWidth, vp.MapHeight);
 	const Vec2i minPos = vp.MapPos - offset;
 	const Vec2i maxPos = vp.MapPos + vpSize + offset;
 
-	Select(minPos, maxPos, table);
+	units.clear();
+	Select(minPos, maxPos, units, IsVisibleInViewportFilter(vp));
+	for (size_t i = 0; i != units.size(); ++i) {
+		drawStamps[UnitNumber(*units[i])] = drawStamp;
+	}
 
-	size_t n = table.size();
-	for (size_t i = 0; i < table.size(); ++i) {
-		if (!table[i]->IsVisibleInViewport(vp)) {
-			table[i--] = table[--n];
-			table.pop_back();
+	// Keep the units of the last frame which are still visible.
+	size_t n = 0;
+	for (size_t i = 0; i != table.size(); ++i) {
+		const unsigned int slot = table[i].Id;
+
+		if (table[i].Type != DrawItemUnit || slot >= drawStamps.size()
+			|| drawStamps[slot] != drawStamp) {
+			continue;
+		}
+		drawStamps[slot] = drawStamp + 1;
+		MakeUnitDrawItem(UnitManager.GetSlotUnit(slot), table[n++]);
+	}
+	table.resize(n);
+
+	// Insertion sort: units have moved a little since the last frame.
+	for (size_t i = 1; i < n; ++i) {
+		if (!(table[i] < table[i - 1])) {
+			continue;
+		}
+		const CDrawItem item = table[i];
+		size_t j = i;
+		do {
+			table[j] = table[j - 1];
+			--j;
+		} while (j != 0 && item < table[j - 1]);
+		table[j] = item;
+	}
+
+	// Append the newly visible units.
+	for (size_t i = 0; i != units.size(); ++i) {
+		CUnit &unit = *units[i];
+
+		if (drawStamps[UnitNumber(unit)] == drawStamp) {
+			table.push_back(CDrawItem());
+			MakeUnitDrawItem(unit, table.back());
 		}
 	}
-	Assert(n == table.size());
-	std::sort(table.begin(), table.begin() + n, DrawLevelCompare);
-	return n;
+	std::sort(table.begin() + n, table.end());
+	std::inplace_merge(table.begin(), table.begin() + n, table.end());
 }
 
 //@}
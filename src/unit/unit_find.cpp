@@ -164,6 +164,21 @@ bool FindTerrainType(int movemask, int resmask, int range,
 {
 	TerrainTraversal terrainTraversal;
 
+	return FindTerrainType(movemask, resmask, range, player, startPos, terrainPos, terrainTraversal);
+}
+
+/**
+**  Find the closest piece of terrain with the given flags.
+**
+**  Like the other FindTerrainType, but the caller can look at the tiles
+**  the search reached afterwards.
+**
+**  @param terrainTraversal  OUT: The traversal used for the search.
+*/
+bool FindTerrainType(int movemask, int resmask, int range,
+					 const CPlayer &player, const Vec2i &startPos, Vec2i *terrainPos,
+					 TerrainTraversal &terrainTraversal)
+{
 	terrainTraversal.SetSize(Map.Info.MapWidth, Map.Info.MapHeight);
 	terrainTraversal.Init();
 
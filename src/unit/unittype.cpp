@@ -525,7 +525,7 @@ CUnitType::CUnitType() :
 	Slot(0), Width(0), Height(0), OffsetX(0), OffsetY(0), DrawLevel(0),
 	ShadowWidth(0), ShadowHeight(0), ShadowOffsetX(0), ShadowOffsetY(0),
 	Animations(NULL), StillFrame(0),
-	DeathExplosion(NULL), OnHit(NULL), OnEachCycle(NULL), OnEachSecond(NULL), OnInit(NULL),
+	DeathExplosion(NULL), OnHit(NULL), OnEachCycle(NULL), OnEachCycleBatch(NULL), OnEachSecond(NULL), OnInit(NULL),
 	TeleportCost(0), TeleportEffectIn(NULL), TeleportEffectOut(NULL),
 	CorpseType(NULL), Construction(NULL), RepairHP(0), TileWidth(0), TileHeight(0),
 	BoxWidth(0), BoxHeight(0), BoxOffsetX(0), BoxOffsetY(0), NumDirections(0),
@@ -557,6 +557,7 @@ CUnitType::~CUnitType()
 	delete DeathExplosion;
 	delete OnHit;
 	delete OnEachCycle;
+	delete OnEachCycleBatch;
 	delete OnEachSecond;
 	delete OnInit;
 	delete TeleportEffectIn;
@@ -1048,6 +1049,26 @@ void LoadUnitTypeSprite(CUnitType &type)
 */
 void LoadUnitTypes()
 {
+#ifndef DYNAMIC_LOAD
+	// Decode the sprites in the background while the types are set up.
+	for (std::vector<CUnitType *>::size_type i = 0; i < UnitTypes.size(); ++i) {
+		const CUnitType &type = *UnitTypes[i];
+
+		if (type.Sprite) {
+			continue;
+		}
+		PrefetchGraphicPNG(type.ShadowFile);
+		if (type.BoolFlag[HARVESTER_INDEX].value) {
+			for (int j = 0; j < MaxCosts; ++j) {
+				if (type.ResInfo[j]) {
+					PrefetchGraphicPNG(type.ResInfo[j]->FileWhenLoaded);
+					PrefetchGraphicPNG(type.ResInfo[j]->FileWhenEmpty);
+				}
+			}
+		}
+		PrefetchGraphicPNG(type.File);
+	}
+#endif
 	for (std::vector<CUnitType *>::size_type i = 0; i < UnitTypes.size(); ++i) {
 		CUnitType &type = *UnitTypes[i];
 
@@ -1074,6 +1095,7 @@ void LoadUnitTypes()
 #endif
 		// FIXME: should i copy the animations of same graphics?
 	}
+	CleanPrefetchedGraphics();
 }
 
 void CUnitTypeVar::Init()
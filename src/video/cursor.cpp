@@ -261,12 +261,13 @@ void DrawCursor()
 	}
 	const PixelPos pos = CursorScreenPos - GameCursor->HotPos;
 
+	// Save the background, the panels of the game are not drawn again
+	// each frame, see CPanelLayer.
 #if defined(USE_OPENGL) || defined(USE_GLES)
-	if (!UseOpenGL &&
+	if (!UseOpenGL) {
 #else
-	if (
+	{
 #endif
-		!GameRunning && !Editor.Running) {
 		if (!HiddenSurface
 			|| HiddenSurface->w != GameCursor->G->getWidth()
 			|| HiddenSurface->h != GameCursor->G->getHeight()) {
@@ -302,11 +303,10 @@ void DrawCursor()
 void HideCursor()
 {
 #if defined(USE_OPENGL) || defined(USE_GLES)
-	if (!UseOpenGL &&
+	if (!UseOpenGL && GameCursor && HiddenSurface) {
 #else
-	if (
+	if (GameCursor && HiddenSurface) {
 #endif
-		!GameRunning && !Editor.Running && GameCursor) {
 		const PixelPos pos = CursorScreenPos - GameCursor->HotPos;
 		SDL_Rect dstRect = {Sint16(pos.x), Sint16(pos.y), 0, 0 };
 		SDL_BlitSurface(HiddenSurface, NULL, TheScreen, &dstRect);
@@ -68,6 +68,77 @@ static std::string DefaultReverseColorIndex; /// Default reverse color index
 typedef std::map<const CFontColor *, CGraphic *> FontColorGraphicMap;
 static std::map<const CFont *, FontColorGraphicMap> FontColorGraphics;
 
+/**
+**  Glyph of a text layout.
+*/
+struct TextGlyph {
+	int GX;  /// X offset into the font graphic
+	int GY;  /// Y offset into the font graphic
+	int W;   /// Width of the glyph
+	int X;   /// X offset from the start of the text
+};
+
+/**
+**  Glyphs of a text layout drawn with the same colors.
+*/
+struct TextRun {
+	const CFontColor *GraphicColor;  /// Color of the font graphic (OpenGL)
+	const CFontColor *Color;         /// Colors of the font palette (SDL)
+	size_t Begin;                    /// First glyph of the run
+	size_t End;                      /// Glyph after the last of the run
+};
+
+/**
+**  Measured glyph runs of a text, so that drawing the same text again
+**  does not decode and parse it.
+*/
+struct TextLayout {
+	std::vector<TextGlyph> Glyphs;
+	std::vector<TextRun> Runs;
+	int Width;                        /// Width of the text in pixels
+	bool Cacheable;                   /// Doesn't depend on LastTextColor
+	bool SetsLastTextColor;           /// Text sets LastTextColor
+	const CFontColor *LastTextColor;  /// LastTextColor after the text
+};
+
+/**
+**  Key of the text layout cache.
+*/
+struct TextLayoutKey {
+	bool operator<(const TextLayoutKey &rhs) const
+	{
+		if (Font != rhs.Font) {
+			return Font < rhs.Font;
+		}
+		if (Color != rhs.Color) {
+			return Color < rhs.Color;
+		}
+		if (Reverse != rhs.Reverse) {
+			return Reverse < rhs.Reverse;
+		}
+		return Text < rhs.Text;
+	}
+
+	const CFont *Font;
+	const CFontColor *Color;
+	const CFontColor *Reverse;
+	std::string Text;
+};
+
+typedef std::map<TextLayoutKey, TextLayout> TextLayoutMap;
+static TextLayoutMap TextLayouts;  /// Cache of the drawn texts
+
+/**
+**  Flush the cached text layouts, after a change of fonts or font colors.
+*/
+static void CleanTextLayouts()
+{
+	TextLayouts.clear();
+}
+
+/// Number of cached text layouts or widths after which the cache is flushed
+static const size_t MaxCachedTexts = 2048;
+
 // FIXME: remove these
 static CFont *SmallFont;  /// Small font used in stats
 static CFont *GameFont;   /// Normal font used in game
@@ -164,6 +235,8 @@ void SetDefaultTextColors(const std::string &normal, const std::string &reverse)
 	DefaultReverseColorIndex = reverse;
 	LastTextColor = DefaultTextColor = FontColor = CFontColor::Get(normal);
 	ReverseTextColor = CFontColor::Get(reverse);
+	// The layouts are made with the graphic of FontColor.
+	CleanTextLayouts();
 }
 
 /**
@@ -357,6 +430,13 @@ int CFont::Width(const std::string &text) const
 	size_t pos = 0;
 
 	DynamicLoad();
+	std::map<std::string, int>::const_iterator it = WidthCache.find(text);
+	if (it != WidthCache.end()) {
+		return it->second;
+	}
+	if (WidthCache.size() >= MaxCachedTexts) {
+		WidthCache.clear();
+	}
 	while (GetUTF8(text, pos, utf8)) {
 		if (utf8 == '~') {
 			if (text[pos] == '|') {
@@ -384,6 +464,7 @@ int CFont::Width(const std::string &text) const
 			width += this->CharWidth[utf8 - 32] + 1;
 		}
 	}
+	WidthCache[text] = width;
 	return width;
 }
 
@@ -437,8 +518,16 @@ static void VideoDrawCharClip(const CGraphic &g, int gx, int gy, int w, int h,
 }
 
 
-template<bool CLIP>
-unsigned int CFont::DrawChar(CGraphic &g, int utf8, int x, int y, const CFontColor &fc) const
+/**
+**  Get the place of a glyph in the font graphic.
+**
+**  @param utf8  Character of the glyph.
+**  @param gx    OUT: X offset into the font graphic.
+**  @param gy    OUT: Y offset into the font graphic.
+**
+**  @return      Width of the glyph.
+*/
+int CFont::GetGlyph(int utf8, int &gx, int &gy) const
 {
 	int c = utf8 - 32;
 	Assert(c >= 0);
@@ -447,9 +536,57 @@ unsigned int CFont::DrawChar(CGraphic &g, int utf8, int x, int y, const CFontCol
 	if (c < 0 || ipr * this->G->GraphicHeight / this->G->Height <= c) {
 		c = 0;
 	}
-	const int w = this->CharWidth[c];
-	const int gx = (c % ipr) * this->G->Width;
-	const int gy = (c / ipr) * this->G->Height;
+	gx = (c % ipr) * this->G->Width;
+	gy = (c / ipr) * this->G->Height;
+	return this->CharWidth[c];
+}
+
+/**
+**  Clip a glyph to the clipping rectangle.
+**
+**  @return  false if nothing of the glyph is visible.
+*/
+static bool ClipGlyph(int &gx, int &gy, int &w, int &h, int &x, int &y)
+{
+	if (y < ClipY1) {
+		const int oy = ClipY1 - y;
+		if (h <= oy) {
+			return false;
+		}
+		h -= oy;
+		gy += oy;
+		y = ClipY1;
+	}
+	if (y + h > ClipY2 + 1) {
+		if (y > ClipY2) {
+			return false;
+		}
+		h = ClipY2 - y + 1;
+	}
+	if (x < ClipX1) {
+		const int ox = ClipX1 - x;
+		if (w <= ox) {
+			return false;
+		}
+		w -= ox;
+		gx += ox;
+		x = ClipX1;
+	}
+	if (x + w > ClipX2 + 1) {
+		if (x > ClipX2) {
+			return false;
+		}
+		w = ClipX2 - x + 1;
+	}
+	return true;
+}
+
+template<bool CLIP>
+unsigned int CFont::DrawChar(CGraphic &g, int utf8, int x, int y, const CFontColor &fc) const
+{
+	int gx;
+	int gy;
+	const int w = GetGlyph(utf8, gx, gy);
 
 	if (CLIP) {
 		VideoDrawCharClip(g, gx, gy, w, this->G->Height, x , y, fc);
@@ -479,7 +616,32 @@ CGraphic *CFont::GetFontColorGraphic(const CFontColor &fontColor) const
 }
 
 /**
-**  Draw text with font at x,y clipped/unclipped.
+**  Add a glyph to a text layout.
+*/
+static void AddTextGlyph(const CFont &font, int utf8, const CFontColor *graphicColor,
+						 const CFontColor *fc, TextLayout &layout)
+{
+	TextGlyph glyph;
+
+	glyph.W = font.GetGlyph(utf8, glyph.GX, glyph.GY);
+	glyph.X = layout.Width;
+	layout.Width += glyph.W + 1;
+
+	if (layout.Runs.empty() || layout.Runs.back().GraphicColor != graphicColor
+		|| layout.Runs.back().Color != fc) {
+		TextRun run;
+
+		run.GraphicColor = graphicColor;
+		run.Color = fc;
+		run.Begin = layout.Glyphs.size();
+		layout.Runs.push_back(run);
+	}
+	layout.Glyphs.push_back(glyph);
+	layout.Runs.back().End = layout.Glyphs.size();
+}
+
+/**
+**  Measure a text into glyph runs.
 **
 **  ~    is special prefix.
 **  ~~   is the ~ character self.
@@ -487,27 +649,29 @@ CGraphic *CFont::GetFontColorGraphic(const CFontColor &fontColor) const
 **  ~<   start reverse.
 **  ~>   switch back to last used color.
 **
-**  @param x     X screen position
-**  @param y     Y screen position
-**  @param font  Font number
-**  @param text  Text to be displayed.
-**  @param clip  Flag if TRUE clip, otherwise not.
-**
-**  @return      The length of the printed text.
+**  @param font     Font of the text.
+**  @param text     Text to be displayed.
+**  @param len      Length of the text.
+**  @param fc       Normal color of the text.
+**  @param reverse  Reverse color of the text.
+**  @param layout   OUT: glyph runs of the text.
 */
-template <const bool CLIP>
-int CLabel::DoDrawText(int x, int y,
-					   const char *const text, const size_t len, const CFontColor *fc) const
+static void MakeTextLayout(const CFont &font, const char *const text, const size_t len,
+						   const CFontColor *fc, const CFontColor *reverse, TextLayout &layout)
 {
-	int widths = 0;
 	int utf8;
 	bool tab;
 	const int tabSize = 4; // FIXME: will be removed when text system will be rewritten
 	size_t pos = 0;
 	const CFontColor *backup = fc;
 	bool isColor = false;
-	font->DynamicLoad();
-	CGraphic *g = font->GetFontColorGraphic(*FontColor);
+	const CFontColor *graphicColor = FontColor;
+
+	layout.Glyphs.clear();
+	layout.Runs.clear();
+	layout.Width = 0;
+	layout.Cacheable = true;
+	layout.SetsLastTextColor = false;
 
 	while (GetUTF8(text, len, pos, utf8)) {
 		tab = false;
@@ -517,7 +681,8 @@ int CLabel::DoDrawText(int x, int y,
 			switch (text[pos]) {
 				case '\0':  // wrong formatted string.
 					DebugPrint("oops, format your ~\n");
-					return widths;
+					layout.LastTextColor = LastTextColor;
+					return;
 				case '~':
 					++pos;
 					break;
@@ -527,24 +692,30 @@ int CLabel::DoDrawText(int x, int y,
 				case '!':
 					if (fc != reverse) {
 						fc = reverse;
-						g = font->GetFontColorGraphic(*fc);
+						graphicColor = fc;
 					}
 					++pos;
 					continue;
 				case '<':
 					LastTextColor = fc;
+					layout.SetsLastTextColor = true;
 					if (fc != reverse) {
 						isColor = true;
 						fc = reverse;
-						g = font->GetFontColorGraphic(*fc);
+						graphicColor = fc;
 					}
 					++pos;
 					continue;
 				case '>':
+					if (!layout.SetsLastTextColor) {
+						// Depends on the texts drawn before.
+						layout.Cacheable = false;
+					}
 					if (fc != LastTextColor) {
 						std::swap(fc, LastTextColor);
+						layout.SetsLastTextColor = true;
 						isColor = false;
-						g = font->GetFontColorGraphic(*fc);
+						graphicColor = fc;
 					}
 					++pos;
 					continue;
@@ -556,18 +727,20 @@ int CLabel::DoDrawText(int x, int y,
 					}
 					if (!*p) {
 						DebugPrint("oops, format your ~\n");
-						return widths;
+						layout.LastTextColor = LastTextColor;
+						return;
 					}
 					std::string color;
 
 					color.insert(0, text + pos, p - (text + pos));
 					pos = p - text + 1;
 					LastTextColor = fc;
+					layout.SetsLastTextColor = true;
 					const CFontColor *fc_tmp = CFontColor::Get(color);
 					if (fc_tmp) {
 						isColor = true;
 						fc = fc_tmp;
-						g = font->GetFontColorGraphic(*fc);
+						graphicColor = fc;
 					}
 					continue;
 				}
@@ -575,18 +748,187 @@ int CLabel::DoDrawText(int x, int y,
 		}
 		if (tab) {
 			for (int tabs = 0; tabs < tabSize; ++tabs) {
-				widths += font->DrawChar<CLIP>(*g, ' ', x + widths, y, *fc);
+				AddTextGlyph(font, ' ', graphicColor, fc, layout);
 			}
 		} else {
-			widths += font->DrawChar<CLIP>(*g, utf8, x + widths, y, *fc);
+			AddTextGlyph(font, utf8, graphicColor, fc, layout);
 		}
 
 		if (isColor == false && fc != backup) {
 			fc = backup;
-			g = font->GetFontColorGraphic(*fc);
+			graphicColor = fc;
+		}
+	}
+	layout.LastTextColor = LastTextColor;
+}
+
+/**
+**  Get the glyph runs of a text, from the cache if possible.
+*/
+static const TextLayout &GetTextLayout(const CFont &font, const char *const text, const size_t len,
+									   const CFontColor *fc, const CFontColor *reverse)
+{
+	static TextLayout uncachedLayout;
+	TextLayoutKey key;
+
+	key.Font = &font;
+	key.Color = fc;
+	key.Reverse = reverse;
+	key.Text.assign(text, len);
+
+	TextLayoutMap::iterator it = TextLayouts.find(key);
+	if (it != TextLayouts.end()) {
+		if (it->second.SetsLastTextColor) {
+			LastTextColor = it->second.LastTextColor;
+		}
+		return it->second;
+	}
+	MakeTextLayout(font, text, len, fc, reverse, uncachedLayout);
+	if (!uncachedLayout.Cacheable) {
+		return uncachedLayout;
+	}
+	if (TextLayouts.size() >= MaxCachedTexts) {
+		TextLayouts.clear();
+	}
+	TextLayout &layout = TextLayouts[key];
+	layout.Glyphs.swap(uncachedLayout.Glyphs);
+	layout.Runs.swap(uncachedLayout.Runs);
+	layout.Width = uncachedLayout.Width;
+	layout.Cacheable = true;
+	layout.SetsLastTextColor = uncachedLayout.SetsLastTextColor;
+	layout.LastTextColor = uncachedLayout.LastTextColor;
+	return layout;
+}
+
+#ifdef USE_OPENGL
+/**
+**  Draw the glyphs of a run as a batch of quads from one texture.
+**
+**  @return  false if the font graphic spans several textures.
+*/
+template <const bool CLIP>
+static bool DrawTextRunOpenGL(const CGraphic &g, const TextLayout &layout, const TextRun &run,
+							  int x, int y, int h)
+{
+	if (g.NumTextures != 1) {
+		return false;
+	}
+	glBindTexture(GL_TEXTURE_2D, g.Textures[0]);
+	glBegin(GL_QUADS);
+	for (size_t i = run.Begin; i != run.End; ++i) {
+		const TextGlyph &glyph = layout.Glyphs[i];
+		int gx = glyph.GX;
+		int gy = glyph.GY;
+		int sx = x + glyph.X;
+		int sy = y;
+		int w = glyph.W;
+		int gh = h;
+
+		if (w <= 0 || (CLIP && !ClipGlyph(gx, gy, w, gh, sx, sy))) {
+			continue;
+		}
+		const GLfloat tx_beg = gx * g.TextureWidth / g.GraphicWidth;
+		const GLfloat tx_end = (gx + w) * g.TextureWidth / g.GraphicWidth;
+		const GLfloat ty_beg = gy * g.TextureHeight / g.GraphicHeight;
+		const GLfloat ty_end = (gy + gh) * g.TextureHeight / g.GraphicHeight;
+
+		glTexCoord2f(tx_beg, ty_beg);
+		glVertex2i(sx, sy);
+		glTexCoord2f(tx_beg, ty_end);
+		glVertex2i(sx, sy + gh);
+		glTexCoord2f(tx_end, ty_end);
+		glVertex2i(sx + w, sy + gh);
+		glTexCoord2f(tx_end, ty_beg);
+		glVertex2i(sx + w, sy);
+	}
+	glEnd();
+	return true;
+}
+#endif
+
+/**
+**  Draw the glyph runs of a text.
+**
+**  @param font    Font of the text.
+**  @param layout  Glyph runs of the text.
+**  @param x       X screen position
+**  @param y       Y screen position
+*/
+template <const bool CLIP>
+static void DrawTextLayout(const CFont &font, const TextLayout &layout, int x, int y)
+{
+	const int h = font.Height();
+
+	for (size_t i = 0; i != layout.Runs.size(); ++i) {
+		const TextRun &run = layout.Runs[i];
+		CGraphic &g = *font.GetFontColorGraphic(*run.GraphicColor);
+
+#if defined(USE_OPENGL) || defined(USE_GLES)
+		if (UseOpenGL) {
+#ifdef USE_OPENGL
+			if (DrawTextRunOpenGL<CLIP>(g, layout, run, x, y, h)) {
+				continue;
+			}
+#endif
+			for (size_t j = run.Begin; j != run.End; ++j) {
+				const TextGlyph &glyph = layout.Glyphs[j];
+
+				if (CLIP) {
+					VideoDrawCharClip(g, glyph.GX, glyph.GY, glyph.W, h, x + glyph.X, y, *run.Color);
+				} else {
+					VideoDrawChar(g, glyph.GX, glyph.GY, glyph.W, h, x + glyph.X, y, *run.Color);
+				}
+			}
+		} else
+#endif
+		{
+			std::vector<SDL_Color> sdlColors(run.Color->Colors, run.Color->Colors + MaxFontColors);
+			SDL_SetColors(g.Surface, &sdlColors[0], 0, MaxFontColors);
+
+			for (size_t j = run.Begin; j != run.End; ++j) {
+				const TextGlyph &glyph = layout.Glyphs[j];
+				int gx = glyph.GX;
+				int gy = glyph.GY;
+				int sx = x + glyph.X;
+				int sy = y;
+				int w = glyph.W;
+				int gh = h;
+
+				if (CLIP) {
+					if (!ClipGlyph(gx, gy, w, gh, sx, sy)) {
+						continue;
+					}
+				}
+				SDL_Rect srect = {Sint16(gx), Sint16(gy), Uint16(w), Uint16(gh)};
+				SDL_Rect drect = {Sint16(sx), Sint16(sy), 0, 0};
+				SDL_BlitSurface(g.Surface, &srect, TheScreen, &drect);
+			}
 		}
 	}
-	return widths;
+}
+
+/**
+**  Draw text with font at x,y clipped/unclipped.
+**
+**  See MakeTextLayout for the format of the text.
+**
+**  @param x     X screen position
+**  @param y     Y screen position
+**  @param text  Text to be displayed.
+**  @param len   Length of the text.
+**  @param fc    Color of the text.
+**
+**  @return      The length of the printed text.
+*/
+template <const bool CLIP>
+int CLabel::DoDrawText(int x, int y,
+					   const char *const text, const size_t len, const CFontColor *fc) const
+{
+	font->DynamicLoad();
+	const TextLayout &layout = GetTextLayout(*font, text, len, fc, reverse);
+
+	DrawTextLayout<CLIP>(*font, layout, x, y);
+	return layout.Width;
 }
 
 
@@ -800,6 +1142,8 @@ void CFont::MeasureWidths()
 
 	delete[] CharWidth;
 	CharWidth = new char[maxy];
+	WidthCache.clear();
+	CleanTextLayouts();
 	memset(CharWidth, 0, maxy);
 	CharWidth[0] = G->Width / 2;  // a reasonable value for SPACE
 	const Uint32 ckey = G->Surface->format->colorkey;
@@ -1032,6 +1376,7 @@ CFontColor::~CFontColor()
 
 	if (fc == NULL) {
 		fc = new CFontColor(ident);
+		CleanTextLayouts();
 	}
 	return fc;
 }
@@ -1090,6 +1435,7 @@ void CleanFonts()
 	}
 #endif
 	Fonts.clear();
+	CleanTextLayouts();
 
 	for (FontColorMap::iterator it = FontColors.begin(); it != FontColors.end(); ++it) {
 		delete it->second;
@@ -35,6 +35,11 @@
 
 #include <png.h>
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
 #include "stratagus.h"
 #include "map.h"
 #include "video.h"
@@ -45,6 +50,25 @@
 --  Variables
 ----------------------------------------------------------------------------*/
 
+/// Png file decoded by a prefetch thread
+struct PrefetchedPNG {
+	PrefetchedPNG() : Surface(NULL), Started(false), Done(false) {}
+
+	std::string Name;     /// File name, as returned by LibraryFileName
+	SDL_Surface *Surface; /// Decoded image, NULL for error
+	bool Started;         /// A prefetch thread is decoding the file
+	bool Done;            /// Decoding has finished
+};
+
+static const size_t MaxPrefetchThreads = 4;  /// Number of prefetch threads
+
+static std::map<std::string, PrefetchedPNG *> PrefetchedPNGs; /// Prefetched files by graphic file
+static std::deque<PrefetchedPNG *> PrefetchQueue;  /// Files waiting for a prefetch thread
+static SDL_mutex *PrefetchLock;   /// Lock for the prefetch queue and results
+static SDL_cond *PrefetchCond;    /// Signaled when a file is queued or decoded
+static std::vector<SDL_Thread *> PrefetchThreads; /// Running prefetch threads
+static bool PrefetchQuit;         /// Prefetch threads stop when the queue is empty
+
 /*----------------------------------------------------------------------------
 --  Functions
 ----------------------------------------------------------------------------*/
@@ -78,34 +102,30 @@ private:
 };
 
 /**
-**  Load a png graphic file.
+**  Decode a png graphic file.
 **  Modified function from SDL_Image
 **
-**  @param g  graphic to load.
+**  Doesn't touch any global state, so it may be called from the
+**  prefetch threads.
 **
-**  @return   0 for success, -1 for error.
+**  @param name  file name, as returned by LibraryFileName.
+**
+**  @return      the decoded surface, NULL for error.
 */
-int LoadGraphicPNG(CGraphic *g)
+static SDL_Surface *DecodePNG(const std::string &name)
 {
-	if (g->File.empty()) {
-		return -1;
-	}
-	const std::string name = LibraryFileName(g->File.c_str());
-	if (name.empty()) {
-		return -1;
-	}
 	CFile fp;
 
 	if (fp.open(name.c_str(), CL_OPEN_READ) == -1) {
 		perror("Can't open file");
-		return -1;
+		return NULL;
 	}
 
 	// Create the PNG loading context structure
 	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if (png_ptr == NULL) {
 		fprintf(stderr, "Couldn't allocate memory for PNG file");
-		return -1;
+		return NULL;
 	}
 	// Clean png_ptr on exit
 	AutoPng_read_structp pngRaii(png_ptr);
@@ -114,7 +134,7 @@ int LoadGraphicPNG(CGraphic *g)
 	png_infop info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == NULL) {
 		fprintf(stderr, "Couldn't create image information for PNG file");
-		return -1;
+		return NULL;
 	}
 	pngRaii.setInfo(info_ptr);
 
@@ -124,7 +144,7 @@ int LoadGraphicPNG(CGraphic *g)
 	 */
 	if (setjmp(png_jmpbuf(png_ptr))) {
 		fprintf(stderr, "Error reading the PNG file.\n");
-		return -1;
+		return NULL;
 	}
 
 	/* Set up the input control */
@@ -225,7 +245,7 @@ int LoadGraphicPNG(CGraphic *g)
 						 bit_depth * png_get_channels(png_ptr, info_ptr), Rmask, Gmask, Bmask, Amask);
 	if (surface == NULL) {
 		fprintf(stderr, "Out of memory");
-		return -1;
+		return NULL;
 	}
 
 	if (ckey != -1) {
@@ -275,11 +295,167 @@ int LoadGraphicPNG(CGraphic *g)
 		}
 	}
 
+	fp.close();
+	return surface;
+}
+
+/**
+**  Decode the queued png files, until told to quit.
+*/
+static int PrefetchThread(void *)
+{
+	SDL_LockMutex(PrefetchLock);
+	for (;;) {
+		while (PrefetchQueue.empty() && !PrefetchQuit) {
+			SDL_CondWait(PrefetchCond, PrefetchLock);
+		}
+		if (PrefetchQueue.empty()) {
+			break;
+		}
+		PrefetchedPNG &png = *PrefetchQueue.front();
+		PrefetchQueue.pop_front();
+		png.Started = true;
+		SDL_UnlockMutex(PrefetchLock);
+
+		SDL_Surface *surface = DecodePNG(png.Name);
+
+		SDL_LockMutex(PrefetchLock);
+		png.Surface = surface;
+		png.Done = true;
+		SDL_CondBroadcast(PrefetchCond);
+	}
+	SDL_UnlockMutex(PrefetchLock);
+	return 0;
+}
+
+/**
+**  Start decoding a png graphic file in the background.
+**
+**  A later LoadGraphicPNG of a graphic with the same file takes the
+**  decoded image instead of decoding it again.
+**
+**  @param file  graphic file name.
+*/
+void PrefetchGraphicPNG(const std::string &file)
+{
+	if (file.empty() || PrefetchedPNGs.find(file) != PrefetchedPNGs.end()) {
+		return;
+	}
+	const std::string name = LibraryFileName(file.c_str());
+	if (name.empty()) {
+		return;
+	}
+	if (!PrefetchLock) {
+		PrefetchLock = SDL_CreateMutex();
+		PrefetchCond = SDL_CreateCond();
+	}
+	PrefetchedPNG *png = new PrefetchedPNG;
+	png->Name = name;
+
+	SDL_LockMutex(PrefetchLock);
+	PrefetchedPNGs[file] = png;
+	PrefetchQueue.push_back(png);
+	if (PrefetchThreads.size() < MaxPrefetchThreads) {
+		SDL_Thread *thread = SDL_CreateThread(PrefetchThread, NULL);
+		if (thread) {
+			PrefetchThreads.push_back(thread);
+		}
+	}
+	SDL_CondSignal(PrefetchCond);
+	SDL_UnlockMutex(PrefetchLock);
+}
+
+/**
+**  Take the image of a prefetched png graphic file.
+**
+**  If decoding of the file hasn't started yet, it is removed from the
+**  queue and the caller has to decode it.
+**
+**  @param file  graphic file name.
+**
+**  @return      the decoded surface, NULL if there is none.
+*/
+static SDL_Surface *TakePrefetchedPNG(const std::string &file)
+{
+	std::map<std::string, PrefetchedPNG *>::iterator it = PrefetchedPNGs.find(file);
+	if (it == PrefetchedPNGs.end()) {
+		return NULL;
+	}
+	PrefetchedPNG *png = it->second;
+
+	SDL_LockMutex(PrefetchLock);
+	if (!png->Started) {
+		PrefetchQueue.erase(std::find(PrefetchQueue.begin(), PrefetchQueue.end(), png));
+	} else {
+		while (!png->Done) {
+			SDL_CondWait(PrefetchCond, PrefetchLock);
+		}
+	}
+	SDL_UnlockMutex(PrefetchLock);
+
+	SDL_Surface *surface = png->Surface;
+	PrefetchedPNGs.erase(it);
+	delete png;
+	return surface;
+}
+
+/**
+**  Drop all prefetched images which were not used, and stop the prefetch
+**  threads.
+*/
+void CleanPrefetchedGraphics()
+{
+	while (!PrefetchedPNGs.empty()) {
+		SDL_Surface *surface = TakePrefetchedPNG(PrefetchedPNGs.begin()->first);
+		if (surface) {
+			SDL_FreeSurface(surface);
+		}
+	}
+	if (!PrefetchLock) {
+		return;
+	}
+	SDL_LockMutex(PrefetchLock);
+	PrefetchQuit = true;
+	SDL_CondBroadcast(PrefetchCond);
+	SDL_UnlockMutex(PrefetchLock);
+	for (size_t i = 0; i != PrefetchThreads.size(); ++i) {
+		SDL_WaitThread(PrefetchThreads[i], NULL);
+	}
+	PrefetchThreads.clear();
+	PrefetchQuit = false;
+
+	SDL_DestroyCond(PrefetchCond);
+	PrefetchCond = NULL;
+	SDL_DestroyMutex(PrefetchLock);
+	PrefetchLock = NULL;
+}
+
+/**
+**  Load a png graphic file.
+**
+**  @param g  graphic to load.
+**
+**  @return   0 for success, -1 for error.
+*/
+int LoadGraphicPNG(CGraphic *g)
+{
+	if (g->File.empty()) {
+		return -1;
+	}
+	SDL_Surface *surface = TakePrefetchedPNG(g->File);
+	if (surface == NULL) {
+		const std::string name = LibraryFileName(g->File.c_str());
+		if (name.empty()) {
+			return -1;
+		}
+		surface = DecodePNG(name);
+		if (surface == NULL) {
+			return -1;
+		}
+	}
 	g->Surface = surface;
 	g->GraphicWidth = surface->w;
 	g->GraphicHeight = surface->h;
-
-	fp.close();
 	return 0;
 }
 
@@ -0,0 +1,505 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_trigger.cpp - The test file for trigger.cpp. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include <string>
+
+#include "stratagus.h"
+#include "interface.h"
+#include "iolib.h"
+#include "map.h"
+#include "player.h"
+#include "script.h"
+#include "trigger.h"
+#include "unit.h"
+#include "unit_manager.h"
+#include "unittype.h"
+
+/**
+**  Triggers whose conditions count how many times they are checked.
+*/
+class TriggerFixture
+{
+public:
+	TriggerFixture()
+	{
+		if (!Lua) {
+			InitLua();
+			TriggerCclRegister();
+		}
+		GameCycle = 0;
+		GamePaused = false;
+		NumPlayers = 1;
+		Run("checks = {}\n"
+			"function Counted(name, result)\n"
+			"  checks[name] = 0\n"
+			"  return function() checks[name] = checks[name] + 1 return result end\n"
+			"end\n"
+			// SetTrigger is bound by tolua, which the tests don't open.
+			"function SetTrigger() end\n");
+	}
+	~TriggerFixture()
+	{
+		CleanTriggers();
+		GameCycle = 0;
+		for (int i = 0; i != MaxCosts; ++i) {
+			Players[0].Resources[i] = 0;
+		}
+	}
+
+	/// Run a Lua chunk
+	bool Run(const char *chunk)
+	{
+		if (luaL_dostring(Lua, chunk)) {
+			lua_pop(Lua, 1);
+			return false;
+		}
+		return true;
+	}
+	/// Check the triggers for some game cycles
+	void Cycles(int count)
+	{
+		for (int i = 0; i != count; ++i) {
+			++GameCycle;
+			TriggersEachCycle();
+		}
+	}
+	/// Number of times the condition named name was checked
+	int Checks(const char *name)
+	{
+		lua_getglobal(Lua, "checks");
+		lua_getfield(Lua, -1, name);
+		const int checks = lua_tonumber(Lua, -1);
+		lua_pop(Lua, 2);
+		return checks;
+	}
+	/// Forget the number of times the conditions were checked
+	void ResetChecks()
+	{
+		Run("for name in pairs(checks) do checks[name] = 0 end");
+	}
+	/// Save the trigger module, clean it and load it again with the triggers of the map
+	bool SaveAndLoad(const char *triggers)
+	{
+		CFile file;
+		std::string saved;
+
+		file.openBuffer();
+		SaveTriggers(file);
+		file.takeBuffer(saved);
+		CleanTriggers();
+
+		lua_pushstring(Lua, triggers);
+		lua_setglobal(Lua, "Triggers");
+		return Run(saved.c_str());
+	}
+};
+
+TEST_FIXTURE(TriggerFixture, TriggerDependencyWakeUps)
+{
+	CHECK(Run("AddTrigger(Counted('units', false), function() end, {'units'})\n"
+			  "AddTrigger(Counted('resources', false), function() end, {'resources'})\n"
+			  "AddTrigger(Counted('timer', false), function() end, {'timer'})\n"
+			  "AddTrigger(Counted('map', false), function() end, {'map'})\n"));
+
+	// Each condition is checked once with the current state.
+	Cycles(3);
+	CHECK_EQUAL(1, Checks("units"));
+	CHECK_EQUAL(1, Checks("resources"));
+	CHECK_EQUAL(1, Checks("timer"));
+	CHECK_EQUAL(1, Checks("map"));
+
+	ResetChecks();
+	++PlayerUnitsChangeCount;
+	Cycles(3);
+	CHECK_EQUAL(1, Checks("units"));
+	CHECK_EQUAL(0, Checks("resources"));
+	CHECK_EQUAL(0, Checks("timer"));
+	CHECK_EQUAL(0, Checks("map"));
+
+	ResetChecks();
+	Players[0].Resources[GoldCost] += 100;
+	Cycles(3);
+	CHECK_EQUAL(0, Checks("units"));
+	CHECK_EQUAL(1, Checks("resources"));
+	CHECK_EQUAL(0, Checks("timer"));
+	CHECK_EQUAL(0, Checks("map"));
+
+	ResetChecks();
+	GameTimer.Init = true;
+	GameTimer.Cycles = 100;
+	Cycles(3);
+	CHECK_EQUAL(0, Checks("units"));
+	CHECK_EQUAL(0, Checks("resources"));
+	CHECK_EQUAL(1, Checks("timer"));
+	CHECK_EQUAL(0, Checks("map"));
+
+	ResetChecks();
+	++Map.ChangeCount;
+	Cycles(3);
+	CHECK_EQUAL(0, Checks("units"));
+	CHECK_EQUAL(0, Checks("resources"));
+	CHECK_EQUAL(0, Checks("timer"));
+	CHECK_EQUAL(1, Checks("map"));
+}
+
+TEST_FIXTURE(TriggerFixture, TriggerCycleAndInterval)
+{
+	CHECK(Run("AddTrigger(Counted('cycle', false), function() end, {'cycle', 10})\n"
+			  "AddTrigger(Counted('interval', false), function() end, {'interval', 4})\n"));
+
+	Cycles(9);
+	CHECK_EQUAL(0, Checks("cycle"));
+	CHECK_EQUAL(2, Checks("interval"));
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("cycle"));
+	Cycles(10);
+	CHECK_EQUAL(1, Checks("cycle"));
+	CHECK_EQUAL(5, Checks("interval"));
+}
+
+TEST_FIXTURE(TriggerFixture, TriggerRemovedAfterItsAction)
+{
+	CHECK(Run("actions = 0\n"
+			  "AddTrigger(Counted('once', true), function() actions = actions + 1 end, {'units'})\n"
+			  "AddTrigger(Counted('kept', true), function() return true end, {'units'})\n"));
+
+	Cycles(1);
+	++PlayerUnitsChangeCount;
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("once"));
+	CHECK_EQUAL(2, Checks("kept"));
+	lua_getglobal(Lua, "actions");
+	CHECK_EQUAL(1, int(lua_tonumber(Lua, -1)));
+	lua_pop(Lua, 1);
+}
+
+TEST_FIXTURE(TriggerFixture, TriggerBadDependencies)
+{
+	CHECK(!Run("AddTrigger(function() end, function() end, {'weather'})"));
+	CHECK(!Run("AddTrigger(function() end, function() end, {})"));
+	CHECK(!Run("AddTrigger(function() end, function() end, {'interval', 0})"));
+}
+
+static const char MapTriggers[] =
+	"AddTrigger(Counted('units', false), function() end, {'units'})\n"
+	"AddTrigger(Counted('resources', false), function() end, {'resources'})\n"
+	"AddTrigger(Counted('cycle', false), function() end, {'cycle', 20})\n";
+
+TEST_FIXTURE(TriggerFixture, TriggerScheduleSavedBeforeTheFirstCheck)
+{
+	CHECK(Run((std::string("Triggers = [[") + MapTriggers + "]]\n"
+			   "assert(loadstring(Triggers))()").c_str()));
+	CHECK(SaveAndLoad(MapTriggers));
+
+	// Nothing was checked yet, so everything is still pending.
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("units"));
+	CHECK_EQUAL(1, Checks("resources"));
+	CHECK_EQUAL(0, Checks("cycle"));
+}
+
+TEST_FIXTURE(TriggerFixture, TriggerScheduleRoundTrip)
+{
+	CHECK(Run((std::string("Triggers = [[") + MapTriggers + "]]\n"
+			   "assert(loadstring(Triggers))()").c_str()));
+	Cycles(5);
+	CHECK_EQUAL(1, Checks("units"));
+	CHECK_EQUAL(1, Checks("resources"));
+
+	// Changed after the last check, the saved game must still wake the trigger.
+	++PlayerUnitsChangeCount;
+	CHECK(SaveAndLoad(MapTriggers));
+
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("units"));
+	CHECK_EQUAL(0, Checks("resources"));
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("units"));
+
+	// The resources are compared with their state when saved.
+	Players[0].Resources[WoodCost] += 50;
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("resources"));
+
+	Cycles(20 - GameCycle - 1);
+	CHECK_EQUAL(0, Checks("cycle"));
+	Cycles(1);
+	CHECK_EQUAL(1, Checks("cycle"));
+}
+
+TEST_FIXTURE(TriggerFixture, TriggerScheduleRoundTripPastCycle)
+{
+	CHECK(Run((std::string("Triggers = [[") + MapTriggers + "]]\n"
+			   "assert(loadstring(Triggers))()").c_str()));
+	Cycles(25);
+	CHECK_EQUAL(1, Checks("cycle"));
+	CHECK(SaveAndLoad(MapTriggers));
+
+	// The cycle is already past, the saved game doesn't check it again.
+	Cycles(10);
+	CHECK_EQUAL(0, Checks("cycle"));
+	CHECK_EQUAL(0, Checks("units"));
+	CHECK_EQUAL(0, Checks("resources"));
+}
+
+static CUnitType *Footman;
+static CUnitType *Farm;
+
+/**
+**  Native trigger conditions on a small map with the units of two players.
+*/
+class TriggerMapFixture : public TriggerFixture
+{
+public:
+	TriggerMapFixture()
+	{
+		if (!Footman) {
+			UnitTypeVar.Init();
+			Footman = NewUnitTypeSlot("unit-test-footman");
+			Footman->TileWidth = 1;
+			Footman->TileHeight = 1;
+			Farm = NewUnitTypeSlot("unit-test-farm");
+			Farm->TileWidth = 2;
+			Farm->TileHeight = 2;
+			Farm->Building = 1;
+			UpdateStats(1);
+		}
+		Map.Info.MapWidth = 32;
+		Map.Info.MapHeight = 32;
+		Map.Create();
+		NumPlayers = 2;
+		for (int i = 0; i != PlayerMax; ++i) {
+			Players[i].Index = i;
+		}
+		ThisPlayer = &Players[0];
+		Run("fired = 0\n"
+			"function Fired() fired = fired + 1 return true end\n");
+	}
+	~TriggerMapFixture()
+	{
+		CleanTriggers();
+		for (size_t i = 0; i != Units.size(); ++i) {
+			if (!Units[i]->Removed) {
+				Map.Remove(*Units[i]);
+			}
+		}
+		for (int i = 0; i != PlayerMax; ++i) {
+			Players[i].Clear();
+		}
+		UnitManager.Init();
+		delete[] Map.Fields;
+		Map.Fields = NULL;
+		Map.Influence.Clean();
+		Map.Info.Clear();
+		ThisPlayer = NULL;
+	}
+
+	/// Make a unit and insert it into the map as CUnit::Place does
+	CUnit &Make(CUnitType &type, int player, const Vec2i &pos)
+	{
+		CUnit &unit = *MakeUnit(type, &Players[player]);
+
+		Units.push_back(&unit);
+		Place(unit, pos);
+		return unit;
+	}
+	/// Insert the unit into the map
+	void Place(CUnit &unit, const Vec2i &pos)
+	{
+		unit.Removed = 0;
+		unit.tilePos = pos;
+		unit.Offset = Map.getIndex(pos);
+		Map.Insert(unit);
+	}
+	/// Remove the unit from the map
+	void Remove(CUnit &unit)
+	{
+		Map.Remove(unit);
+		unit.Removed = 1;
+	}
+	/// Number of times the action of the triggers ran
+	int Fired()
+	{
+		lua_getglobal(Lua, "fired");
+		const int fired = lua_tonumber(Lua, -1);
+		lua_pop(Lua, 1);
+		return fired;
+	}
+
+	std::vector<CUnit *> Units;  /// Units made by the test
+};
+
+TEST_FIXTURE(TriggerMapFixture, TriggerAreaInsertAndRemove)
+{
+	CTriggerArea area(Footman, Vec2i(4, 4), Vec2i(7, 7));
+	CTriggerArea buildings(ALL_BUILDINGS);
+	const unsigned long areaCount = area.ChangeCount;
+	const unsigned long buildingsCount = buildings.ChangeCount;
+
+	CUnit &inside = Make(*Footman, 0, Vec2i(5, 5));
+	CHECK_EQUAL(areaCount + 1, area.ChangeCount);
+	CUnit &outside = Make(*Footman, 0, Vec2i(10, 10));
+	CHECK_EQUAL(areaCount + 1, area.ChangeCount);
+	CHECK_EQUAL(buildingsCount, buildings.ChangeCount);
+
+	// A building on the border of the area is a building, not a footman.
+	Make(*Farm, 1, Vec2i(3, 3));
+	CHECK_EQUAL(areaCount + 1, area.ChangeCount);
+	CHECK_EQUAL(buildingsCount + 1, buildings.ChangeCount);
+
+	Remove(inside);
+	CHECK_EQUAL(areaCount + 2, area.ChangeCount);
+	Remove(outside);
+	CHECK_EQUAL(areaCount + 2, area.ChangeCount);
+
+	// Moving into the area counts once, when the unit enters.
+	Place(outside, Vec2i(7, 7));
+	CHECK_EQUAL(areaCount + 3, area.ChangeCount);
+	CHECK(area.Matches(outside));
+	CHECK(!buildings.Matches(outside));
+}
+
+TEST_FIXTURE(TriggerMapFixture, TriggerAreaChangeOwner)
+{
+	CTriggerArea area(Footman, Vec2i(4, 4), Vec2i(7, 7));
+	CUnit &unit = Make(*Footman, 0, Vec2i(5, 5));
+	const unsigned long areaCount = area.ChangeCount;
+	const unsigned long unitsCount = PlayerUnitsChangeCount;
+
+	// The area doesn't know the owners, the unit counts of the players changed.
+	unit.ChangeOwner(Players[1]);
+	CHECK_EQUAL(areaCount, area.ChangeCount);
+	CHECK(PlayerUnitsChangeCount != unitsCount);
+	CHECK_EQUAL(0, Players[0].UnitTypesCount[Footman->Slot]);
+	CHECK_EQUAL(1, Players[1].UnitTypesCount[Footman->Slot]);
+}
+
+TEST_FIXTURE(TriggerMapFixture, TriggerConditionUnitsAt)
+{
+	CHECK(Run("AddTrigger({'units-at', 1, 'unit-test-footman', {4, 4}, {7, 7}, '>=', 2}, Fired)"));
+	Cycles(1);
+	CHECK_EQUAL(0, Fired());
+
+	CUnit &first = Make(*Footman, 1, Vec2i(4, 4));
+	Make(*Footman, 1, Vec2i(12, 12));
+	Make(*Footman, 0, Vec2i(6, 6));
+	Cycles(1);
+	CHECK_EQUAL(0, Fired());
+
+	CUnit &second = Make(*Footman, 1, Vec2i(7, 5));
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+
+	Remove(second);
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+	Place(second, Vec2i(5, 7));
+	Cycles(1);
+	CHECK_EQUAL(2, Fired());
+
+	first.ChangeOwner(Players[0]);
+	Cycles(1);
+	CHECK_EQUAL(2, Fired());
+	first.ChangeOwner(Players[1]);
+	Cycles(1);
+	CHECK_EQUAL(3, Fired());
+
+	// Nothing changed, the condition isn't checked again.
+	Cycles(5);
+	CHECK_EQUAL(3, Fired());
+}
+
+TEST_FIXTURE(TriggerMapFixture, TriggerConditionUnitTypesCount)
+{
+	CHECK(Run("AddTrigger({'unit-types-count', 'this', 'unit-test-farm', '==', 2}, Fired)"));
+	Make(*Farm, 0, Vec2i(2, 2));
+	Make(*Farm, 1, Vec2i(6, 2));
+	Cycles(1);
+	CHECK_EQUAL(0, Fired());
+
+	CUnit &farm = Make(*Farm, 0, Vec2i(10, 2));
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+
+	Make(*Farm, 0, Vec2i(14, 2));
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+	farm.ChangeOwner(Players[1]);
+	Cycles(1);
+	CHECK_EQUAL(2, Fired());
+}
+
+TEST_FIXTURE(TriggerMapFixture, TriggerConditionNearUnit)
+{
+	CHECK(Run("AddTrigger({'near-unit', 0, '>=', 2, 'unit-test-footman', 'unit-test-farm'}, Fired)"));
+	Make(*Farm, 1, Vec2i(10, 10));
+	Make(*Footman, 0, Vec2i(12, 10));
+	CUnit &far = Make(*Footman, 0, Vec2i(20, 20));
+	Make(*Footman, 1, Vec2i(9, 9));
+	Cycles(1);
+	CHECK_EQUAL(0, Fired());
+
+	Remove(far);
+	Place(far, Vec2i(11, 12));
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+
+	Remove(far);
+	Place(far, Vec2i(11, 13));
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+}
+
+TEST_FIXTURE(TriggerMapFixture, TriggerConditionTimerAndList)
+{
+	CHECK(Run("AddTrigger({{'timer', '>=', 50}, {'unit-types-count', 'any', 'unit-test-footman', '>', 0}}, Fired)"));
+	Cycles(1);
+	CHECK_EQUAL(0, Fired());
+
+	GameTimer.Init = true;
+	GameTimer.Cycles = 60;
+	Cycles(1);
+	CHECK_EQUAL(0, Fired());
+
+	Make(*Footman, 1, Vec2i(1, 1));
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+
+	GameTimer.Cycles = 40;
+	Cycles(1);
+	CHECK_EQUAL(1, Fired());
+}
+
+TEST_FIXTURE(TriggerMapFixture, TriggerBadConditions)
+{
+	CHECK(!Run("AddTrigger({'units-in-box', 0, 'unit-test-footman'}, Fired)"));
+	CHECK(!Run("AddTrigger({'timer', '=>', 50}, Fired)"));
+	CHECK(!Run("AddTrigger({'unit-types-count', 0, 'any', '>', 0}, Fired)"));
+	CHECK(!Run("AddTrigger({'units-at', 0, 'any', {0, 0}, '>', 0}, Fired)"));
+}
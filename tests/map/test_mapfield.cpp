@@ -0,0 +1,122 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_mapfield.cpp - The test file for mapfield.cpp. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include <string>
+
+#include "stratagus.h"
+#include "map.h"
+#include "tile.h"
+#include "tileset.h"
+#include "util.h"
+
+static const int Width = 5;
+static const int Height = 3;
+
+/**
+**  Fill fields with values which differ from field to field.
+*/
+static void FillFields(CMapField *fields)
+{
+	for (int i = 0; i != Width * Height; ++i) {
+		CMapField &mf = fields[i];
+
+		mf.setGraphicTile(100 + 7 * i);
+		mf.playerInfo.SeenTile = 300 + 3 * i;
+		mf.Flags = (i & 1 ? MapFieldLandAllowed : MapFieldWaterAllowed) | (i % 3 ? MapFieldForest : 0);
+		mf.Value = i * 11;
+		mf.playerInfo.Visible[i % PlayerMax] = 1;
+		mf.playerInfo.Visible[(i + 5) % PlayerMax] = 2;
+	}
+}
+
+TEST(MAPFIELD_PLANES_ROUNDTRIP)
+{
+	CMapField saved[Width * Height];
+	CMapField loaded[Width * Height];
+	std::string data;
+
+	FillFields(saved);
+	CMapField::SavePlanes(saved, Width, Height, data);
+
+	std::string decoded;
+	CHECK(DecodeBase64(EncodeBase64(data), decoded));
+	CHECK(decoded == data);
+	CHECK(CMapField::ParsePlanes(loaded, Width, Height, decoded));
+
+	for (int i = 0; i != Width * Height; ++i) {
+		CHECK_EQUAL(saved[i].getGraphicTile(), loaded[i].getGraphicTile());
+		CHECK_EQUAL(saved[i].playerInfo.SeenTile, loaded[i].playerInfo.SeenTile);
+		CHECK_EQUAL(saved[i].Flags, loaded[i].Flags);
+		CHECK_EQUAL(saved[i].Value, loaded[i].Value);
+		CHECK_EQUAL(saved[i].getCost(), loaded[i].getCost());
+		for (int p = 0; p != PlayerMax; ++p) {
+			// Only explored is kept, the units mark what they see when placed.
+			CHECK_EQUAL(saved[i].playerInfo.Visible[p] == 1 ? 1 : 0, loaded[i].playerInfo.Visible[p]);
+		}
+	}
+
+	// Saving the loaded fields gives the same planes.
+	std::string again;
+	CMapField::SavePlanes(loaded, Width, Height, again);
+	CHECK(again == data);
+}
+
+TEST(MAPFIELD_PLANES_COST)
+{
+	CMapField saved[Width * Height];
+	CMapField loaded[Width * Height];
+	std::string data;
+
+	FillFields(saved);
+	CMapField::SavePlanes(saved, Width, Height, data);
+	// The cost plane follows the header, tiles, seen tiles, flags and values.
+	const size_t cost = 8 + Width * Height * 7;
+	for (int i = 0; i != Width * Height; ++i) {
+		data[cost + i] = char(i + 1);
+	}
+	CHECK(CMapField::ParsePlanes(loaded, Width, Height, data));
+	for (int i = 0; i != Width * Height; ++i) {
+		CHECK_EQUAL(i + 1, loaded[i].getCost());
+	}
+	std::string again;
+	CMapField::SavePlanes(loaded, Width, Height, again);
+	CHECK(again == data);
+}
+
+TEST(MAPFIELD_PLANES_MISMATCH)
+{
+	CMapField fields[Width * Height];
+	std::string data;
+
+	CMapField::SavePlanes(fields, Width, Height, data);
+	CHECK(!CMapField::ParsePlanes(fields, Height, Width, data));
+	CHECK(!CMapField::ParsePlanes(fields, Width, Height, data.substr(0, data.size() - 1)));
+	data[3] = char(data[3] + 1);
+	CHECK(!CMapField::ParsePlanes(fields, Width, Height, data));
+}
@@ -29,9 +29,21 @@
 
 #include <UnitTest++.h>
 
+#include <map>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "stratagus.h"
 #include "network.h"
+#include "net_lowlevel.h"
 #include "net_message.h"
+#include "netconnect.h"
+#include "player.h"
+#include "video.h"
 
 void FillCustomValue(CNetworkCommand *obj)
 {
@@ -41,6 +53,17 @@ void FillCustomValue(CNetworkCommand *obj)
 	obj->Y = 0xDEF0;
 }
 
+void FillCustomValue(CNetworkGroupCommand *obj)
+{
+	obj->Type = 0x85;
+	obj->X = 0x0123;
+	obj->Y = 0x4567;
+	obj->Dest = 0xFFFF;
+	for (int i = 0; i != 10; ++i) {
+		obj->Units.push_back(0x0123 * i);
+	}
+}
+
 void FillCustomValue(CNetworkExtendedCommand *obj)
 {
 	obj->ExtendedType = 11;
@@ -63,6 +86,20 @@ void FillCustomValue(CNetworkCommandQuit *obj)
 {
 	obj->player = 0x0123;
 }
+void FillCustomValue(CNetworkCommandLag *obj)
+{
+	obj->player = 0x0123;
+	obj->lag = 0x4567;
+}
+void FillCustomValue(CNetworkSyncHashes *obj)
+{
+	obj->player = 0x0123;
+	obj->flags = SyncHashesRequest;
+	obj->cycle = 0x456789AB;
+	for (int i = 0; i != SyncHashCount; ++i) {
+		obj->hashes[i] = 0x01234567 * (i + 1);
+	}
+}
 void FillCustomValue(CNetworkSelection *obj)
 {
 	for (int i = 0; i != 10; ++i) {
@@ -94,6 +131,18 @@ bool Comp(const CNetworkSelection &lhs, const CNetworkSelection &rhs)
 	return lhs.Units == rhs.Units;
 }
 
+bool Comp(const CNetworkSyncHashes &lhs, const CNetworkSyncHashes &rhs)
+{
+	return lhs.player == rhs.player && lhs.flags == rhs.flags && lhs.cycle == rhs.cycle
+		   && memcmp(lhs.hashes, rhs.hashes, sizeof(lhs.hashes)) == 0;
+}
+
+bool Comp(const CNetworkGroupCommand &lhs, const CNetworkGroupCommand &rhs)
+{
+	return lhs.Type == rhs.Type && lhs.X == rhs.X && lhs.Y == rhs.Y
+		   && lhs.Dest == rhs.Dest && lhs.Units == rhs.Units;
+}
+
 
 template <typename T>
 bool CheckSerialization()
@@ -115,6 +164,23 @@ TEST(CNetworkCommand)
 {
 	CHECK(CheckSerialization<CNetworkCommand>());
 }
+TEST(CNetworkGroupCommand)
+{
+	CHECK(CheckSerialization<CNetworkGroupCommand>());
+}
+TEST(CNetworkGroupCommand_Size)
+{
+	CNetworkGroupCommand obj;
+
+	obj.Type = MessageCommandMove;
+	obj.X = 100;
+	obj.Y = 100;
+	obj.Dest = 0xFFFF;
+	for (int i = 0; i != 50; ++i) {
+		obj.Units.push_back(1000 + 2 * i);
+	}
+	CHECK(obj.Size() < 64);
+}
 TEST(CNetworkExtendedCommand)
 {
 	CHECK(CheckSerialization<CNetworkExtendedCommand>());
@@ -131,6 +197,27 @@ TEST(CNetworkCommandQuit)
 {
 	CHECK(CheckSerialization<CNetworkCommandQuit>());
 }
+TEST(CNetworkCommandLag)
+{
+	CHECK(CheckSerialization<CNetworkCommandLag>());
+}
+TEST(CNetworkSyncHashes)
+{
+	CHECK(CheckSerialization<CNetworkSyncHashes>());
+}
+TEST(CSyncHashes_Differences)
+{
+	CSyncHashes lhs;
+	CSyncHashes rhs;
+	CSyncHasher hasher;
+
+	hasher.Add(42);
+	CHECK(hasher.Hash != CSyncHasher().Hash);
+	CHECK_EQUAL(0u, lhs.Differences(rhs));
+	rhs.Hash[SyncHashMissiles] = hasher.Hash;
+	rhs.Hash[SyncHashRandom] = 1;
+	CHECK_EQUAL((1u << SyncHashMissiles) | (1u << SyncHashRandom), lhs.Differences(rhs));
+}
 TEST(CNetworkSelection)
 {
 	CHECK(CheckSerialization<CNetworkSelection>());
@@ -139,5 +226,265 @@ TEST(CNetworkPacketHeader)
 {
 	CHECK(CheckSerialization<CNetworkPacketHeader>());
 }
+
+TEST(CNetworkLagEstimator)
+{
+	CNetworkLagEstimator estimator;
+
+	for (int i = 0; i != CNetworkLagEstimator::MinSamples; ++i) {
+		CHECK(!estimator.IsValid());
+		estimator.AddSample(100);
+	}
+	CHECK(estimator.IsValid());
+	CHECK_EQUAL(100, estimator.Delay >> 3);
+	CHECK_EQUAL(4u, estimator.NeededLag(33, 1));
+	CHECK_EQUAL(6u, estimator.NeededLag(33, 3));
+}
+
+TEST(NetworkLagToReport)
+{
+	CNetworkLagEstimator lan;
+	CNetworkLagEstimator wan;
+	CNetworkLagEstimator unknown;
+	std::vector<const CNetworkLagEstimator *> estimators;
+
+	for (int i = 0; i != CNetworkLagEstimator::MinSamples; ++i) {
+		lan.AddSample(2);
+		wan.AddSample(100);
+	}
+	unknown.AddSample(1000);
+	CHECK_EQUAL(0u, NetworkLagToReport(estimators, 33, 1));
+	estimators.push_back(&unknown);
+	CHECK_EQUAL(0u, NetworkLagToReport(estimators, 33, 1));
+	estimators.push_back(&lan);
+	CHECK_EQUAL(lan.NeededLag(33, 1), NetworkLagToReport(estimators, 33, 1));
+	estimators.push_back(&wan);
+	CHECK_EQUAL(wan.NeededLag(33, 1), NetworkLagToReport(estimators, 33, 1));
+	CHECK_EQUAL(CNetworkLagEstimator::MaxLag, NetworkLagToReport(estimators, 1, 1));
+}
+
+TEST(NetworkAdaptedLag_Grows)
+{
+	std::vector<unsigned int> reports;
+
+	reports.push_back(3);
+	reports.push_back(12);
+	CHECK_EQUAL(12u, NetworkAdaptedLag(4, reports, 1));
+	reports.push_back(500);
+	CHECK_EQUAL(CNetworkLagEstimator::MaxLag, NetworkAdaptedLag(4, reports, 1));
+	CHECK_EQUAL(117u, NetworkAdaptedLag(4, reports, 9));
+}
+
+TEST(NetworkAdaptedLag_Shrinks)
+{
+	std::vector<unsigned int> reports;
+	unsigned int lag = 10;
+
+	reports.push_back(0);
+	reports.push_back(3);
+	lag = NetworkAdaptedLag(lag, reports, 1);
+	CHECK_EQUAL(9u, lag);
+	while (lag > 3) {
+		lag = NetworkAdaptedLag(lag, reports, 1);
+	}
+	CHECK_EQUAL(3u, lag);
+	reports[1] = 0;
+	CHECK_EQUAL(2u, NetworkAdaptedLag(lag, reports, 1));
+	CHECK_EQUAL(2u, NetworkAdaptedLag(2, reports, 1));
+	CHECK_EQUAL(8u, NetworkAdaptedLag(12, reports, 4));
+	CHECK_EQUAL(8u, NetworkAdaptedLag(8, reports, 4));
+}
+
+#ifndef WIN32
+
+/**
+**  Two players in lockstep, each in its own process with the real
+**  network code, over a loopback link with delay and jitter.
+**
+**  Each player runs the frames of the game loop: a game cycle when it is
+**  in sync, a stall otherwise. The packets go through a relay in the test
+**  process, which delays them.
+*/
+class CLoopbackGame
+{
+public:
+	CLoopbackGame(unsigned int lag, bool adapt) : Stalls(0), LagSum(0), Cycles(0), Lag(lag), Adapt(adapt) {}
+
+	/// Play cycles game cycles, the delay changes to changedDelay after changeTime ms
+	void Run(int cycles, int delay, int jitter, unsigned long changeTime = 0, int changedDelay = 0)
+	{
+		NetInit();
+		CUDPSocket relays[2];
+		int pipes[2][2];
+		pid_t pids[2];
+
+		for (int p = 0; p != 2; ++p) {
+			relays[p].Open(CHost("127.0.0.1", RelayPort + p));
+			if (pipe(pipes[p]) || (pids[p] = fork()) < 0) {
+				return;
+			}
+			if (pids[p] == 0) {
+				Play(p, cycles, pipes[p][1]);
+			}
+			close(pipes[p][1]);
+		}
+
+		// Relay the packets until both players are done.
+		std::multimap<unsigned long, std::pair<int, std::vector<unsigned char> > > packets;
+		const unsigned long start = GetTicks();
+		unsigned long seed = 42;
+		int done = 0;
+		while (done != 2) {
+			for (int p = 0; p != 2; ++p) {
+				unsigned char buf[MaxNetworkPacketSize];
+				CHost from;
+
+				while (relays[p].HasDataToRead(0) > 0) {
+					const int len = relays[p].Recv(buf, sizeof(buf), &from);
+					const unsigned long now = GetTicks();
+					const int linkDelay = changeTime && now - start >= changeTime ? changedDelay : delay;
+
+					seed = seed * 1103515245 + 12345;
+					const int linkJitter = jitter ? int((seed >> 16) % (2 * jitter + 1)) - jitter : 0;
+					if (len > 0) {
+						packets.insert(std::make_pair(now + std::max(linkDelay + linkJitter, 0),
+													  std::make_pair(1 - p, std::vector<unsigned char>(buf, buf + len))));
+					}
+				}
+			}
+			const unsigned long now = GetTicks();
+			while (!packets.empty() && packets.begin()->first <= now) {
+				const int to = packets.begin()->second.first;
+				const std::vector<unsigned char> &packet = packets.begin()->second.second;
+
+				relays[to].Send(CHost("127.0.0.1", PlayerPort + to), &packet[0], packet.size());
+				packets.erase(packets.begin());
+			}
+			for (int p = 0; p != 2; ++p) {
+				int status;
+				if (pids[p] && waitpid(pids[p], &status, WNOHANG) == pids[p]) {
+					pids[p] = 0;
+					++done;
+				}
+			}
+			usleep(200);
+		}
+		for (int p = 0; p != 2; ++p) {
+			Result result;
+			if (read(pipes[p][0], &result, sizeof(result)) == int(sizeof(result))) {
+				Stalls += result.Stalls;
+				LagSum += result.LagSum;
+				Cycles += result.Cycles;
+			}
+			close(pipes[p][0]);
+			relays[p].Close();
+		}
+		NetExit();
+	}
+	double AverageLag() const { return Cycles ? double(LagSum) / Cycles : 0; }
+
+	unsigned long Stalls;  /// Frames the players waited for packets
+	unsigned long LagSum;  /// Sum of the lags of the game cycles
+	unsigned long Cycles;  /// Game cycles played
+
+private:
+	/// Results of a player
+	struct Result {
+		unsigned long Stalls;
+		unsigned long LagSum;
+		unsigned long Cycles;
+	};
+
+	/// Play as player in the child process, write the result to fd.
+	void Play(int player, int cycles, int fd)
+	{
+		CNetworkParameter::Instance.gameCyclesPerUpdate = 1;
+		CNetworkParameter::Instance.NetworkLag = Lag;
+		VideoSyncSpeed = 100 * 33 / MsPerFrame;
+		NetworkFildes.Open(CHost("127.0.0.1", PlayerPort + player));
+		NetConnectType = 2; // Send everything to the relay
+		NumPlayers = 2;
+		for (int i = 0; i != PlayerMax; ++i) {
+			Players[i].Index = i;
+		}
+		ThisPlayer = &Players[player];
+		HostsCount = 1;
+		Hosts[0].Host = CHost("127.0.0.1", RelayPort + player).getIp();
+		Hosts[0].Port = CHost("127.0.0.1", RelayPort + player).getPort();
+		Hosts[0].PlyNr = 1 - player;
+		GameCycle = 0;
+		NetworkOnStartGame();
+
+		Result result = {0, 0, 0};
+		// Keep answering the other player a while after the last cycle.
+		int tail = 1000 / MsPerFrame;
+		for (int frame = 0; frame != 4 * cycles && tail; ++frame) {
+			const unsigned long frameEnd = GetTicks() + MsPerFrame;
+
+			if (GameCycle < (unsigned long)cycles) {
+				if (NetworkInSync) {
+					++GameCycle;
+					NetworkCommands();
+					if (!Adapt) {
+						CNetworkParameter::Instance.NetworkLag = Lag;
+					}
+					result.LagSum += CNetworkParameter::Instance.NetworkLag;
+					++result.Cycles;
+				} else {
+					++result.Stalls;
+				}
+			} else {
+				--tail;
+			}
+			for (unsigned long now = GetTicks(); now < frameEnd; now = GetTicks()) {
+				if (NetworkFildes.HasDataToRead(frameEnd - now) > 0) {
+					NetworkEvent();
+				}
+			}
+			++FrameCounter;
+			if (!NetworkInSync) {
+				NetworkRecover();
+			}
+		}
+		if (write(fd, &result, sizeof(result)) != int(sizeof(result))) {
+			_exit(1);
+		}
+		_exit(0);
+	}
+
+	static const int MsPerFrame = 5;    /// Length of a frame, one game cycle
+	static const int PlayerPort = 6610;
+	static const int RelayPort = 6612;
+	unsigned int Lag;  /// Lag at the start of the game
+	bool Adapt;        /// Adapt the lag, or keep it as before the lag reports
+};
+
+TEST(NetworkLoopbackLan)
+{
+	CLoopbackGame adaptive(10, true);
+	CLoopbackGame fixed(10, false);
+
+	adaptive.Run(600, 2, 1);
+	fixed.Run(600, 2, 1);
+	CHECK_EQUAL(1200ul, adaptive.Cycles);
+	CHECK_EQUAL(1200ul, fixed.Cycles);
+	CHECK(adaptive.AverageLag() < fixed.AverageLag() / 2);
+	CHECK(adaptive.Stalls <= fixed.Stalls + 10);
+}
+
+TEST(NetworkLoopbackChangingLink)
+{
+	CLoopbackGame adaptive(10, true);
+	CLoopbackGame fixed(10, false);
+
+	adaptive.Run(600, 10, 3, 1500, 80);
+	fixed.Run(600, 10, 3, 1500, 80);
+	CHECK_EQUAL(1200ul, adaptive.Cycles);
+	CHECK_EQUAL(1200ul, fixed.Cycles);
+	CHECK(3 * adaptive.Stalls < 2 * fixed.Stalls);
+}
+
+#endif
+
 //TEST(CNetworkPacket)
 
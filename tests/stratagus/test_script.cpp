@@ -0,0 +1,183 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_script.cpp - The test file for script.cpp. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <UnitTest++.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "stratagus.h"
+#include "script.h"
+#include "trigger.h"
+#include "unit.h"
+#include "unittype.h"
+#include "util.h"
+
+/**
+**  Parse a number description written with the script aliases.
+**
+**  @param number   Lua expression of the number description.
+**  @param compile  Compile it as CclParseNumberDesc does.
+*/
+static NumberDesc *ParseNumber(const char *number, bool compile)
+{
+	if (!Lua) {
+		InitLua();
+		ScriptRegister();
+	}
+	const std::string chunk = std::string("return ") + number;
+
+	if (luaL_loadstring(Lua, chunk.c_str()) || lua_pcall(Lua, 0, 1, 0)) {
+		lua_pop(Lua, 1);
+		return NULL;
+	}
+	return compile ? CclParseNumberDesc(Lua) : ParseNumberDesc(Lua);
+}
+
+/**
+**  Evaluate a number description several times from the first SyncRand
+**  seed, the last value is the seed left behind.
+*/
+static std::vector<int> Evaluate(const NumberDesc &number, int count)
+{
+	std::vector<int> values;
+
+	InitSyncRand();
+	for (int i = 0; i != count; ++i) {
+		values.push_back(EvalNumber(&number));
+	}
+	values.push_back(SyncRandSeed);
+	return values;
+}
+
+/**
+**  A number description parsed and compiled.
+*/
+class NumberFixture
+{
+public:
+	NumberFixture() : Tree(NULL), Compiled(NULL) {}
+	void Parse(const char *number)
+	{
+		Tree = ParseNumber(number, false);
+		Compiled = ParseNumber(number, true);
+	}
+	~NumberFixture()
+	{
+		if (Tree) {
+			FreeNumberDesc(Tree);
+			delete Tree;
+		}
+		if (Compiled) {
+			FreeNumberDesc(Compiled);
+			delete Compiled;
+		}
+	}
+
+	NumberDesc *Tree;      /// Number description as parsed
+	NumberDesc *Compiled;  /// Number description as compiled
+};
+
+TEST_FIXTURE(NumberFixture, NumberDescConstantFolding)
+{
+	Parse("Add(2, Mul(3, Sub(7, Div(8, 2))))");
+	CHECK_EQUAL(ENumber_Dir, Compiled->e);
+	CHECK_EQUAL(11, EvalNumber(Compiled));
+	CHECK_EQUAL(11, EvalNumber(Tree));
+}
+
+TEST_FIXTURE(NumberFixture, NumberDescRandOrder)
+{
+	// The draws of the operands must stay left to right.
+	Parse("Sub(Rand(100), Add(Mul(Rand(7), Rand(1000)), Div(Rand(50), 3)))");
+	CHECK_EQUAL(ENumber_Program, Compiled->e);
+	CHECK(Evaluate(*Tree, 50) == Evaluate(*Compiled, 50));
+}
+
+TEST_FIXTURE(NumberFixture, NumberDescNumIf)
+{
+	Parse("NumIf(GreaterThan(Rand(4), 1), Add(10, Rand(5)), Mul(Rand(3), 100))");
+	CHECK_EQUAL(ENumber_Program, Compiled->e);
+	CHECK(Evaluate(*Tree, 50) == Evaluate(*Compiled, 50));
+}
+
+TEST_FIXTURE(NumberFixture, NumberDescNumIfWithoutElse)
+{
+	Parse("NumIf(GreaterThan(Rand(4), 1), Add(10, Rand(5)))");
+	CHECK_EQUAL(ENumber_Program, Compiled->e);
+	const std::vector<int> values = Evaluate(*Compiled, 50);
+	CHECK(Evaluate(*Tree, 50) == values);
+	CHECK(std::find(values.begin(), values.end() - 1, 0) != values.end() - 1);
+}
+
+TEST_FIXTURE(NumberFixture, NumberDescConstantNumIfWithoutElse)
+{
+	Parse("NumIf(Equal(1, 2), 5)");
+	CHECK_EQUAL(ENumber_Dir, Compiled->e);
+	CHECK_EQUAL(0, EvalNumber(Compiled));
+	CHECK_EQUAL(0, EvalNumber(Tree));
+}
+
+TEST_FIXTURE(NumberFixture, NumberDescTooDeep)
+{
+	// Deeper than the stack of the program, stays interpreted.
+	std::string number = "1";
+	for (int i = 0; i != 40; ++i) {
+		number = "Add(Rand(3), " + number + ")";
+	}
+	Parse(number.c_str());
+	CHECK(Compiled->e != ENumber_Program);
+	CHECK(Evaluate(*Tree, 20) == Evaluate(*Compiled, 20));
+}
+
+TEST_FIXTURE(NumberFixture, NumberDescDamageFormula)
+{
+	Parse("Div(Mul(Add(51, Rand(50)),"
+		  " Add(Max(0, Sub(AttackerVar(\"BasicDamage\"), DefenderVar(\"Armor\"))),"
+		  " AttackerVar(\"PiercingDamage\"))), 100)");
+	CHECK_EQUAL(ENumber_Program, Compiled->e);
+
+	CUnit attacker;
+	CUnit defender;
+	attacker.Variable = new CVariable[UnitTypeVar.GetNumberVariable()];
+	defender.Variable = new CVariable[UnitTypeVar.GetNumberVariable()];
+	attacker.Variable[BASICDAMAGE_INDEX].Value = 9;
+	attacker.Variable[PIERCINGDAMAGE_INDEX].Value = 6;
+	defender.Variable[ARMOR_INDEX].Value = 2;
+	TriggerData.Attacker = &attacker;
+	TriggerData.Defender = &defender;
+
+	CHECK(Evaluate(*Tree, 50) == Evaluate(*Compiled, 50));
+	defender.Variable[ARMOR_INDEX].Value = 20;
+	CHECK(Evaluate(*Tree, 50) == Evaluate(*Compiled, 50));
+
+	TriggerData.Attacker = NULL;
+	TriggerData.Defender = NULL;
+	delete[] attacker.Variable;
+	delete[] defender.Variable;
+}
@@ -116,6 +116,32 @@ TEST(STRNLEN)
 	CHECK_EQUAL(5u, strnlen("hello", 10));
 }
 
+TEST(ENCODE_BASE64)
+{
+	CHECK_EQUAL("", EncodeBase64(""));
+	CHECK_EQUAL("Zg==", EncodeBase64("f"));
+	CHECK_EQUAL("Zm8=", EncodeBase64("fo"));
+	CHECK_EQUAL("Zm9v", EncodeBase64("foo"));
+	CHECK_EQUAL("Zm9vYmFy", EncodeBase64("foobar"));
+}
+
+TEST(DECODE_BASE64)
+{
+	std::string data;
+
+	CHECK(DecodeBase64("Zm9v\nYmE=", data));
+	CHECK_EQUAL("fooba", data);
+	CHECK(!DecodeBase64("Zm9v*", data));
+	CHECK(!DecodeBase64("Zg==Zg==", data));
+
+	std::string binary;
+	for (int i = 0; i != 256; ++i) {
+		binary += (char)i;
+	}
+	CHECK(DecodeBase64(EncodeBase64(binary), data));
+	CHECK(binary == data);
+}
+
 // TODO: int getopt(int argc, char *const argv[], const char *optstring);
 // TODO: int GetClipboard(std::string &str);
 // TODO: int UTF8GetNext(const std::string &text, int curpos);
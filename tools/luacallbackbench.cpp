@@ -0,0 +1,270 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//   Utility for Stratagus - A free fantasy real time strategy game engine
+//
+/**@name luacallbackbench.cpp - Measure the cost of the Lua callbacks. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+   Calls a Lua function for many units during many cycles, the way the
+   unit actions call OnEachCycle, and prints the time needed per unit:
+
+   - "lookup": the function is looked up by name and called like LuaCall
+     does, with a new traceback function each call.
+   - "callback": one LuaCallback call per unit, like OnEachCycle.
+   - "batch": one LuaCallback call per cycle with a table of all the unit
+     slots, like OnEachCycleBatch.
+
+   Before that, it checks that callbacks with results and callbacks
+   raising errors leave the Lua stack balanced.
+
+   Built with ENABLE_BENCHMARKS, add WITH_LUAJIT to measure LuaJIT
+   instead of Lua 5.1.
+
+   Usage: luacallbackbench [-u units] [-c cycles]
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "stratagus.h"
+#include "luacallback.h"
+#include "script.h"
+
+#if 1 // from stratagus.cpp, to avoid link issues.
+
+bool EnableDebugPrint;           /// if enabled, print the debug messages
+bool EnableAssert;               /// if enabled, halt on assertion failures
+
+void PrintLocation(const char *file, int line, const char *funcName)
+{
+	fprintf(stdout, "%s:%d: %s: ", file, line, funcName);
+}
+
+void AbortAt(const char *file, int line, const char *funcName, const char *conditionStr)
+{
+	fprintf(stderr, "Assertion failed at %s:%d: %s: %s\n", file, line, funcName, conditionStr);
+	abort();
+}
+
+void PrintOnStdOut(const char *format, ...)
+{
+	va_list valist;
+	va_start(valist, format);
+	vprintf(format, valist);
+	va_end(valist);
+}
+
+#endif
+
+/// Callbacks of the benchmark, they sum the slots to do a little work
+static const char BenchScript[] =
+	"Sum = 0\n"
+	"function OnUnit(slot) Sum = Sum + slot end\n"
+	"function OnUnits(slots) local sum = Sum for i = 1, #slots do sum = sum + slots[i] end Sum = sum end\n"
+	"function OnNext(slot) return slot + 1 end\n"
+	"function OnError(slot) error(\"expected error of the slot \" .. slot) end\n";
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+			"Usage: %s [-u units] [-c cycles]\n"
+			"\t-u units\tNumber of units with a callback (default 500)\n"
+			"\t-c cycles\tNumber of game cycles (default 2000)\n", name);
+	exit(2);
+}
+
+/// Stands in for the traceback function of LuaCall
+static int ErrorHandler(lua_State *)
+{
+	return 1;
+}
+
+/**
+**  Call the callback of each unit as LuaCall does.
+*/
+static void RunLookup(lua_State *l, int units, int cycles)
+{
+	for (int cycle = 0; cycle != cycles; ++cycle) {
+		for (int slot = 0; slot != units; ++slot) {
+			const int base = lua_gettop(l);
+
+			lua_pushcfunction(l, ErrorHandler);
+			lua_getglobal(l, "OnUnit");
+			lua_pushnumber(l, slot);
+			lua_pcall(l, 1, 0, base + 1);
+			lua_remove(l, base + 1);
+		}
+	}
+}
+
+/**
+**  Call the callback of each unit with a LuaCallback.
+*/
+static void RunCallback(LuaCallback &callback, int units, int cycles)
+{
+	for (int cycle = 0; cycle != cycles; ++cycle) {
+		for (int slot = 0; slot != units; ++slot) {
+			callback.pushPreamble();
+			callback.pushInteger(slot);
+			callback.run();
+		}
+	}
+}
+
+/**
+**  Call the callback once each cycle with the slots of all units.
+*/
+static void RunBatch(LuaCallback &callback, int units, int cycles)
+{
+	std::vector<int> slots;
+
+	for (int cycle = 0; cycle != cycles; ++cycle) {
+		slots.clear();
+		for (int slot = 0; slot != units; ++slot) {
+			slots.push_back(slot);
+		}
+		callback.pushPreamble();
+		callback.pushIntegers(slots);
+		callback.run();
+	}
+}
+
+/**
+**  Check the stack after a callback with a result and after one raising
+**  an error, the error is printed with its traceback.
+*/
+static bool CheckCallbacks(lua_State *l)
+{
+	bool ok = true;
+
+	lua_getglobal(l, "OnNext");
+	LuaCallback onNext(l, -1);
+	lua_pop(l, 1);
+	onNext.pushPreamble();
+	onNext.pushInteger(41);
+	onNext.run(1);
+	if (onNext.popInteger() != 42 || lua_gettop(l) != 0) {
+		fprintf(stderr, "OnNext: wrong result or %d values left on the Lua stack\n", lua_gettop(l));
+		ok = false;
+	}
+
+	lua_getglobal(l, "OnError");
+	LuaCallback onError(l, -1);
+	lua_pop(l, 1);
+	for (int i = 0; i != 2; ++i) {
+		onError.pushPreamble();
+		onError.pushInteger(i);
+		onError.run();
+	}
+	if (lua_gettop(l) != 0) {
+		fprintf(stderr, "OnError: %d values left on the Lua stack\n", lua_gettop(l));
+		ok = false;
+	}
+	return ok;
+}
+
+/**
+**  Print the time of a run and check that it left the stack and the sum
+**  as expected.
+*/
+static bool Report(lua_State *l, const char *name, clock_t start, int units, int cycles)
+{
+	const double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+	const double calls = double(units) * cycles;
+	const double expected = double(units) * (units - 1) / 2 * cycles;
+	bool ok = true;
+
+	lua_getglobal(l, "Sum");
+	if (lua_tonumber(l, -1) != expected) {
+		fprintf(stderr, "%s: the callback was not called for each unit\n", name);
+		ok = false;
+	}
+	lua_pop(l, 1);
+	if (lua_gettop(l) != 0) {
+		fprintf(stderr, "%s: %d values left on the Lua stack\n", name, lua_gettop(l));
+		ok = false;
+	}
+	lua_pushnumber(l, 0);
+	lua_setglobal(l, "Sum");
+
+	printf("%-8s %8.3f s %8.1f ns/unit\n", name, seconds, seconds * 1e9 / calls);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	int units = 500;
+	int cycles = 2000;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-u") && i + 1 < argc) {
+			units = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+			cycles = atoi(argv[++i]);
+		} else {
+			Usage(argv[0]);
+		}
+	}
+	if (units < 1 || cycles < 1) {
+		Usage(argv[0]);
+	}
+
+	lua_State *l = luaL_newstate();
+	luaL_openlibs(l);
+	if (luaL_dostring(l, BenchScript)) {
+		fprintf(stderr, "%s\n", lua_tostring(l, -1));
+		return 2;
+	}
+
+	lua_getglobal(l, "OnUnit");
+	LuaCallback *onUnit = new LuaCallback(l, -1);
+	lua_pop(l, 1);
+	lua_getglobal(l, "OnUnits");
+	LuaCallback *onUnits = new LuaCallback(l, -1);
+	lua_pop(l, 1);
+
+	printf("%s, %d units, %d cycles\n", LUA_VERSION, units, cycles);
+	bool ok = CheckCallbacks(l);
+	clock_t start = clock();
+	RunLookup(l, units, cycles);
+	ok &= Report(l, "lookup", start, units, cycles);
+	start = clock();
+	RunCallback(*onUnit, units, cycles);
+	ok &= Report(l, "callback", start, units, cycles);
+	start = clock();
+	RunBatch(*onUnits, units, cycles);
+	ok &= Report(l, "batch", start, units, cycles);
+
+	delete onUnit;
+	delete onUnits;
+	lua_close(l);
+	return ok ? 0 : 1;
+}
+
+//@}
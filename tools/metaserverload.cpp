@@ -0,0 +1,291 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//   Utility for Stratagus - A free fantasy real time strategy game engine
+//
+/**@name metaserverload.cpp - Load generator for the metaserver. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+   Opens many lobby connections to a metaserver, sends a PING on each
+   connection at a fixed rate and measures the time until the PING_OK.
+
+   Usage: metaserverload [-c clients] [-r rate] [-d seconds] [host[:port]]
+
+   The server needs enough connections, e.g. "metaserver -m 10000", and
+   both processes enough file descriptors (ulimit -n).
+*/
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/// A lobby connection
+struct LoadClient {
+	LoadClient() : Fd(-1), Connected(false), Waiting(false), SentAt(0) {}
+
+	int Fd;              /// Socket
+	bool Connected;      /// The connection is established
+	bool Waiting;        /// A PING has no answer yet
+	double SentAt;       /// Time the PING was sent
+	std::string Input;   /// Received, not yet parsed data
+};
+
+static std::vector<LoadClient> Clients;
+static std::vector<double> Latencies;  /// Time until each answer in s
+static unsigned long Errors;           /// Failed connections and requests
+static unsigned long Skipped;          /// PINGs not sent, the last had no answer
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+			"Usage: %s [-c clients] [-r rate] [-d seconds] [host[:port]]\n"
+			"\t-c clients\tNumber of lobby connections (default 10000)\n"
+			"\t-r rate\t\tPINGs per second on each connection (default 1)\n"
+			"\t-d seconds\tDuration of the test (default 10)\n"
+			"\thost:port\tMetaserver (default 127.0.0.1:7775)\n", name);
+	exit(2);
+}
+
+static double Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void CloseClient(LoadClient &client)
+{
+	if (client.Fd != -1) {
+		close(client.Fd);
+		client.Fd = -1;
+	}
+	client.Connected = false;
+	client.Waiting = false;
+	++Errors;
+}
+
+static void SendPing(LoadClient &client, double now)
+{
+	if (!client.Connected) {
+		return;
+	}
+	if (client.Waiting) {
+		++Skipped;
+		return;
+	}
+	if (send(client.Fd, "PING\n", 5, MSG_NOSIGNAL) != 5) {
+		CloseClient(client);
+		return;
+	}
+	client.Waiting = true;
+	client.SentAt = now;
+}
+
+static void ReadClient(LoadClient &client, double now)
+{
+	char buf[1024];
+	const ssize_t n = recv(client.Fd, buf, sizeof(buf), 0);
+
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return;
+	}
+	if (n <= 0) {
+		CloseClient(client);
+		return;
+	}
+	client.Input.append(buf, n);
+	size_t pos;
+	while ((pos = client.Input.find('\n')) != std::string::npos) {
+		const std::string line = client.Input.substr(0, pos);
+		client.Input.erase(0, pos + 1);
+		if (line == "PING_OK" && client.Waiting) {
+			client.Waiting = false;
+			Latencies.push_back(now - client.SentAt);
+		} else {
+			fprintf(stderr, "Unexpected answer: %s\n", line.c_str());
+			CloseClient(client);
+			return;
+		}
+	}
+}
+
+static double Percentile(const std::vector<double> &sorted, double p)
+{
+	if (sorted.empty()) {
+		return 0;
+	}
+	return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+int main(int argc, char **argv)
+{
+	int clients = 10000;
+	double rate = 1;
+	double duration = 10;
+	std::string host = "127.0.0.1";
+	int port = 7775;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+			clients = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else if (argv[i][0] == '-') {
+			Usage(argv[0]);
+		} else {
+			host = argv[i];
+			const size_t sep = host.find(':');
+			if (sep != std::string::npos) {
+				port = atoi(host.c_str() + sep + 1);
+				host.resize(sep);
+			}
+		}
+	}
+	if (clients < 1 || rate <= 0 || duration <= 0) {
+		Usage(argv[0]);
+	}
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	struct hostent *he = gethostbyname(host.c_str());
+	if (!he) {
+		fprintf(stderr, "%s: unknown host %s\n", argv[0], host.c_str());
+		return 2;
+	}
+	memcpy(&addr.sin_addr, he->h_addr, sizeof(addr.sin_addr));
+
+	const int epfd = epoll_create(1);
+	Clients.resize(clients);
+
+	// Connect all clients, then wait until the connections are established.
+	int pending = 0;
+	for (int i = 0; i != clients; ++i) {
+		LoadClient &client = Clients[i];
+		client.Fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (client.Fd == -1) {
+			perror("socket");
+			CloseClient(client);
+			continue;
+		}
+		fcntl(client.Fd, F_SETFL, fcntl(client.Fd, F_GETFL, 0) | O_NONBLOCK);
+		if (connect(client.Fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 && errno != EINPROGRESS) {
+			CloseClient(client);
+			continue;
+		}
+		struct epoll_event event;
+		event.events = EPOLLIN | EPOLLOUT;
+		event.data.u32 = i;
+		epoll_ctl(epfd, EPOLL_CTL_ADD, client.Fd, &event);
+		++pending;
+	}
+	const double connectStart = Now();
+	std::vector<struct epoll_event> events(1024);
+	while (pending && Now() - connectStart < 30) {
+		const int n = epoll_wait(epfd, &events[0], events.size(), 100);
+		for (int i = 0; i < n; ++i) {
+			LoadClient &client = Clients[events[i].data.u32];
+			if (client.Connected || client.Fd == -1) {
+				continue;
+			}
+			--pending;
+			int error = 0;
+			socklen_t len = sizeof(error);
+			getsockopt(client.Fd, SOL_SOCKET, SO_ERROR, &error, &len);
+			if (error || (events[i].events & (EPOLLERR | EPOLLHUP))) {
+				CloseClient(client);
+				continue;
+			}
+			client.Connected = true;
+			struct epoll_event event;
+			event.events = EPOLLIN;
+			event.data.u32 = events[i].data.u32;
+			epoll_ctl(epfd, EPOLL_CTL_MOD, client.Fd, &event);
+		}
+	}
+	int connected = 0;
+	for (int i = 0; i != clients; ++i) {
+		connected += Clients[i].Connected;
+	}
+	printf("%d of %d clients connected in %.2f s\n", connected, clients, Now() - connectStart);
+	fflush(stdout);
+
+	// Send the PINGs of the clients evenly spread over each period.
+	const double interval = 1 / (rate * clients);
+	const double start = Now();
+	unsigned long sent = 0;
+	for (;;) {
+		const double now = Now();
+		if (now - start >= duration) {
+			break;
+		}
+		while (start + sent * interval <= now) {
+			SendPing(Clients[sent % clients], now);
+			++sent;
+		}
+		const int n = epoll_wait(epfd, &events[0], events.size(), 1);
+		const double received = Now();
+		for (int i = 0; i < n; ++i) {
+			LoadClient &client = Clients[events[i].data.u32];
+			if (client.Fd != -1) {
+				ReadClient(client, received);
+			}
+		}
+	}
+
+	std::sort(Latencies.begin(), Latencies.end());
+	connected = 0;
+	for (int i = 0; i != clients; ++i) {
+		connected += Clients[i].Connected;
+	}
+	printf("%lu answers in %.0f s (%.0f/s), %lu not answered in time, %lu errors, %d clients still connected\n",
+		   (unsigned long)Latencies.size(), duration, Latencies.size() / duration, Skipped, Errors, connected);
+	printf("Response time: median %.3f ms, 99%% %.3f ms, 99.9%% %.3f ms, max %.3f ms\n",
+		   Percentile(Latencies, 0.5) * 1000, Percentile(Latencies, 0.99) * 1000,
+		   Percentile(Latencies, 0.999) * 1000, Latencies.empty() ? 0 : Latencies.back() * 1000);
+	for (int i = 0; i != clients; ++i) {
+		if (Clients[i].Fd != -1) {
+			close(Clients[i].Fd);
+		}
+	}
+	close(epfd);
+	return Errors || Skipped ? 1 : 0;
+}
+
+//@}
@@ -0,0 +1,396 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//   Utility for Stratagus - A free fantasy real time strategy game engine
+//
+/**@name netrelay.cpp - Relay the in-game packets of network games. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+   The host of a network game started with "stratagus -r relayhost[:port]"
+   tells the clients to send their in-game packets to the relay. Each
+   player sends its packets once, the relay forwards them to the other
+   players. The relay keeps the last packet of each player for each of the
+   256 cycle slots and answers the resend requests from these copies.
+
+   The game setup is still done with the host; the relay learns the address
+   of a player from its first in-game packet. The player stays bound to
+   this address until the end of the game, packets for the player from
+   other addresses are dropped. A game ends when no player sent anything
+   for the timeout.
+
+   With -l, the packets of each game are written to
+   logdir/relay-YYYYMMDD-HHMMSS.log: the bytes "SRL1", then for each packet
+   the game cycle (4 bytes), the player (1 byte), the size (2 bytes), all
+   big endian, and the packet as received.
+
+   Usage: netrelay [-p port] [-l logdir] [-t timeout]
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "stratagus.h"
+#include "net_lowlevel.h"
+#include "net_message.h"
+#include "network.h"
+
+#if 1 // from stratagus.cpp, to avoid link issues.
+
+bool EnableDebugPrint;           /// if enabled, print the debug messages
+bool EnableAssert;               /// if enabled, halt on assertion failures
+
+void PrintLocation(const char *file, int line, const char *funcName)
+{
+	fprintf(stdout, "%s:%d: %s: ", file, line, funcName);
+}
+
+void AbortAt(const char *file, int line, const char *funcName, const char *conditionStr)
+{
+	fprintf(stderr, "Assertion failed at %s:%d: %s: %s\n", file, line, funcName, conditionStr);
+	abort();
+}
+
+void PrintOnStdOut(const char *format, ...)
+{
+	va_list valist;
+	va_start(valist, format);
+	vprintf(format, valist);
+	va_end(valist);
+}
+
+#endif
+
+/// Offsets in the serialized CNetworkPacketHeader
+static const int PacketCycleOffset = MaxNetworkCommands;
+static const int PacketOrigPlayerOffset = MaxNetworkCommands + 1;
+
+/// A player of the relayed game
+class CRelayPlayer
+{
+public:
+	CRelayPlayer() { Clear(); }
+
+	void Clear()
+	{
+		Host = CHost();
+		LastReceived = 0;
+		for (int i = 0; i != 256; ++i) {
+			Cycles[i] = -1;
+			Packets[i].clear();
+			Waiting[i] = 0;
+		}
+	}
+
+public:
+	CHost Host;                              /// Address, not valid before the first packet
+	time_t LastReceived;                     /// Time of the last packet
+	long Cycles[256];                        /// Game cycle of the packet of each slot
+	std::vector<unsigned char> Packets[256]; /// Last packet of each slot
+	unsigned int Waiting[256];               /// Players waiting for the packet of a slot
+};
+
+static CUDPSocket RelayFildes;              /// Socket of the relay
+static CRelayPlayer RelayPlayers[PlayerMax];
+static long NewestCycle;                    /// Newest game cycle of the relayed packets
+static bool GameRunning;                    /// Packets have been received since the last game
+static time_t GameStart;                    /// Time of the first packet
+static std::string LogDir;                  /// Directory of the game logs, empty for none
+static FILE *LogFile;                       /// Log of the running game
+static int Timeout = 60;                    /// Seconds without packets until the game ends
+
+static unsigned long ReceivedPackets;
+static unsigned long ReceivedBytes;
+static unsigned long SentPackets;
+static unsigned long SentBytes;
+static unsigned long AnsweredResends;
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+			"Usage: %s [-p port] [-l logdir] [-t timeout]\n"
+			"\t-p port\t\tPort to listen to (default %d)\n"
+			"\t-l logdir\tWrite the packets of each game to a log in logdir\n"
+			"\t-t timeout\tSeconds without packets until a game ends (default 60)\n",
+			name, CNetworkParameter::defaultRelayPort);
+	exit(2);
+}
+
+/**
+**  Get the game cycle of a cycle slot, the slot is the lowest byte.
+*/
+static long UnwrapCycle(int slot)
+{
+	long cycle = ((NewestCycle + 128) & ~0xFF) | slot;
+	if (cycle > NewestCycle + 128) {
+		cycle -= 0x100;
+	}
+	return cycle;
+}
+
+static int FindPlayer(const CHost &host)
+{
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (RelayPlayers[i].Host == host) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void SendToPlayer(int player, const std::vector<unsigned char> &packet)
+{
+	RelayFildes.Send(RelayPlayers[player].Host, &packet[0], packet.size());
+	++SentPackets;
+	SentBytes += packet.size();
+}
+
+static void WriteLog(unsigned long value, int bytes)
+{
+	while (bytes--) {
+		fputc((value >> (8 * bytes)) & 0xFF, LogFile);
+	}
+}
+
+static void LogPacket(long cycle, int player, const std::vector<unsigned char> &packet)
+{
+	if (!LogFile) {
+		return;
+	}
+	WriteLog(cycle, 4);
+	WriteLog(player, 1);
+	WriteLog(packet.size(), 2);
+	fwrite(&packet[0], 1, packet.size(), LogFile);
+}
+
+static void StartGame()
+{
+	GameRunning = true;
+	GameStart = time(NULL);
+	NewestCycle = 0;
+	ReceivedPackets = ReceivedBytes = SentPackets = SentBytes = AnsweredResends = 0;
+	if (LogDir.empty()) {
+		printf("Game started\n");
+		return;
+	}
+	char name[32];
+	strftime(name, sizeof(name), "relay-%Y%m%d-%H%M%S.log", localtime(&GameStart));
+	const std::string file = LogDir + "/" + name;
+	LogFile = fopen(file.c_str(), "wb");
+	if (!LogFile) {
+		perror(file.c_str());
+	} else {
+		fputs("SRL1", LogFile);
+	}
+	printf("Game started, log %s\n", file.c_str());
+}
+
+/**
+**  End the game if no player sent anything for the timeout.
+*/
+static void CheckEndOfGame()
+{
+	if (!GameRunning) {
+		return;
+	}
+	const time_t now = time(NULL);
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (RelayPlayers[i].Host.isValid() && now - RelayPlayers[i].LastReceived < Timeout) {
+			return;
+		}
+	}
+	printf("Game ended after %ld cycles: %lu packets (%lu bytes) received,"
+		   " %lu packets (%lu bytes) sent, %lu resend requests answered\n",
+		   NewestCycle, ReceivedPackets, ReceivedBytes, SentPackets, SentBytes, AnsweredResends);
+#ifdef DEBUG
+	const CUDPSocket::CStatistic &statistic = RelayFildes.getStatistic();
+	printf("System calls: %u to send, %u to receive, %u to wait\n",
+		   statistic.sendCallsCount, statistic.receiveCallsCount, statistic.selectCallsCount);
+	RelayFildes.clearStatistic();
+#endif
+	fflush(stdout);
+	if (LogFile) {
+		fclose(LogFile);
+		LogFile = NULL;
+	}
+	for (int i = 0; i != PlayerMax; ++i) {
+		RelayPlayers[i].Clear();
+	}
+	GameRunning = false;
+}
+
+/**
+**  Forward the commands of a player to the other players.
+**
+**  A packet seen before is an answer to a resend request and only goes to
+**  the players waiting for it.
+*/
+static void ParseCommands(int player, std::vector<unsigned char> &packet)
+{
+	const int slot = packet[PacketCycleOffset];
+	const long cycle = UnwrapCycle(slot);
+	CRelayPlayer &from = RelayPlayers[player];
+
+	if (cycle < 0) {
+		return;
+	}
+	unsigned int receivers = from.Waiting[slot];
+	from.Waiting[slot] = 0;
+	if (from.Cycles[slot] != cycle || from.Packets[slot] != packet) {
+		from.Cycles[slot] = cycle;
+		from.Packets[slot].swap(packet);
+		NewestCycle = std::max(NewestCycle, cycle);
+		LogPacket(cycle, player, from.Packets[slot]);
+		receivers = ~0u;
+	}
+	std::vector<CHost> hosts;
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (i != player && RelayPlayers[i].Host.isValid() && (receivers & (1 << i))) {
+			hosts.push_back(RelayPlayers[i].Host);
+		}
+	}
+	RelayFildes.Send(hosts, &from.Packets[slot][0], from.Packets[slot].size());
+	SentPackets += hosts.size();
+	SentBytes += hosts.size() * from.Packets[slot].size();
+}
+
+/**
+**  Answer a resend request from the packets of the other players. Players
+**  whose packet is missing are asked to send it again.
+*/
+static void ParseResend(int player, const std::vector<unsigned char> &packet)
+{
+	const int slot = packet[PacketCycleOffset];
+	const long cycle = UnwrapCycle(slot);
+
+	for (int i = 0; i != PlayerMax; ++i) {
+		CRelayPlayer &from = RelayPlayers[i];
+
+		if (i == player || !from.Host.isValid()) {
+			continue;
+		}
+		if (from.Cycles[slot] == cycle) {
+			SendToPlayer(player, from.Packets[slot]);
+			++AnsweredResends;
+		} else {
+			from.Waiting[slot] |= 1 << player;
+			SendToPlayer(i, packet);
+		}
+	}
+}
+
+/**
+**  Receive and relay a packet.
+*/
+static void ParsePacket()
+{
+	unsigned char buf[MaxNetworkPacketSize];
+	CHost host;
+	const int len = RelayFildes.Recv(buf, sizeof(buf), &host);
+
+	if (len < int(CNetworkPacketHeader::Size())) {
+		return;
+	}
+	// The game setup is done with the host of the game.
+	if (buf[0] == MessageInit_FromClient || buf[0] == MessageInit_FromServer) {
+		return;
+	}
+	int player = buf[PacketOrigPlayerOffset];
+	if (player == 255) {
+		player = FindPlayer(host);
+	}
+	if (player < 0 || player >= PlayerMax) {
+		return;
+	}
+	CRelayPlayer &from = RelayPlayers[player];
+	if (from.Host != host) {
+		// The first packet binds the player to its address.
+		if (from.Host.isValid() || FindPlayer(host) != -1) {
+			const std::string hostStr = host.toString();
+			DebugPrint("Dropped packet for player %d from %s\n" _C_ player _C_ hostStr.c_str());
+			return;
+		}
+		if (!GameRunning) {
+			StartGame();
+		}
+		const std::string hostStr = host.toString();
+		printf("Player %d at %s\n", player, hostStr.c_str());
+		fflush(stdout);
+		from.Host = host;
+	}
+	from.LastReceived = time(NULL);
+	++ReceivedPackets;
+	ReceivedBytes += len;
+
+	std::vector<unsigned char> packet(buf, buf + len);
+	packet[PacketOrigPlayerOffset] = player;
+	if (buf[0] == MessageResend) {
+		ParseResend(player, packet);
+	} else {
+		ParseCommands(player, packet);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int port = CNetworkParameter::defaultRelayPort;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+			port = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+			LogDir = argv[++i];
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			Timeout = atoi(argv[++i]);
+		} else {
+			Usage(argv[0]);
+		}
+	}
+	if (port <= 0 || Timeout <= 0) {
+		Usage(argv[0]);
+	}
+
+	const char *addr = NULL; // any address
+	NetInit();
+	if (!RelayFildes.Open(CHost(addr, port))) {
+		fprintf(stderr, "%s: cannot open port %d\n", argv[0], port);
+		NetExit();
+		return 1;
+	}
+	printf("Relaying on port %d\n", port);
+	fflush(stdout);
+	for (;;) {
+		if (RelayFildes.HasDataToRead(1000) > 0) {
+			ParsePacket();
+		}
+		CheckEndOfGame();
+	}
+}
+
+//@}
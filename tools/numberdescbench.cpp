@@ -0,0 +1,172 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//   Utility for Stratagus - A free fantasy real time strategy game engine
+//
+/**@name numberdescbench.cpp - Measure the evaluation of number descriptions. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+   Evaluates damage formulas the way CalculateDamage does, once with the
+   number description as parsed ("tree") and once compiled by
+   CclParseNumberDesc ("compiled"), and prints the time needed per
+   evaluation.
+
+   Both evaluations start from the same SyncRand seed, they must give the
+   same damages and leave the same seed behind.
+
+   Built with ENABLE_BENCHMARKS, it is linked with the game sources.
+
+   Usage: numberdescbench [-n evaluations]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stratagus.h"
+#include "script.h"
+#include "trigger.h"
+#include "unit.h"
+#include "unittype.h"
+#include "util.h"
+
+/// Damage formulas, the first is the example of SetDamageFormula
+static const char *Formulas[] = {
+	"Div(Mul(Add(51, Rand(50)),"
+	" Add(Max(0, Sub(AttackerVar(\"BasicDamage\"), DefenderVar(\"Armor\"))),"
+	" AttackerVar(\"PiercingDamage\"))), 100)",
+
+	"NumIf(GreaterThan(AttackerVar(\"BasicDamage\"), DefenderVar(\"Armor\")),"
+	" Add(Sub(AttackerVar(\"BasicDamage\"), DefenderVar(\"Armor\")), Rand(Add(AttackerVar(\"PiercingDamage\"), 1))),"
+	" Add(1, Rand(2)))",
+
+	"Max(1, Sub(Add(Mul(2, AttackerVar(\"BasicDamage\")), AttackerVar(\"PiercingDamage\")),"
+	" Div(Mul(DefenderVar(\"Armor\"), Add(90, Rand(21))), 100)))",
+	NULL
+};
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+			"Usage: %s [-n evaluations]\n"
+			"\t-n evaluations\tNumber of evaluations of each formula (default 1000000)\n", name);
+	exit(2);
+}
+
+/**
+**  Parse a formula.
+**
+**  @param formula  Lua expression of the formula.
+**  @param compile  Compile it as CclParseNumberDesc does.
+*/
+static NumberDesc *ParseFormula(const char *formula, bool compile)
+{
+	const std::string chunk = std::string("return ") + formula;
+
+	if (luaL_loadstring(Lua, chunk.c_str()) || lua_pcall(Lua, 0, 1, 0)) {
+		fprintf(stderr, "%s\n", lua_tostring(Lua, -1));
+		exit(2);
+	}
+	return compile ? CclParseNumberDesc(Lua) : ParseNumberDesc(Lua);
+}
+
+/**
+**  Evaluate a formula many times with changing units.
+**
+**  @return  Sum of the damages.
+*/
+static long Run(const NumberDesc *formula, CUnit &attacker, CUnit &defender, int evaluations)
+{
+	long sum = 0;
+
+	InitSyncRand();
+	TriggerData.Attacker = &attacker;
+	TriggerData.Defender = &defender;
+	for (int i = 0; i != evaluations; ++i) {
+		attacker.Variable[BASICDAMAGE_INDEX].Value = 5 + i % 13;
+		defender.Variable[ARMOR_INDEX].Value = i % 11;
+		sum += EvalNumber(formula);
+	}
+	TriggerData.Attacker = NULL;
+	TriggerData.Defender = NULL;
+	return sum;
+}
+
+int main(int argc, char **argv)
+{
+	int evaluations = 1000000;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			evaluations = atoi(argv[++i]);
+		} else {
+			Usage(argv[0]);
+		}
+	}
+	if (evaluations < 1) {
+		Usage(argv[0]);
+	}
+
+	InitLua();
+	ScriptRegister();
+
+	CUnit attacker;
+	CUnit defender;
+	attacker.Variable = new CVariable[UnitTypeVar.GetNumberVariable()];
+	defender.Variable = new CVariable[UnitTypeVar.GetNumberVariable()];
+	attacker.Variable[PIERCINGDAMAGE_INDEX].Value = 6;
+
+	bool ok = true;
+	printf("%d evaluations\n", evaluations);
+	for (int i = 0; Formulas[i]; ++i) {
+		NumberDesc *tree = ParseFormula(Formulas[i], false);
+		NumberDesc *compiled = ParseFormula(Formulas[i], true);
+
+		clock_t start = clock();
+		const long treeSum = Run(tree, attacker, defender, evaluations);
+		const double treeSeconds = double(clock() - start) / CLOCKS_PER_SEC;
+		const unsigned treeSeed = SyncRandSeed;
+		start = clock();
+		const long compiledSum = Run(compiled, attacker, defender, evaluations);
+		const double compiledSeconds = double(clock() - start) / CLOCKS_PER_SEC;
+
+		if (treeSum != compiledSum || treeSeed != SyncRandSeed) {
+			fprintf(stderr, "formula %d: the compiled formula gives other damages\n", i + 1);
+			ok = false;
+		}
+		printf("formula %d: tree %6.1f ns, compiled %6.1f ns\n", i + 1,
+			   treeSeconds * 1e9 / evaluations, compiledSeconds * 1e9 / evaluations);
+
+		FreeNumberDesc(tree);
+		delete tree;
+		FreeNumberDesc(compiled);
+		delete compiled;
+	}
+	delete[] attacker.Variable;
+	delete[] defender.Variable;
+	lua_close(Lua);
+	return ok ? 0 : 1;
+}
+
+//@}
@@ -0,0 +1,338 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//   Utility for Stratagus - A free fantasy real time strategy game engine
+//
+/**@name replaycheck.cpp - Verify replays against reference SyncHash traces. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+   Runs each replay with "stratagus -R replay", several at once, and
+   compares the printed SyncHash trace with the reference trace stored
+   next to the replay as replay.trace. A missing reference trace is
+   created from the run.
+
+   Usage: replaycheck [-j jobs] [-e stratagus] [-u] replay... [-- options]
+
+   Options after "--" are passed to stratagus, e.g. "-d datapath".
+*/
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+/// SyncHash of a cycle
+struct TracePoint {
+	unsigned long Cycle;
+	unsigned long Hash;
+};
+
+/// A replay to verify
+struct ReplayRun {
+	ReplayRun() : Pid(-1), Fd(-1), Ended(false), EndCycle(0), EndHash(0), Ticks(0), Status(0) {}
+
+	std::string File;               /// Replay file name
+	pid_t Pid;                      /// Process running the replay
+	int Fd;                         /// Output of the process
+	std::string Output;             /// Not yet parsed output
+	std::vector<TracePoint> Trace;  /// SyncHash trace of the run
+	bool Ended;                     /// The end of the replay was reached
+	unsigned long EndCycle;         /// Last cycle of the replay
+	unsigned long EndHash;          /// SyncHash at the end
+	unsigned long Ticks;            /// Time in ms the engine needed
+	int Status;                     /// Exit status of the process
+};
+
+static std::string Engine = "stratagus";    /// Engine to run
+static std::vector<std::string> EngineArgs; /// Extra engine options
+static bool UpdateTraces;                   /// Overwrite reference traces
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+			"Usage: %s [-j jobs] [-e stratagus] [-u] replay... [-- options]\n"
+			"\t-j jobs\t\tNumber of replays to run at once (default 4)\n"
+			"\t-e stratagus\tEngine to run (default stratagus)\n"
+			"\t-u\t\tReplace the reference traces with the new ones\n"
+			"\toptions\t\tPassed to the engine\n", name);
+	exit(2);
+}
+
+/**
+**  Start the engine for a replay.
+*/
+static bool StartRun(ReplayRun &run)
+{
+	int fds[2];
+
+	if (pipe(fds) == -1) {
+		perror("pipe");
+		return false;
+	}
+	run.Pid = fork();
+	if (run.Pid == -1) {
+		perror("fork");
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (run.Pid == 0) {
+		std::vector<char *> argv;
+
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		argv.push_back(const_cast<char *>(Engine.c_str()));
+		for (size_t i = 0; i != EngineArgs.size(); ++i) {
+			argv.push_back(const_cast<char *>(EngineArgs[i].c_str()));
+		}
+		argv.push_back(const_cast<char *>("-R"));
+		argv.push_back(const_cast<char *>(run.File.c_str()));
+		argv.push_back(NULL);
+		execvp(argv[0], &argv[0]);
+		perror(argv[0]);
+		_exit(127);
+	}
+	close(fds[1]);
+	run.Fd = fds[0];
+	return true;
+}
+
+/**
+**  Parse the complete lines of the engine output.
+*/
+static void ParseOutput(ReplayRun &run)
+{
+	size_t pos;
+
+	while ((pos = run.Output.find('\n')) != std::string::npos) {
+		const std::string line = run.Output.substr(0, pos);
+		TracePoint point;
+
+		run.Output.erase(0, pos + 1);
+		if (sscanf(line.c_str(), "replay-trace %lu %lx", &point.Cycle, &point.Hash) == 2) {
+			run.Trace.push_back(point);
+		} else if (sscanf(line.c_str(), "replay-end %lu %lx %lu", &run.EndCycle, &run.EndHash, &run.Ticks) == 3) {
+			run.Ended = true;
+		}
+	}
+}
+
+/**
+**  Read the available output of the engine.
+**
+**  @return  false at the end of the output.
+*/
+static bool ReadOutput(ReplayRun &run)
+{
+	char buf[4096];
+	const ssize_t n = read(run.Fd, buf, sizeof(buf));
+
+	if (n < 0 && errno == EINTR) {
+		return true;
+	}
+	if (n <= 0) {
+		close(run.Fd);
+		run.Fd = -1;
+		waitpid(run.Pid, &run.Status, 0);
+		return false;
+	}
+	run.Output.append(buf, n);
+	ParseOutput(run);
+	return true;
+}
+
+static std::string TraceFileName(const ReplayRun &run)
+{
+	return run.File + ".trace";
+}
+
+static bool LoadTrace(const std::string &name, std::vector<TracePoint> &trace)
+{
+	FILE *f = fopen(name.c_str(), "r");
+	TracePoint point;
+
+	if (!f) {
+		return false;
+	}
+	while (fscanf(f, "%lu %lx", &point.Cycle, &point.Hash) == 2) {
+		trace.push_back(point);
+	}
+	fclose(f);
+	return true;
+}
+
+static bool SaveTrace(const std::string &name, const ReplayRun &run)
+{
+	FILE *f = fopen(name.c_str(), "w");
+
+	if (!f) {
+		perror(name.c_str());
+		return false;
+	}
+	for (size_t i = 0; i != run.Trace.size(); ++i) {
+		fprintf(f, "%lu %08lx\n", run.Trace[i].Cycle, run.Trace[i].Hash);
+	}
+	fprintf(f, "%lu %08lx\n", run.EndCycle, run.EndHash);
+	fclose(f);
+	return true;
+}
+
+/**
+**  Compare a finished run with its reference trace and print the result.
+**
+**  @return  true if the replay is fine.
+*/
+static bool ReportRun(ReplayRun &run)
+{
+	const double seconds = run.Ticks / 1000.0;
+	const double speed = seconds > 0 ? run.EndCycle / seconds : 0;
+
+	if (!run.Ended) {
+		printf("FAILED   %s: no end of replay (exit status %d)\n", run.File.c_str(),
+			   WIFEXITED(run.Status) ? WEXITSTATUS(run.Status) : -1);
+		return false;
+	}
+	std::vector<TracePoint> reference;
+	if (UpdateTraces || !LoadTrace(TraceFileName(run), reference)) {
+		if (!SaveTrace(TraceFileName(run), run)) {
+			return false;
+		}
+		printf("NEW      %s: %lu cycles, %.0f cycles/s\n", run.File.c_str(), run.EndCycle, speed);
+		return true;
+	}
+	TracePoint end = { run.EndCycle, run.EndHash };
+	run.Trace.push_back(end);
+	for (size_t i = 0; i != run.Trace.size(); ++i) {
+		if (i == reference.size() || run.Trace[i].Cycle != reference[i].Cycle
+			|| run.Trace[i].Hash != reference[i].Hash) {
+			const unsigned long last = i ? run.Trace[i - 1].Cycle : 0;
+
+			if (i == reference.size()) {
+				printf("DIVERGED %s: replay runs longer than the reference after cycle %lu\n",
+					   run.File.c_str(), last);
+			} else {
+				printf("DIVERGED %s: between cycle %lu and %lu, SyncHash %08lx != %08lx\n",
+					   run.File.c_str(), last, run.Trace[i].Cycle, run.Trace[i].Hash, reference[i].Hash);
+			}
+			return false;
+		}
+	}
+	if (reference.size() != run.Trace.size()) {
+		printf("DIVERGED %s: replay ends at cycle %lu before the reference\n", run.File.c_str(), run.EndCycle);
+		return false;
+	}
+	printf("OK       %s: %lu cycles, %.0f cycles/s\n", run.File.c_str(), run.EndCycle, speed);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<ReplayRun> runs;
+	size_t jobs = 4;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--")) {
+			EngineArgs.assign(argv + i + 1, argv + argc);
+			break;
+		} else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			jobs = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+			Engine = argv[++i];
+		} else if (!strcmp(argv[i], "-u")) {
+			UpdateTraces = true;
+		} else if (argv[i][0] == '-') {
+			Usage(argv[0]);
+		} else {
+			runs.push_back(ReplayRun());
+			runs.back().File = argv[i];
+		}
+	}
+	if (runs.empty() || jobs < 1) {
+		Usage(argv[0]);
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	size_t next = 0;
+	size_t running = 0;
+	int failed = 0;
+
+	while (next != runs.size() || running) {
+		while (next != runs.size() && running < jobs) {
+			if (StartRun(runs[next])) {
+				++running;
+			} else {
+				++failed;
+			}
+			++next;
+		}
+		std::vector<pollfd> fds;
+		std::vector<size_t> indexes;
+		for (size_t i = 0; i != next; ++i) {
+			if (runs[i].Fd != -1) {
+				pollfd fd = { runs[i].Fd, POLLIN, 0 };
+				fds.push_back(fd);
+				indexes.push_back(i);
+			}
+		}
+		if (fds.empty()) {
+			continue;
+		}
+		if (poll(&fds[0], fds.size(), -1) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("poll");
+			return 2;
+		}
+		for (size_t i = 0; i != fds.size(); ++i) {
+			if (fds[i].revents && !ReadOutput(runs[indexes[i]])) {
+				--running;
+				if (!ReportRun(runs[indexes[i]])) {
+					++failed;
+				}
+				fflush(stdout);
+			}
+		}
+	}
+
+	unsigned long cycles = 0;
+	unsigned long ticks = 0;
+	for (size_t i = 0; i != runs.size(); ++i) {
+		cycles += runs[i].EndCycle;
+		ticks += runs[i].Ticks;
+	}
+	printf("%d of %d replays failed, %lu cycles, %.0f cycles/s per replay\n",
+		   failed, (int)runs.size(), cycles, ticks ? cycles * 1000.0 / ticks : 0.0);
+	return failed ? 1 : 0;
+}
+
+//@}
@@ -0,0 +1,292 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//   Utility for Stratagus - A free fantasy real time strategy game engine
+//
+/**@name triggerbench.cpp - Measure the triggers of a trigger heavy map. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+   Runs the triggers of a synthetic campaign map while its units walk
+   around, and prints the time needed per game cycle, the Lua conditions
+   called per game cycle and how many times the actions ran.
+
+   The map has the usual campaign conditions: units at a location, unit
+   counts of a player and units near a building. They are added three
+   times, as Lua functions checked in turn, as Lua functions scheduled by
+   their dependencies and as native conditions. Each run walks the same
+   units from the same SyncRand seed.
+
+   Built with ENABLE_BENCHMARKS, it is linked with the game sources.
+
+   Usage: triggerbench [-c cycles] [-t triggers] [-u units] [-m moves]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "stratagus.h"
+#include "interface.h"
+#include "map.h"
+#include "player.h"
+#include "script.h"
+#include "trigger.h"
+#include "unit.h"
+#include "unit_manager.h"
+#include "unittype.h"
+
+static const int MapSize = 128;
+
+/// Forms of the trigger conditions
+enum TriggerForm {
+	FormLua,        /// Lua functions checked in turn
+	FormScheduled,  /// Lua functions scheduled by their dependencies
+	FormNative,     /// Native conditions
+	FormCount
+};
+
+static const char *FormNames[FormCount] = {
+	"lua", "scheduled", "native"
+};
+
+static CUnitType *Footman;
+static CUnitType *Farm;
+static std::vector<CUnit *> Units;
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+			"Usage: %s [-c cycles] [-t triggers] [-u units] [-m moves]\n"
+			"\t-c cycles\tNumber of game cycles of each run (default 2000)\n"
+			"\t-t triggers\tNumber of triggers of the map (default 200)\n"
+			"\t-u units\tNumber of footmen walking on the map (default 300)\n"
+			"\t-m moves\tFootmen moving one tile each game cycle (default 10)\n", name);
+	exit(2);
+}
+
+/**
+**  Insert the unit into the map as CUnit::Place does, without the vision.
+*/
+static void PlaceUnit(CUnit &unit, const Vec2i &pos)
+{
+	unit.Removed = 0;
+	unit.tilePos = pos;
+	unit.Offset = Map.getIndex(pos);
+	Map.Insert(unit);
+}
+
+/**
+**  Make the map, the farms of the two players and the footmen.
+*/
+static void MakeMap(int units)
+{
+	UnitTypeVar.Init();
+	Footman = NewUnitTypeSlot("unit-bench-footman");
+	Footman->TileWidth = 1;
+	Footman->TileHeight = 1;
+	Farm = NewUnitTypeSlot("unit-bench-farm");
+	Farm->TileWidth = 2;
+	Farm->TileHeight = 2;
+	Farm->Building = 1;
+	UpdateStats(1);
+
+	Map.Info.MapWidth = MapSize;
+	Map.Info.MapHeight = MapSize;
+	Map.Create();
+	NumPlayers = 2;
+	for (int i = 0; i != PlayerMax; ++i) {
+		Players[i].Index = i;
+	}
+	ThisPlayer = &Players[0];
+
+	InitSyncRand();
+	for (int i = 0; i != 32; ++i) {
+		CUnit &farm = *MakeUnit(*Farm, &Players[i & 1]);
+		PlaceUnit(farm, Vec2i(SyncRand() % (MapSize - 1), SyncRand() % (MapSize - 1)));
+	}
+	for (int i = 0; i != units; ++i) {
+		CUnit &footman = *MakeUnit(*Footman, &Players[i & 1]);
+		PlaceUnit(footman, Vec2i(SyncRand() % MapSize, SyncRand() % MapSize));
+		Units.push_back(&footman);
+	}
+}
+
+/**
+**  Add the triggers of the map.
+**
+**  @param form      Form of the conditions.
+**  @param triggers  Number of triggers.
+*/
+static void AddTriggers(TriggerForm form, int triggers)
+{
+	std::string chunk;
+	char line[512];
+
+	for (int i = 0; i != triggers; ++i) {
+		const int player = i & 1;
+		const int x = (i * 37) % (MapSize - 8);
+		const int y = (i * 53) % (MapSize - 8);
+		const char *lua;
+		const char *native;
+
+		switch (i % 3) {
+			case 0:
+				lua = "GetNumUnitsAt(%d, 'unit-bench-footman', {%d, %d}, {%d, %d}) >= 2";
+				native = "{'units-at', %d, 'unit-bench-footman', {%d, %d}, {%d, %d}, '>=', 2}";
+				snprintf(line, sizeof(line), form == FormNative ? native : lua, player, x, y, x + 7, y + 7);
+				break;
+			case 1:
+				lua = "IfNearUnit(%d, '>=', 2, 'unit-bench-footman', 'unit-bench-farm')";
+				native = "{'near-unit', %d, '>=', 2, 'unit-bench-footman', 'unit-bench-farm'}";
+				snprintf(line, sizeof(line), form == FormNative ? native : lua, player);
+				break;
+			default:
+				lua = "GetPlayerData(%d, 'UnitTypesCount', 'unit-bench-footman') > %d";
+				native = "{'unit-types-count', %d, 'unit-bench-footman', '>', %d}";
+				snprintf(line, sizeof(line), form == FormNative ? native : lua, player, i % 200);
+				break;
+		}
+		chunk += "AddTrigger(";
+		if (form == FormNative) {
+			chunk += line;
+		} else {
+			chunk += std::string("function() checks = checks + 1 return ") + line + " end";
+		}
+		chunk += ", function() fired = fired + 1 return true end";
+		chunk += form == FormScheduled ? ", {'units', 'map'})\n" : ")\n";
+	}
+	if (luaL_dostring(Lua, chunk.c_str())) {
+		fprintf(stderr, "%s\n", lua_tostring(Lua, -1));
+		exit(2);
+	}
+}
+
+/**
+**  Move some footmen one tile, and give one to the other player from
+**  time to time.
+*/
+static void MoveUnits(int moves)
+{
+	for (int i = 0; i != moves; ++i) {
+		CUnit &unit = *Units[SyncRand() % Units.size()];
+		Vec2i pos(unit.tilePos.x + SyncRand() % 3 - 1, unit.tilePos.y + SyncRand() % 3 - 1);
+
+		if (pos.x < 0 || pos.y < 0 || pos.x >= MapSize || pos.y >= MapSize) {
+			continue;
+		}
+		Map.Remove(unit);
+		PlaceUnit(unit, pos);
+	}
+	if (GameCycle % 50 == 0) {
+		CUnit &unit = *Units[SyncRand() % Units.size()];
+		unit.ChangeOwner(Players[unit.Player->Index ^ 1]);
+	}
+}
+
+/**
+**  Get a number global of the Lua state.
+*/
+static int GetGlobal(const char *name)
+{
+	lua_getglobal(Lua, name);
+	const int value = lua_tonumber(Lua, -1);
+	lua_pop(Lua, 1);
+	return value;
+}
+
+int main(int argc, char **argv)
+{
+	int cycles = 2000;
+	int triggers = 200;
+	int units = 300;
+	int moves = 10;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+			cycles = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			triggers = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-u") && i + 1 < argc) {
+			units = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			moves = atoi(argv[++i]);
+		} else {
+			Usage(argv[0]);
+		}
+	}
+	if (cycles < 1 || triggers < 1 || units < 2 || moves < 0) {
+		Usage(argv[0]);
+	}
+
+	InitLua();
+	PlayerCclRegister();
+	TriggerCclRegister();
+	MakeMap(units);
+
+	// Each run starts from the same units.
+	std::vector<Vec2i> positions;
+	std::vector<int> owners;
+	for (size_t i = 0; i != Units.size(); ++i) {
+		positions.push_back(Units[i]->tilePos);
+		owners.push_back(Units[i]->Player->Index);
+	}
+
+	printf("%d cycles, %d triggers, %d units, %d moves per cycle\n", cycles, triggers, units, moves);
+	for (int form = 0; form != FormCount; ++form) {
+		luaL_dostring(Lua, "checks = 0 fired = 0");
+		GameCycle = 0;
+		AddTriggers(TriggerForm(form), triggers);
+
+		InitSyncRand();
+		const clock_t start = clock();
+		for (int i = 0; i != cycles; ++i) {
+			++GameCycle;
+			MoveUnits(moves);
+			TriggersEachCycle();
+		}
+		const double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+
+		printf("%-9s %8.1f us per cycle, %7.2f Lua conditions per cycle, %7d actions\n",
+			   FormNames[form], seconds * 1e6 / cycles, double(GetGlobal("checks")) / cycles,
+			   GetGlobal("fired"));
+
+		CleanTriggers();
+		for (size_t i = 0; i != Units.size(); ++i) {
+			CUnit &unit = *Units[i];
+
+			Map.Remove(unit);
+			PlaceUnit(unit, positions[i]);
+			if (unit.Player->Index != owners[i]) {
+				unit.ChangeOwner(Players[owners[i]]);
+			}
+		}
+	}
+	lua_close(Lua);
+	return 0;
+}
+
+//@}